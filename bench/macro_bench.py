@@ -0,0 +1,248 @@
+#! /usr/bin/env python3
+"""
+End-to-end benchmarks of whole simulations.
+
+Runs every model in tests/models/*.yml with the `pinetree` command line
+runner, and the T7 infection model from examples/phage_model.py through the
+Python module, each at a fixed seed. For every model it reports events per
+second, wall time, peak resident set size, the largest number of transcripts
+tracked at once and the size of the output file, and compares the results
+with a stored baseline.
+
+Timing metrics are compared with a threshold that grows with the run-to-run
+noise of both the baseline and the current measurement. Event counts,
+transcript high-water marks and output sizes are deterministic for a fixed
+seed and must match exactly; a difference means that the simulation itself
+behaves differently.
+
+Usage:
+
+    python3 bench/macro_bench.py --build-dir build
+    python3 bench/macro_bench.py --build-dir build --update-baseline
+
+Build in Release mode for meaningful numbers. Baselines are specific to the
+machine they were recorded on.
+"""
+
+import argparse
+import glob
+import json
+import math
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_BASELINE = os.path.join(ROOT, "bench", "macro_baseline.json")
+SEED = 34
+
+# Deterministic for a fixed seed
+EXACT_METRICS = ["events", "peak_transcripts", "output_bytes"]
+# Noisy; +1 if larger values are worse, -1 if smaller values are worse
+TIMED_METRICS = {"wall_time": 1, "peak_rss_kb": 1, "events_per_second": -1}
+# Timing differences smaller than this (in seconds) are never reported
+MIN_TIME_DELTA = 0.02
+
+
+def run_child(cmd):
+    """Run a command and return its peak RSS in kilobytes."""
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE)
+    stderr = proc.stderr.read()
+    _, status, usage = os.wait4(proc.pid, 0)
+    # The child has been reaped, so Popen must not wait for it again
+    proc.returncode = status
+    if status != 0:
+        raise RuntimeError("{} failed:\n{}".format(
+            " ".join(cmd), stderr.decode(errors="replace")))
+    # ru_maxrss is in kilobytes on Linux and in bytes on macOS
+    if platform.system() == "Darwin":
+        return usage.ru_maxrss // 1024
+    return usage.ru_maxrss
+
+
+def run_model_file(binary, model, tmpdir):
+    output = os.path.join(tmpdir, "counts.tsv")
+    stats = os.path.join(tmpdir, "stats.json")
+    rss = run_child([binary, model, "--seed", str(SEED), "--output", output,
+                     "--stats", stats])
+    with open(stats) as f:
+        result = json.load(f)
+    result["peak_rss_kb"] = rss
+    return result
+
+
+def run_phage(runtime, tmpdir):
+    output = os.path.join(tmpdir, "counts.tsv")
+    stats = os.path.join(tmpdir, "stats.json")
+    rss = run_child([sys.executable, os.path.abspath(__file__),
+                     "--phage-child", output, stats,
+                     "--phage-time", str(runtime)])
+    with open(stats) as f:
+        result = json.load(f)
+    result["peak_rss_kb"] = rss
+    return result
+
+
+def phage_child(output, stats_path, runtime):
+    """Simulate the T7 model in this process and write run statistics."""
+    sys.path.insert(0, os.path.join(ROOT, "examples"))
+    import phage_model
+    sim = phage_model.build_model(seed=SEED)
+    start = time.perf_counter()
+    sim.simulate(time_limit=runtime, time_step=5, output=output)
+    wall_time = time.perf_counter() - start
+    stats = sim.stats()
+    with open(stats_path, "w") as f:
+        json.dump({"model": "phage_model.py", "seed": SEED,
+                   "events": stats.events, "wall_time": wall_time,
+                   "events_per_second": stats.events / wall_time,
+                   "peak_transcripts": stats.peak_transcripts,
+                   "output_bytes": os.path.getsize(output)}, f)
+
+
+def summarize(runs):
+    """Median and relative noise (scaled MAD) of each metric."""
+    summary = {}
+    for metric in EXACT_METRICS:
+        summary[metric] = runs[0][metric]
+    for metric in TIMED_METRICS:
+        values = [run[metric] for run in runs]
+        median = statistics.median(values)
+        mad = statistics.median([abs(v - median) for v in values])
+        summary[metric] = median
+        summary[metric + "_noise"] = 1.4826 * mad / median if median else 0.0
+    return summary
+
+
+def compare(name, current, baseline, tolerance):
+    """Return a list of (status, message) for one benchmark."""
+    findings = []
+    for metric in EXACT_METRICS:
+        if current[metric] != baseline[metric]:
+            findings.append(("CHANGED", "{}: {} (baseline {})".format(
+                metric, current[metric], baseline[metric])))
+    for metric, direction in TIMED_METRICS.items():
+        base = baseline[metric]
+        if base == 0:
+            continue
+        noise = math.sqrt(baseline.get(metric + "_noise", 0) ** 2 +
+                          current[metric + "_noise"] ** 2)
+        threshold = max(tolerance, 3 * noise)
+        if metric != "peak_rss_kb":
+            # Very short runs are dominated by process start-up jitter
+            threshold = max(threshold, MIN_TIME_DELTA / baseline["wall_time"])
+        change = direction * (current[metric] - base) / base
+        if change > threshold:
+            status = "REGRESSION"
+        elif change < -threshold:
+            status = "improved"
+        else:
+            continue
+        findings.append((status, "{}: {:.4g} (baseline {:.4g}, {:+.1%}, "
+                         "threshold {:.1%})".format(
+                             metric, current[metric], base,
+                             (current[metric] - base) / base, threshold)))
+    return findings
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Run end-to-end pinetree benchmarks.")
+    parser.add_argument("--build-dir", default="build",
+                        help="CMake build directory containing `pinetree`")
+    parser.add_argument("--repetitions", type=int, default=5)
+    parser.add_argument("--filter", default="",
+                        help="only run models whose name contains this text")
+    parser.add_argument("--skip-phage", action="store_true",
+                        help="do not run the T7 model")
+    parser.add_argument("--phage-time", type=int, default=500,
+                        help="simulated seconds of T7 infection (default: 500)")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE)
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="store these results as the new baseline")
+    parser.add_argument("--tolerance", type=float, default=0.15,
+                        help="minimum relative change reported "
+                        "(default: 0.15)")
+    parser.add_argument("--allow-changes", action="store_true",
+                        help="do not fail when deterministic metrics change")
+    parser.add_argument("--output", help="also write results to this file")
+    parser.add_argument("--phage-child", nargs=2, help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.phage_child:
+        phage_child(args.phage_child[0], args.phage_child[1], args.phage_time)
+        return 0
+
+    binary = os.path.join(args.build_dir, "pinetree")
+    benchmarks = []
+    for model in sorted(glob.glob(os.path.join(ROOT, "tests", "models",
+                                               "*.yml"))):
+        name = os.path.splitext(os.path.basename(model))[0]
+        benchmarks.append((name, lambda tmp, m=model:
+                           run_model_file(binary, m, tmp)))
+    if not args.skip_phage:
+        benchmarks.append(("phage", lambda tmp: run_phage(args.phage_time,
+                                                          tmp)))
+
+    results = {}
+    with tempfile.TemporaryDirectory() as tmpdir:
+        for name, run in benchmarks:
+            if args.filter not in name:
+                continue
+            runs = [run(tmpdir) for _ in range(args.repetitions)]
+            results[name] = summarize(runs)
+            print("{:<28} {:>10} events {:>8.3f} s {:>12.0f} events/s "
+                  "{:>8} KB {:>6} transcripts".format(
+                      name, results[name]["events"],
+                      results[name]["wall_time"],
+                      results[name]["events_per_second"],
+                      results[name]["peak_rss_kb"],
+                      results[name]["peak_transcripts"]))
+
+    report = {"seed": SEED, "phage_time": args.phage_time,
+              "machine": platform.node(), "benchmarks": results}
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+    if args.update_baseline:
+        with open(args.baseline, "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("\nBaseline written to {}".format(args.baseline))
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print("\nNo baseline at {}; run with --update-baseline to create "
+              "one.".format(args.baseline))
+        return 0
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    if baseline.get("phage_time") != args.phage_time:
+        print("\nWarning: baseline used --phage-time {}".format(
+            baseline.get("phage_time")))
+
+    failed = False
+    print("\nComparison with {}:".format(args.baseline))
+    for name, current in results.items():
+        if name not in baseline["benchmarks"]:
+            print("  {}: not in baseline".format(name))
+            continue
+        for status, message in compare(name, current,
+                                       baseline["benchmarks"][name],
+                                       args.tolerance):
+            print("  {:<10} {}: {}".format(status, name, message))
+            if status == "REGRESSION" or (status == "CHANGED" and
+                                          not args.allow_changes):
+                failed = True
+    if not failed:
+        print("  no regressions")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,474 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+/**
+ * Microbenchmarks for the core data structures and algorithms of pinetree.
+ * Each benchmark is run several times and the per-operation time of every
+ * run is reported as JSON, so that results can be stored and compared across
+ * commits.
+ *
+ * Usage: pinetree_bench [--filter TEXT] [--repetitions N] [--min-time SEC]
+ *                       [--output PATH]
+ *
+ * Build in Release mode (-DCMAKE_BUILD_TYPE=Release) for meaningful numbers.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "IntervalTree.h"
+#include "choices.hpp"
+#include "model.hpp"
+#include "polymer.hpp"
+#include "tracker.hpp"
+
+namespace {
+
+/**
+ * Stopwatch handed to each benchmark body so that setup work can be excluded
+ * from the measurement.
+ */
+class Timer {
+ public:
+  void Start() { start_ = std::chrono::steady_clock::now(); }
+  void Stop() {
+    elapsed_ += std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start_)
+                    .count();
+  }
+  double elapsed() const { return elapsed_; }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+  double elapsed_ = 0;
+};
+
+/**
+ * A benchmark body performs `ops` operations and times them with `timer`.
+ */
+typedef std::function<void(int ops, Timer &timer)> Body;
+
+struct Benchmark {
+  std::string name;
+  int param;
+  Body body;
+};
+
+struct Result {
+  std::string name;
+  int param;
+  long ops;
+  std::vector<double> ns_per_op;
+};
+
+// Prevent the compiler from optimizing away a computed value
+#if defined(__GNUC__)
+template <typename T>
+void DoNotOptimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+#else
+// Compilers without GNU inline assembly: read the value through a volatile
+// reference, which the optimizer cannot drop
+volatile char do_not_optimize_sink;
+template <typename T>
+void DoNotOptimize(const T &value) {
+  do_not_optimize_sink = *reinterpret_cast<const volatile char *>(&value);
+}
+#endif
+
+Result Run(const Benchmark &bench, int repetitions, double min_time) {
+  // Find an operation count that takes at least min_time
+  int ops = 1;
+  while (true) {
+    Timer timer;
+    bench.body(ops, timer);
+    if (timer.elapsed() >= min_time || ops >= (1 << 26)) {
+      break;
+    }
+    double scale = (timer.elapsed() > 0) ? 1.4 * min_time / timer.elapsed()
+                                         : 10.0;
+    ops = std::max(ops + 1, int(ops * std::min(scale, 10.0)));
+  }
+  Result result{bench.name, bench.param, ops, {}};
+  for (int i = 0; i < repetitions; i++) {
+    Timer timer;
+    bench.body(ops, timer);
+    result.ns_per_op.push_back(timer.elapsed() * 1e9 / ops);
+  }
+  return result;
+}
+
+double Median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t mid = values.size() / 2;
+  return (values.size() % 2 == 1) ? values[mid]
+                                  : 0.5 * (values[mid - 1] + values[mid]);
+}
+
+std::string ToJson(const std::vector<Result> &results, int repetitions) {
+  std::ostringstream out;
+  std::time_t now = std::time(nullptr);
+  char date[32];
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+  out << "{\n  \"context\": {\n";
+  out << "    \"date\": \"" << date << "\",\n";
+#ifdef __VERSION__
+  out << "    \"compiler\": \"" << __VERSION__ << "\",\n";
+#endif
+#ifdef NDEBUG
+  out << "    \"assertions\": false,\n";
+#else
+  out << "    \"assertions\": true,\n";
+#endif
+  out << "    \"repetitions\": " << repetitions << "\n  },\n";
+  out << "  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &r = results[i];
+    auto minmax = std::minmax_element(r.ns_per_op.begin(), r.ns_per_op.end());
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"name\": \"" << r.name << "\", \"param\": " << r.param
+        << ", \"ops\": " << r.ops
+        << ", \"median_ns\": " << Median(r.ns_per_op)
+        << ", \"min_ns\": " << *minmax.first
+        << ", \"max_ns\": " << *minmax.second << ", \"runs_ns\": [";
+    for (size_t j = 0; j < r.ns_per_op.size(); j++) {
+      out << (j == 0 ? "" : ", ") << r.ns_per_op[j];
+    }
+    out << "]}";
+  }
+  out << "\n  ]\n}\n";
+  return out.str();
+}
+
+/**
+ * Gillespie::Iterate with `num_species` reversible isomerizations A_i <-> B_i,
+ * i.e. 2 * num_species reactions.
+ */
+Body GillespieIterate(int num_species) {
+  return [num_species](int ops, Timer &timer) {
+    auto model = std::make_shared<Model>(8e-16);
+    Random::seed(34);
+    for (int i = 0; i < num_species; i++) {
+      auto a = "A" + std::to_string(i);
+      auto b = "B" + std::to_string(i);
+      model->AddSpecies(a, 1000);
+      model->AddSpecies(b, 1000);
+      model->AddReaction(1.0, {a}, {b});
+      model->AddReaction(1.0, {b}, {a});
+    }
+    // An empty genome keeps Model from warning about a missing genome
+    model->RegisterGenome(std::make_shared<Genome>("empty", 10));
+    model->Step(1);
+    timer.Start();
+    model->Step(ops);
+    timer.Stop();
+  };
+}
+
+/**
+ * Polymer::Execute (MobileElementManager::Choose + Polymer::Move) on a long
+ * genome with one polymerase every `spacing` base pairs. Polymerases with a
+ * footprint of 10 on closely-spaced promoters mostly collide.
+ */
+Body PolymerMove(int spacing) {
+  return [spacing](int ops, Timer &timer) {
+    const int length = 200000;
+    auto model = std::make_shared<Model>(8e-16);
+    Random::seed(34);
+    auto genome = std::make_shared<Genome>("bench", length);
+    std::map<std::string, double> interactions = {{"rnapol", 1e7}};
+    int num_pols = std::min(500, (length / 2) / spacing);
+    for (int i = 0; i < num_pols; i++) {
+      int start = 1 + i * spacing;
+      genome->AddPromoter("p", start, start + 9, interactions);
+    }
+    model->AddPolymerase("rnapol", 10, 40, num_pols);
+    model->RegisterGenome(genome);
+    for (int i = 0; i < num_pols; i++) {
+      genome->Bind(std::make_shared<Polymerase>("rnapol", 10, 40), "p");
+    }
+    int done = 0;
+    while (done < ops) {
+      int batch = std::min(ops - done, 20000);
+      timer.Start();
+      for (int i = 0; i < batch; i++) {
+        genome->Execute();
+      }
+      timer.Stop();
+      done += batch;
+    }
+  };
+}
+
+/**
+ * MobileElementManager::Choose with `num_pols` mobile elements.
+ */
+Body ManagerChoose(int num_pols) {
+  return [num_pols](int ops, Timer &timer) {
+    Random::seed(34);
+    MobileElementManager manager(std::vector<double>(num_pols * 20 + 20, 1.0));
+    for (int i = 0; i < num_pols; i++) {
+      auto pol = std::make_shared<Polymerase>("rnapol", 10, 40);
+      pol->start(1 + i * 20);
+      pol->stop(10 + i * 20);
+      manager.Insert(pol, Polymer::Ptr());
+    }
+    long sum = 0;
+    timer.Start();
+    for (int i = 0; i < ops; i++) {
+      sum += manager.Choose();
+    }
+    timer.Stop();
+    DoNotOptimize(sum);
+  };
+}
+
+/**
+ * IntervalTree::findOverlapping for 10 bp windows in a tree of `num_sites`
+ * 10 bp intervals, as done for every polymerase move.
+ */
+Body IntervalQuery(int num_sites) {
+  return [num_sites](int ops, Timer &timer) {
+    std::vector<Interval<int>> intervals;
+    for (int i = 0; i < num_sites; i++) {
+      intervals.emplace_back(1 + i * 50, 10 + i * 50, i);
+    }
+    IntervalTree<int> tree(intervals);
+    std::vector<Interval<int>> results;
+    int span = num_sites * 50;
+    long found = 0;
+    timer.Start();
+    for (int i = 0; i < ops; i++) {
+      int start = 1 + (i * 7919) % span;
+      results.clear();
+      tree.findOverlapping(start, start + 10, results);
+      found += results.size();
+    }
+    timer.Stop();
+    DoNotOptimize(found);
+  };
+}
+
+/**
+ * Genome::Attach, which calls Genome::BuildTranscript, on a genome with
+ * `num_genes` genes. The genome is not registered with a Model, so the new
+ * transcripts are discarded.
+ */
+Body BuildTranscript(int num_genes) {
+  return [num_genes](int ops, Timer &timer) {
+    const int gene_length = 300;
+    int length = num_genes * gene_length + 100;
+    int done = 0;
+    while (done < ops) {
+      int batch = std::min(ops - done, 200);
+      auto model = std::make_shared<Model>(8e-16);
+      auto genome = std::make_shared<Genome>("bench", length);
+      genome->AddPromoter("p", 1, 10, {{"rnapol", 1e7}});
+      for (int i = 0; i < num_genes; i++) {
+        int start = 51 + i * gene_length;
+        genome->AddGene("gene" + std::to_string(i), start, start + 250,
+                        start - 15, start, 1e7);
+      }
+      genome->Initialize();
+      std::vector<MobileElement::Ptr> pols;
+      for (int i = 0; i < batch; i++) {
+        auto pol = std::make_shared<Polymerase>("rnapol", 10, 40);
+        pol->start(1);
+        pol->stop(10);
+        pols.push_back(pol);
+      }
+      timer.Start();
+      for (auto &pol : pols) {
+        genome->Attach(pol);
+      }
+      timer.Stop();
+      done += batch;
+    }
+  };
+}
+
+/**
+ * Genome::Replicate on an initialized genome with `num_genes` genes, each
+ * with its own promoter and terminator. The copies are not registered with a
+ * Model.
+ */
+Body ReplicateGenome(int num_genes) {
+  return [num_genes](int ops, Timer &timer) {
+    const int gene_length = 700;
+    int length = num_genes * gene_length + 100;
+    auto model = std::make_shared<Model>(8e-16);
+    auto genome = std::make_shared<Genome>("bench", length);
+    for (int i = 0; i < num_genes; i++) {
+      int start = 51 + i * gene_length;
+      genome->AddPromoter("p" + std::to_string(i), start - 50, start - 41,
+                          {{"rnapol", 1e7}});
+      genome->AddGene("gene" + std::to_string(i), start, start + 600,
+                      start - 15, start, 1e7);
+      genome->AddTerminator("t" + std::to_string(i), start + 610,
+                            start + 611, {{"rnapol", 0.5}});
+    }
+    genome->Initialize();
+    int done = 0;
+    while (done < ops) {
+      int batch = std::min(ops - done, 200);
+      std::vector<Genome::Ptr> copies;
+      copies.reserve(batch);
+      timer.Start();
+      for (int i = 0; i < batch; i++) {
+        copies.push_back(genome->Replicate());
+      }
+      timer.Stop();
+      done += batch;
+    }
+  };
+}
+
+/**
+ * SpeciesTracker::Increment on a species that takes part in
+ * `num_reactions` reactions.
+ */
+Body TrackerIncrement(int num_reactions) {
+  return [num_reactions](int ops, Timer &timer) {
+    auto model = std::make_shared<Model>(8e-16);
+    model->AddSpecies("A", 1000);
+    for (int i = 0; i < num_reactions; i++) {
+      auto b = "B" + std::to_string(i);
+      model->AddSpecies(b, 10);
+      model->AddReaction(1.0, {"A", b}, {"C"});
+    }
+    auto &tracker = SpeciesTracker::Instance();
+    timer.Start();
+    for (int i = 0; i < ops; i++) {
+      tracker.Increment("A", (i % 2 == 0) ? 1 : -1);
+    }
+    timer.Stop();
+  };
+}
+
+/**
+ * SpeciesTracker::GatherCounts with `num_species` species.
+ */
+Body GatherCounts(int num_species) {
+  return [num_species](int ops, Timer &timer) {
+    auto model = std::make_shared<Model>(8e-16);
+    for (int i = 0; i < num_species; i++) {
+      model->AddSpecies("species" + std::to_string(i), i);
+    }
+    auto &tracker = SpeciesTracker::Instance();
+    size_t bytes = 0;
+    timer.Start();
+    for (int i = 0; i < ops; i++) {
+      bytes += tracker.GatherCounts(i).size();
+    }
+    timer.Stop();
+    DoNotOptimize(bytes);
+  };
+}
+
+std::vector<Benchmark> AllBenchmarks() {
+  std::vector<Benchmark> benchmarks;
+  for (int n : {10, 100, 1000}) {
+    benchmarks.push_back({"Gillespie::Iterate", 2 * n, GillespieIterate(n)});
+  }
+  benchmarks.push_back({"Polymer::Move/sparse", 1000, PolymerMove(1000)});
+  benchmarks.push_back({"Polymer::Move/crowded", 11, PolymerMove(11)});
+  for (int n : {10, 100, 1000}) {
+    benchmarks.push_back({"MobileElementManager::Choose", n, ManagerChoose(n)});
+  }
+  for (int n : {10, 1000}) {
+    benchmarks.push_back(
+        {"IntervalTree::findOverlapping", n, IntervalQuery(n)});
+  }
+  for (int n : {3, 60}) {
+    benchmarks.push_back({"Genome::BuildTranscript", n, BuildTranscript(n)});
+  }
+  for (int n : {3, 60}) {
+    benchmarks.push_back({"Genome::Replicate", n, ReplicateGenome(n)});
+  }
+  for (int n : {1, 100}) {
+    benchmarks.push_back({"SpeciesTracker::Increment", n, TrackerIncrement(n)});
+  }
+  for (int n : {10, 1000}) {
+    benchmarks.push_back({"SpeciesTracker::GatherCounts", n, GatherCounts(n)});
+  }
+  return benchmarks;
+}
+
+void PrintUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--filter TEXT] [--repetitions N] [--min-time SEC]"
+               " [--output PATH]\n\n"
+               "Run pinetree microbenchmarks and print results as JSON.\n\n"
+               "  -f, --filter TEXT     only run benchmarks whose name "
+               "contains TEXT\n"
+               "  -r, --repetitions N   timed runs per benchmark (default: 5)\n"
+               "  -t, --min-time SEC    minimum duration of each run "
+               "(default: 0.1)\n"
+               "  -o, --output PATH     write JSON to PATH instead of stdout\n"
+               "  -h, --help            show this message\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string filter;
+  std::string output;
+  int repetitions = 5;
+  double min_time = 0.1;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    try {
+      if (arg == "-h" || arg == "--help") {
+        PrintUsage(argv[0]);
+        return 0;
+      } else if ((arg == "-f" || arg == "--filter") && has_value) {
+        filter = argv[++i];
+      } else if ((arg == "-r" || arg == "--repetitions") && has_value) {
+        repetitions = std::max(1, std::stoi(argv[++i]));
+      } else if ((arg == "-t" || arg == "--min-time") && has_value) {
+        min_time = std::stod(argv[++i]);
+      } else if ((arg == "-o" || arg == "--output") && has_value) {
+        output = argv[++i];
+      } else {
+        PrintUsage(argv[0]);
+        return 2;
+      }
+    } catch (const std::exception &) {
+      std::cerr << "Invalid value for " << arg << "." << std::endl;
+      return 2;
+    }
+  }
+
+  std::vector<Result> results;
+  for (const auto &bench : AllBenchmarks()) {
+    if (bench.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    auto result = Run(bench, repetitions, min_time);
+    std::cerr << bench.name << "/" << bench.param << ": "
+              << Median(result.ns_per_op) << " ns/op" << std::endl;
+    results.push_back(result);
+  }
+
+  auto json = ToJson(results, repetitions);
+  if (output.empty()) {
+    std::cout << json;
+  } else {
+    std::ofstream out(output);
+    if (!out) {
+      std::cerr << "Error: could not open '" << output << "'." << std::endl;
+      return 1;
+    }
+    out << json;
+  }
+  return 0;
+}
@@ -0,0 +1,110 @@
+#! /usr/bin/env python3
+"""
+Scaling benchmarks on synthetic models.
+
+Builds models with `pinetree.generate_model()` and varies one size parameter
+at a time (genome length, number of genes, promoters, polymerases, ...) while
+keeping the others at their defaults. For every model it reports the number
+of reactions executed, wall time, events per second and the largest number
+of transcripts tracked at once, so that the cost per event can be followed as
+each dimension grows.
+
+Usage:
+
+    python3 bench/scaling_bench.py
+    python3 bench/scaling_bench.py --dimension num_genes --time 100
+    python3 bench/scaling_bench.py --output scaling.json
+
+The pinetree module must be importable; build in Release mode for meaningful
+numbers.
+"""
+
+import argparse
+import json
+import statistics
+import sys
+import time
+
+import pinetree as pt
+
+# Parameter values swept for each dimension. Other parameters keep the
+# defaults of GeneratorConfig, adjusted by BASE below.
+SWEEPS = {
+    "genome_length": [5000, 10000, 20000, 40000, 80000],
+    "num_genes": [5, 10, 20, 40, 80],
+    "num_promoters": [1, 2, 5, 10],
+    "promoter_strength_sigma": [0.0, 0.5, 1.0, 2.0],
+    "polymerase_copies": [5, 10, 20, 40, 80],
+    "ribosome_copies": [50, 100, 200, 400, 800],
+    "num_rnase_sites": [0, 1, 5, 10],
+    "num_genomes": [1, 2, 4, 8, 16],
+    "num_transcripts": [0, 10, 50, 100, 200],
+}
+# num_genes needs a longer genome to fit 80 genes
+BASE = {"genome_length": 10000}
+MIN_LENGTH_PER_GENE = 100
+
+
+def make_config(seed, **params):
+    config = pt.GeneratorConfig()
+    config.seed = seed
+    for key, value in dict(BASE, **params).items():
+        setattr(config, key, value)
+    config.genome_length = max(config.genome_length,
+                               config.num_genes * MIN_LENGTH_PER_GENE)
+    return config
+
+
+def run(config, runtime):
+    model = pt.generate_model(config)
+    start = time.perf_counter()
+    model.step_until(runtime)
+    wall_time = time.perf_counter() - start
+    stats = model.stats()
+    return {"events": stats.events, "wall_time": wall_time,
+            "events_per_second": stats.events / wall_time,
+            "peak_transcripts": stats.peak_transcripts}
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measure how pinetree scales with model size.")
+    parser.add_argument("--dimension", action="append",
+                        choices=sorted(SWEEPS),
+                        help="only sweep this dimension (may be repeated)")
+    parser.add_argument("--time", type=float, default=200,
+                        help="simulated seconds per run (default: 200)")
+    parser.add_argument("--repetitions", type=int, default=3,
+                        help="runs per point; the median is reported")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--output", help="also write results to this file")
+    args = parser.parse_args()
+
+    results = {}
+    for dimension in args.dimension or sorted(SWEEPS):
+        print("{}:".format(dimension))
+        print("  {:>10} {:>10} {:>9} {:>12} {:>12} {:>11}".format(
+            "value", "events", "time (s)", "events/s", "us/event",
+            "transcripts"))
+        results[dimension] = []
+        for value in SWEEPS[dimension]:
+            config = make_config(args.seed, **{dimension: value})
+            runs = [run(config, args.time) for _ in range(args.repetitions)]
+            wall_time = statistics.median(r["wall_time"] for r in runs)
+            point = dict(runs[0], value=value, wall_time=wall_time,
+                         events_per_second=runs[0]["events"] / wall_time)
+            results[dimension].append(point)
+            print("  {:>10} {:>10} {:>9.3f} {:>12.0f} {:>12.3f} {:>11}".format(
+                value, point["events"], wall_time,
+                point["events_per_second"],
+                1e6 / point["events_per_second"], point["peak_transcripts"]))
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump({"seed": args.seed, "time": args.time,
+                       "results": results}, f, indent=2, sort_keys=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,82 @@
+/*
+ * Drive the three_genes.py model from C through the pinetree C interface,
+ * printing protein counts once per second of simulated time and counting
+ * completed proteins with a termination callback.
+ *
+ * Build with the `c_api_example` CMake target.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pinetree.h"
+
+static void count_proteins(void *user_data, const char *polymerase,
+                           const char *gene) {
+  if (strcmp(polymerase, "__ribosome") == 0) {
+    (*(long *)user_data)++;
+  }
+}
+
+static int check(int status) {
+  if (status != 0) {
+    fprintf(stderr, "Error: %s\n", pt_last_error());
+  }
+  return status;
+}
+
+int main(void) {
+  const char *rnapol[] = {"rnapol"};
+  const double promoter_strength[] = {2e8};
+  const double terminator_efficiency[] = {1.0};
+  const int *protein_x;
+  const int *protein_y;
+  long proteins = 0;
+  int t;
+
+  pt_model *model = pt_model_new(8e-16);
+  pt_genome *plasmid = pt_genome_new("plasmid", 605);
+  if (model == NULL || plasmid == NULL) {
+    fprintf(stderr, "Error: %s\n", pt_last_error());
+    return 1;
+  }
+  pt_model_seed(model, 34);
+  pt_model_add_polymerase(model, "rnapol", 10, 40, 10);
+  pt_model_add_ribosome(model, 10, 30, 100);
+
+  pt_genome_add_promoter(plasmid, "p1", 1, 10, rnapol, promoter_strength, 1);
+  pt_genome_add_terminator(plasmid, "t1", 604, 605, rnapol,
+                           terminator_efficiency, 1);
+  pt_genome_add_gene(plasmid, "rnapol", 26, 225, 26 - 15, 26, 1e7);
+  pt_genome_add_gene(plasmid, "proteinX", 241, 280, 241 - 15, 241, 1e7);
+  pt_genome_add_gene(plasmid, "proteinY", 296, 595, 296 - 15, 296, 1e7);
+  if (check(pt_model_register_genome(model, plasmid)) != 0) {
+    return 1;
+  }
+  pt_genome_free(plasmid);
+
+  pt_model_on_termination(model, count_proteins, &proteins);
+
+  /* Initialize the model so that gene products exist as species */
+  if (check(pt_model_step(model, 1)) != 0) {
+    return 1;
+  }
+  protein_x = pt_model_species_handle(model, "proteinX");
+  protein_y = pt_model_species_handle(model, "proteinY");
+  if (protein_x == NULL || protein_y == NULL) {
+    fprintf(stderr, "Error: %s\n", pt_last_error());
+    return 1;
+  }
+
+  printf("time\tproteinX\tproteinY\n");
+  for (t = 1; t <= 60; t++) {
+    if (check(pt_model_step_until(model, t)) != 0) {
+      return 1;
+    }
+    printf("%d\t%d\t%d\n", t, *protein_x, *protein_y);
+  }
+  printf("Ribosome terminations: %ld\n", proteins);
+
+  pt_model_free(model);
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * An observer plugin that measures, for every gene, the number of proteins
+ * completed by ribosomes, and the mean lifetime of degraded transcripts. The
+ * totals so far are written to a tab-separated file at every sample time.
+ *
+ * Build with the `observer_example` CMake target and load with
+ *
+ *     pinetree model.yml --observer path/to/libobserver_example.so:out.tsv
+ *
+ * or `model.load_observer(path, "out.tsv")` from Python. The argument is the
+ * output file (default: observer.tsv).
+ */
+
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "observer.hpp"
+
+namespace {
+
+class ProteinObserver : public Observer {
+ public:
+  explicit ProteinObserver(const std::string &path) : out_(path) {
+    out_ << "time\tgene\tproteins\tmean_transcript_lifetime\n";
+  }
+
+  void OnTerminate(double time, const std::string &pol_name,
+                   const std::string &gene) override {
+    if (pol_name == "__ribosome") {
+      proteins_[gene]++;
+    }
+  }
+
+  void OnTranscriptCreated(double time, int id, const std::string &name,
+                           int start, int stop) override {
+    created_[id] = time;
+  }
+
+  void OnTranscriptDestroyed(double time, int id) override {
+    auto it = created_.find(id);
+    if (it != created_.end()) {
+      lifetime_sum_ += time - it->second;
+      destroyed_++;
+      created_.erase(it);
+    }
+  }
+
+  void OnSample(double time) override {
+    double lifetime = (destroyed_ > 0) ? lifetime_sum_ / destroyed_ : 0.0;
+    for (const auto &gene : proteins_) {
+      out_ << time << "\t" << gene.first << "\t" << gene.second << "\t"
+           << lifetime << "\n";
+    }
+    out_.flush();
+  }
+
+ private:
+  std::ofstream out_;
+  std::map<std::string, long> proteins_;
+  std::map<int, double> created_;
+  double lifetime_sum_ = 0;
+  long destroyed_ = 0;
+};
+
+}  // namespace
+
+extern "C" Observer *pinetree_create_observer(const char *args) {
+  std::string path = (args != nullptr && args[0] != '\0') ? args
+                                                          : "observer.tsv";
+  return new ProteinObserver(path);
+}
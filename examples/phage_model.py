@@ -1,4 +1,5 @@
-from Bio import SeqIO
+import os
+
 import pinetree as pt
 
 CELL_VOLUME = 1.1e-15
@@ -44,157 +45,89 @@ OPT_CODONS_E_COLI = {'A': ['GCT'],
                      'V': ['GTT', 'GTA']}
 
 
-def get_promoter_interactions(name):
-    '''
-    Calculate promoter binding strengths. The relative strengths defined here
-    come from 2012 Covert, et al paper.
-    '''
-    ecoli_strong = ["E. coli promoter A1",
-                    "E. coli promoter A2",
-                    "E. coli promoter A3"]
-    ecoli_weak = ["E. coli B promoter",
-                  "E. coli C promoter"]
-    phi1_3 = ["T7 promoter phi1.1A",
-              "T7 promoter phi1.1B",
-              "T7 promoter phi1.3",
-              "T7 promoter phi1.5",
-              "T7 promoter phi1.6"]
-    phi3_8 = ["T7 promoter phi2.5",
-              "T7 promoter phi3.8",
-              "T7 promoter phi4c",
-              "T7 promoter phi4.3",
-              "T7 promoter phi4.7"]
-    phi6_5 = ["T7 promoter phi6.5"]
-    phi9 = ["T7 promoter phi9"]
-    phi10 = ["T7 promoter phi10"]
-    phi13 = ["T7 promoter phi13",
-             "T7 promoter phi17"]
-
-    if name in ecoli_strong:
-        return {'ecolipol': 10e4,
-                'ecolipol-p': 3e4}
-    elif name in ecoli_weak:
-        return {'ecolipol': 1e4,
-                'ecolipol-p': 0.3e4}
-    elif name in phi1_3:
-        return {'rnapol-1': PHI10_BIND * 0.01,
-                'rnapol-3.5': PHI10_BIND * 0.01 * 0.5}
-    elif name in phi3_8:
-        return {'rnapol-1': PHI10_BIND * 0.01,
-                'rnapol-3.5': PHI10_BIND * 0.01 * 0.5}
-    elif name in phi6_5:
-        return {'rnapol-1': PHI10_BIND * 0.05,
-                'rnapol-3.5': PHI10_BIND * 0.05}
-    elif name in phi9:
-        return {'rnapol-1': PHI10_BIND * 0.2,
-                'rnapol-3.5': PHI10_BIND * 0.2}
-    elif name in phi10:
-        return {'rnapol-1': PHI10_BIND,
-                'rnapol-3.5': PHI10_BIND}
-    elif name in phi13:
-        return {'rnapol-1': PHI10_BIND * 0.1,
-                'rnapol-3.5': PHI10_BIND * 0.1}
-    else:
-        raise ValueError(
-            "Promoter strength for {0} not assigned.".format(name))
-
-
-def get_terminator_interactions(name):
+# Relative promoter strengths come from 2012 Covert, et al paper.
+PROMOTER_CLASSES = {"E. coli promoter A1": "ecoli_strong",
+                    "E. coli promoter A2": "ecoli_strong",
+                    "E. coli promoter A3": "ecoli_strong",
+                    "E. coli B promoter": "ecoli_weak",
+                    "E. coli C promoter": "ecoli_weak",
+                    "T7 promoter phi1.1A": "phi1_3",
+                    "T7 promoter phi1.1B": "phi1_3",
+                    "T7 promoter phi1.3": "phi1_3",
+                    "T7 promoter phi1.5": "phi1_3",
+                    "T7 promoter phi1.6": "phi1_3",
+                    "T7 promoter phi2.5": "phi3_8",
+                    "T7 promoter phi3.8": "phi3_8",
+                    "T7 promoter phi4c": "phi3_8",
+                    "T7 promoter phi4.3": "phi3_8",
+                    "T7 promoter phi4.7": "phi3_8",
+                    "T7 promoter phi6.5": "phi6_5",
+                    "T7 promoter phi9": "phi9",
+                    "T7 promoter phi10": "phi10",
+                    "T7 promoter phi13": "phi13",
+                    "T7 promoter phi17": "phi13"}
+
+PROMOTER_INTERACTIONS = {
+    "ecoli_strong": {'ecolipol': 10e4,
+                     'ecolipol-p': 3e4},
+    "ecoli_weak": {'ecolipol': 1e4,
+                   'ecolipol-p': 0.3e4},
+    "phi1_3": {'rnapol-1': PHI10_BIND * 0.01,
+               'rnapol-3.5': PHI10_BIND * 0.01 * 0.5},
+    "phi3_8": {'rnapol-1': PHI10_BIND * 0.01,
+               'rnapol-3.5': PHI10_BIND * 0.01 * 0.5},
+    "phi6_5": {'rnapol-1': PHI10_BIND * 0.05,
+               'rnapol-3.5': PHI10_BIND * 0.05},
+    "phi9": {'rnapol-1': PHI10_BIND * 0.2,
+             'rnapol-3.5': PHI10_BIND * 0.2},
+    "phi10": {'rnapol-1': PHI10_BIND,
+              'rnapol-3.5': PHI10_BIND},
+    "phi13": {'rnapol-1': PHI10_BIND * 0.1,
+              'rnapol-3.5': PHI10_BIND * 0.1}}
+
+# Terminator efficiencies
+TERMINATOR_INTERACTIONS = {
+    "E. coli transcription terminator TE": {'ecolipol': 1.0,
+                                            'ecolipol-p': 1.0,
+                                            'rnapol-1': 0.0,
+                                            'rnapol-3.5': 0.0},
+    "T7 transcription terminator Tphi": {'rnapol-1': 0.85,
+                                         'rnapol-3.5': 0.85}}
+
+
+def genbank_rules():
     '''
-    Get terminator efficiencies.
+    Rules for converting GenBank features into promoters, terminators, and
+    genes.
     '''
-    if name == "E. coli transcription terminator TE":
-        return {'ecolipol': 1.0,
-                'ecolipol-p': 1.0,
-                'rnapol-1': 0.0,
-                'rnapol-3.5': 0.0}
-    elif name == "T7 transcription terminator Tphi":
-        return {'rnapol-1': 0.85,
-                'rnapol-3.5': 0.85}
-    else:
-        return {'name': 0.0}
-
-
-def compute_cds_weights(record, feature, factor, weights):
-    # Grab the gene name
-    nuc_seq = feature.location.extract(record).seq
-    aa_seq = feature.qualifiers["translation"][0]
-    weight_sum = 0
-    for index, nuc in enumerate(nuc_seq):
-        aa_index = int(index / 3)
-        codon_start = aa_index * 3
-        codon = nuc_seq[codon_start:codon_start + 3]
-        genome_index = feature.location.start + index
-        if aa_index < len(aa_seq):
-            if aa_seq[aa_index] in OPT_CODONS_E_COLI:
-                if codon in OPT_CODONS_E_COLI[aa_seq[aa_index]]:
-                    weights[genome_index] = factor
-                    weight_sum += factor
-                else:
-                    weights[genome_index] = 1
-                    weight_sum += 1
-    return weights
-
-
-def normalize_weights(weights):
-    # Average over all CDSs, which will have non-zero weights
-    non_zero = sum(1 if i != 0 else 0.0 for i in weights)
-    mean_weight = sum(weights) / non_zero
-    norm_weights = [i / mean_weight for i in weights]
-    # Replace non-CDS weights with 1
-    norm_weights = [1 if i == 0 else i for i in norm_weights]
-    return norm_weights
-
-
-def main():
+    rules = pt.GenbankRules()
+    rules.ignore = set(IGNORE_REGULATORY + IGNORE_GENES)
+    rules.rename = RELABEL_GENES
+    rules.classes = PROMOTER_CLASSES
+    rules.promoter_interactions = PROMOTER_INTERACTIONS
+    rules.terminator_interactions = TERMINATOR_INTERACTIONS
+    rules.default_terminator_interactions = {'name': 0.0}
+    rules.rbs_length = 30
+    rules.rbs_strength = 1e7
+    rules.optimal_codons = OPT_CODONS_E_COLI
+    rules.optimal_codon_weight = 1.0
+    return rules
+
+
+GENBANK_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                            "T7_genome.gb")
+
+
+def build_model(seed=34):
+    """Construct the T7 infection model (also used by bench/macro_bench.py)."""
     sim = pt.Model(cell_volume=CELL_VOLUME)
 
-    record = SeqIO.read("T7_genome.gb", "genbank")
-    genome_length = len(record.seq)
-    phage = pt.Genome(name="phage", length=genome_length)
-
-    for feature in record.features:
-        weights = [0.0] * len(record.seq)
-        # Convert to inclusive genomic coordinates
-        start = feature.location.start.position + 1
-        stop = feature.location.end.position
-        name = ''
-        if "note" in feature.qualifiers:
-            name = feature.qualifiers["note"][0]
-        # Grab promoters and terminators
-        if feature.type == "regulatory":
-            if name in IGNORE_REGULATORY:
-                continue
-            # Construct promoter
-            if "promoter" in feature.qualifiers["regulatory_class"]:
-                length = stop - start
-                if length < 35:
-                    start = start - 35
-                interactions = get_promoter_interactions(name)
-                phage.add_promoter(name, start, stop, interactions)
-            # Construct terminator params
-            if "terminator" in feature.qualifiers["regulatory_class"]:
-                interactions = get_terminator_interactions(name)
-                phage.add_terminator(name, start, stop, interactions)
-        # Grab genes/CDSes
-        if feature.type == "gene":
-            if name in IGNORE_GENES:
-                continue
-            if name in RELABEL_GENES:
-                name = RELABEL_GENES[name]
-            # Construct CDS parameters for this gene
-            phage.add_gene(name=name, start=start, stop=stop,
-                           rbs_start=start - 30, rbs_stop=start, rbs_strength=1e7)
-        if feature.type == "CDS":
-            weights = compute_cds_weights(record, feature, 1.0, weights)
+    phage = pt.read_genbank(GENBANK_PATH, genbank_rules(), name="phage")
 
     mask_interactions = ["rnapol-1", "rnapol-3.5",
                          "ecolipol", "ecolipol-p", "ecolipol-2", "ecolipol-2-p"]
     phage.add_mask(500, mask_interactions)
 
-    norm_weights = normalize_weights(weights)
-    phage.add_weights(norm_weights)
-
     sim.register_genome(phage)
 
     sim.add_polymerase("rnapol-1", 35, 230, 0)
@@ -250,8 +183,12 @@ def main():
 
     sim.add_reaction(3.5, ["rnapol-3.5"], ["lysozyme-3.5", "rnapol-1"])
 
-    sim.seed(34)
+    sim.seed(seed)
+    return sim
 
+
+def main():
+    sim = build_model()
     sim.simulate(time_limit=1500, time_step=5, output="phage_counts.tsv")
 
 
@@ -1,11 +1,22 @@
 #include "choices.hpp"
 
+namespace {
+thread_local std::mt19937 *thread_gen = nullptr;
+}
+
 void Random::seed(int seed) {
   gen_.seed(seed);
   seeded_ = true;
 }
 
+void Random::ThreadGenerator(std::mt19937 *generator) {
+  thread_gen = generator;
+}
+
 double Random::random() {
+  if (thread_gen != nullptr) {
+    return std::uniform_real_distribution<>(0, 1)(*thread_gen);
+  }
   if (!seeded_) {
     std::random_device rd;
     gen_.seed(rd());
@@ -11,6 +11,12 @@ static std::mt19937 gen_;
 static std::uniform_real_distribution<> dis_(0, 1);
 void seed(int seed);
 double random();
+/**
+ * Draw random numbers on the calling thread from `generator` instead of the
+ * shared generator (or from the shared generator again if it is null). Used
+ * by the worker threads of Model::EnableParallel().
+ */
+void ThreadGenerator(std::mt19937 *generator);
 template <typename T>
 int WeightedChoiceIndex(const std::vector<T> &population,
                         const std::vector<double> &weights) {
@@ -0,0 +1,38 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_DEFERRED_HPP  // header guard
+#define SRC_DEFERRED_HPP
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * Queue of updates to shared state (species counts, the change journal,
+ * observers) made on a worker thread of Model::EnableParallel(). Workers only
+ * touch their own polymers; everything else they would change is queued here
+ * and applied on the main thread at the end of each window. Null on every
+ * other thread.
+ */
+typedef std::vector<std::function<void()>> DeferredQueue;
+extern thread_local DeferredQueue *deferred_updates;
+
+/**
+ * Queue a call of `function` with `args` if the calling thread is a worker.
+ * The arguments are only copied when the call is queued, so callers on other
+ * threads pay nothing but the check.
+ *
+ * @return true if the call was queued, false if the caller should make it
+ *  now
+ */
+template <typename F, typename... Args>
+inline bool Defer(F function, Args &&... args) {
+  if (deferred_updates == nullptr) {
+    return false;
+  }
+  deferred_updates->emplace_back(
+      std::bind(function, std::forward<Args>(args)...));
+  return true;
+}
+
+#endif  // SRC_DEFERRED_HPP
@@ -0,0 +1,98 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+// Worker processes are forked, so the channel is POSIX only (see
+// Model::SimulateEnsemble())
+#ifndef _WIN32
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+#include "ensemble.hpp"
+
+SharedChannel::SharedChannel(std::size_t capacity)
+    : capacity_(capacity),
+      length_(sizeof(Header) + capacity),
+      parent_(getpid()) {
+  void *memory = mmap(nullptr, length_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error("Could not map shared memory for worker output.");
+  }
+  header_ = new (memory) Header();
+  data_ = static_cast<char *>(memory) + sizeof(Header);
+  Reset();
+}
+
+SharedChannel::~SharedChannel() {
+  header_->~Header();
+  munmap(header_, length_);
+}
+
+void SharedChannel::Reset() {
+  header_->written.store(0);
+  header_->read.store(0);
+  header_->error[0] = '\0';
+}
+
+void SharedChannel::Write(const char *data, std::size_t size) {
+  while (size > 0) {
+    auto written = header_->written.load(std::memory_order_relaxed);
+    auto read = header_->read.load(std::memory_order_acquire);
+    std::size_t room = capacity_ - std::size_t(written - read);
+    if (room == 0) {
+      if (getppid() != parent_) {
+        _exit(1);
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+      continue;
+    }
+    std::size_t offset = written % capacity_;
+    std::size_t count = std::min({size, room, capacity_ - offset});
+    std::memcpy(data_ + offset, data, count);
+    header_->written.store(written + count, std::memory_order_release);
+    data += count;
+    size -= count;
+  }
+}
+
+std::size_t SharedChannel::Read(std::string *out) {
+  auto read = header_->read.load(std::memory_order_relaxed);
+  auto written = header_->written.load(std::memory_order_acquire);
+  std::size_t total = std::size_t(written - read);
+  std::size_t offset = read % capacity_;
+  std::size_t first = std::min(total, capacity_ - offset);
+  out->append(data_ + offset, first);
+  out->append(data_, total - first);
+  header_->read.store(written, std::memory_order_release);
+  return total;
+}
+
+void SharedChannel::error(const std::string &message) {
+  std::size_t size = std::min(message.size(), sizeof(header_->error) - 1);
+  std::memcpy(header_->error, message.data(), size);
+  header_->error[size] = '\0';
+}
+
+std::string SharedChannel::error() const { return header_->error; }
+
+ChannelStreambuf::int_type ChannelStreambuf::overflow(int_type ch) {
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    char c = traits_type::to_char_type(ch);
+    channel_.Write(&c, 1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+std::streamsize ChannelStreambuf::xsputn(const char *data,
+                                         std::streamsize size) {
+  channel_.Write(data, size);
+  return size;
+}
+
+#endif
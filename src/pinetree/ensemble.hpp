@@ -0,0 +1,80 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_ENSEMBLE_HPP  // header guard
+#define SRC_ENSEMBLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+
+/**
+ * One-way byte stream from a worker process to the process that forked it,
+ * through a ring buffer in shared anonymous memory (see
+ * Model::SimulateEnsemble()). The parent creates the channel before forking;
+ * the worker writes and the parent reads. A worker that outpaces the parent
+ * waits for room in the buffer.
+ */
+class SharedChannel {
+ public:
+  /**
+   * Map a channel that holds up to `capacity` unread bytes.
+   */
+  explicit SharedChannel(std::size_t capacity = 1 << 20);
+  ~SharedChannel();
+  SharedChannel(const SharedChannel &) = delete;
+  SharedChannel &operator=(const SharedChannel &) = delete;
+  /**
+   * Empty the channel for the next worker. Only call this when no worker is
+   * writing to it.
+   */
+  void Reset();
+  /**
+   * Append bytes, waiting while the buffer is full. Called by the worker.
+   * Gives up (and exits the worker) if the parent has gone away.
+   */
+  void Write(const char *data, std::size_t size);
+  /**
+   * Append every unread byte to `out`. Called by the parent.
+   *
+   * @return number of bytes read
+   */
+  std::size_t Read(std::string *out);
+  /**
+   * Message describing why the worker failed, set by the worker before it
+   * exits with an error.
+   */
+  void error(const std::string &message);
+  std::string error() const;
+
+ private:
+  struct Header {
+    std::atomic<std::uint64_t> written;
+    std::atomic<std::uint64_t> read;
+    char error[256];
+  };
+  std::size_t capacity_;
+  std::size_t length_;
+  int parent_;
+  Header *header_;
+  char *data_;
+};
+
+/**
+ * Stream buffer that writes to a SharedChannel, so that a worker can write
+ * output with the same code as Simulate().
+ */
+class ChannelStreambuf : public std::streambuf {
+ public:
+  explicit ChannelStreambuf(SharedChannel &channel) : channel_(channel) {}
+
+ protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char *data, std::streamsize size) override;
+
+ private:
+  SharedChannel &channel_;
+};
+
+#endif  // header guard
@@ -7,14 +7,21 @@
 #define SIGNAL_HPP
 
 #include <functional>
-#include <map>
 #include <memory>
+#include <vector>
 
 // A signal object may call multiple slots with the
 // same signature. You can connect functions to the signal
 // which will be called when the emit() method on the
 // signal object is invoked. Any argument passed to emit()
 // will be passed to the given functions.
+//
+// Slots are called in the order they were connected. They are stored
+// contiguously as delegates: an object pointer and a plain function pointer.
+// Member functions given as template arguments (ConnectMember<T, &T::f>) are
+// called through a stub with no further indirection; other callables are
+// wrapped in a std::function once, when they are connected. Emitting never
+// copies a slot.
 
 template <typename... Args> class Signal {
 
@@ -24,6 +31,11 @@ public:
   // copy creates new signal
   Signal(Signal const &other) : current_id_(0) {}
 
+  // connects a member function, known at compile time, to this Signal
+  template <typename T, void (T::*func)(Args...)> int ConnectMember(T *inst) {
+    return Add(inst, &CallMember<T, func>, nullptr);
+  }
+
   // connects a member function to this Signal
   template <typename T> int ConnectMember(T *inst, void (T::*func)(Args...)) {
     return Connect([=](Args... args) { (inst->*func)(args...); });
@@ -50,29 +62,100 @@ public:
   // connects a std::function to the signal. The returned
   // value can be used to disconnect the function again
   int Connect(std::function<void(Args...)> const &slot) const {
-    slots_.insert(std::make_pair(++current_id_, slot));
-    return current_id_;
+    std::shared_ptr<std::function<void(Args...)>> owned(
+        new std::function<void(Args...)>(slot));
+    return Add(owned.get(), &CallFunction, owned);
   }
 
   // disconnects a previously connected function
-  void Disconnect(int id) const { slots_.erase(id); }
+  void Disconnect(int id) const {
+    for (size_t i = 0; i < slots_.size(); i++) {
+      if (slots_[i].id == id) {
+        Remove(i);
+        return;
+      }
+    }
+  }
 
   // disconnects all previously connected functions
-  void DisconnectAll() const { slots_.clear(); }
+  void DisconnectAll() const {
+    for (size_t i = slots_.size(); i-- > 0;) {
+      Remove(i);
+    }
+  }
 
   // calls all connected functions
-  void Emit(Args... p) {
-    for (auto it : slots_) {
-      it.second(p...);
+  void Emit(const Args &... p) {
+    // Slots connected while emitting are not called until the next Emit;
+    // slots disconnected while emitting are skipped
+    size_t count = slots_.size();
+    emitting_++;
+    for (size_t i = 0; i < count; i++) {
+      const Slot &slot = slots_[i];
+      if (slot.call != nullptr) {
+        slot.call(slot.object, p...);
+      }
+    }
+    if (--emitting_ == 0 && removed_) {
+      Compact();
     }
   }
 
   // assignment creates new Signal
-  Signal &operator=(Signal const &other) { DisconnectAll(); }
+  Signal &operator=(Signal const &other) {
+    DisconnectAll();
+    return *this;
+  }
 
 private:
-  mutable std::map<int, std::function<void(Args...)>> slots_;
+  typedef void (*Stub)(void *, const Args &...);
+  struct Slot {
+    int id;
+    void *object;
+    Stub call;
+    // Keeps a connected std::function alive
+    std::shared_ptr<void> owner;
+  };
+
+  template <typename T, void (T::*func)(Args...)>
+  static void CallMember(void *inst, const Args &... args) {
+    (static_cast<T *>(inst)->*func)(args...);
+  }
+
+  static void CallFunction(void *function, const Args &... args) {
+    (*static_cast<std::function<void(Args...)> *>(function))(args...);
+  }
+
+  int Add(void *object, Stub call, std::shared_ptr<void> owner) const {
+    slots_.push_back(Slot{++current_id_, object, call, std::move(owner)});
+    return current_id_;
+  }
+
+  void Remove(size_t index) const {
+    if (emitting_ > 0) {
+      // Keep indices stable for the Emit in progress
+      slots_[index].call = nullptr;
+      removed_ = true;
+    } else {
+      slots_.erase(slots_.begin() + index);
+    }
+  }
+
+  void Compact() const {
+    std::vector<Slot> live;
+    for (auto &slot : slots_) {
+      if (slot.call != nullptr) {
+        live.push_back(std::move(slot));
+      }
+    }
+    slots_.swap(live);
+    removed_ = false;
+  }
+
+  mutable std::vector<Slot> slots_;
   mutable int current_id_;
+  mutable int emitting_ = 0;
+  mutable bool removed_ = false;
 };
 
-#endif /* SIGNAL_HPP */
\ No newline at end of file
+#endif /* SIGNAL_HPP */
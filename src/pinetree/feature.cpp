@@ -9,16 +9,18 @@
 
 FixedElement::FixedElement(const std::string &name, int start, int stop,
                            const std::map<std::string, double> &interactions)
-    : name_(name),
+    : name_(Intern(name)),
       start_(start),
       stop_(stop),
-      interactions_(interactions),
+      interactions_(
+          std::make_shared<std::map<std::string, double>>(interactions)),
+      gene_(Intern("")),
       covered_(0),
       old_covered_(0),
       reading_frame_(-1) {
   if (start_ < 0 || stop_ < 0) {
     throw std::invalid_argument(
-        "Fixed element '" + name_ +
+        "Fixed element '" + *name_ +
         "' has a negative start and/or stop coordinate.");
   }
 }
@@ -32,14 +34,14 @@ BindingSite::BindingSite(const std::string &name, int start, int stop,
   for (auto const &item : interactions) {
     if (item.second < 0) {
       throw std::invalid_argument(
-          "Binding site '" + name_ +
+          "Binding site '" + *name_ +
           "' must have non-negative interaction rate constants.");
     }
   }
 }
 
 bool BindingSite::CheckInteraction(const std::string &name) {
-  return interactions_.count(name);
+  return interactions_->count(name);
 }
 
 BindingSite::Ptr BindingSite::Clone() const {
@@ -63,14 +65,14 @@ ReleaseSite::ReleaseSite(const std::string &name, int start, int stop,
   for (auto const &item : interactions) {
     if (item.second < 0 || item.second > 1) {
       throw std::invalid_argument(
-          "Release site '" + name_ +
+          "Release site '" + *name_ +
           "' must have efficiency values between 0.0 and 1.0.");
     }
   }
 }
 
 bool ReleaseSite::CheckInteraction(const std::string &name, int reading_frame) {
-  if (interactions_.count(name) == 1) {
+  if (interactions_->count(name) == 1) {
     if (reading_frame_ == -1) {
       return true;
     }
@@ -86,15 +88,19 @@ ReleaseSite::Ptr ReleaseSite::Clone() const {
 }
 
 MobileElement::MobileElement(const std::string &name, int footprint, int speed)
-    : name_(name), footprint_(footprint), speed_(speed), reading_frame_(-1) {
+    : name_(Intern(name)),
+      gene_bound_(Intern("")),
+      footprint_(footprint),
+      speed_(speed),
+      reading_frame_(-1) {
   start_ = 0;
   stop_ = start_ + footprint_;
   if (footprint_ < 0) {
-    throw std::invalid_argument("Mobile element '" + name_ +
+    throw std::invalid_argument("Mobile element '" + *name_ +
                                 "' has a negative footprint size.");
   }
   if (speed_ < 0) {
-    throw std::invalid_argument("Mobile element '" + name_ +
+    throw std::invalid_argument("Mobile element '" + *name_ +
                                 "' has a negative average speed.");
   }
 }
@@ -118,7 +124,7 @@ void Polymerase::MoveBack() {
   } else {
     throw std::runtime_error(
         "Attempting to assign negative start position to Polymerase object '" +
-        name_ + "'.");
+        *name_ + "'.");
   }
 }
 
@@ -144,7 +150,7 @@ void Mask::MoveBack() {
   } else {
     throw std::runtime_error(
         "Attempting to assign negative start position to Mask object '" +
-        name_ + "'.");
+        *name_ + "'.");
   }
 }
 
@@ -3,17 +3,24 @@
 #ifndef SRC_FEATURE_HPP_  // header guard
 #define SRC_FEATURE_HPP_
 
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "event_signal.hpp"
+#include "intern.hpp"
 
 /**
  * Abstract class from which all fixed elements on a polymer inherit. These
  * include promoters, terminators, ribosome binding sites, and stop codons.
  * They all share a common interface for tracking whether they're covered
  * or uncovered.
+ *
+ * Every transcript gets its own copy of each element, so names are interned
+ * and the interaction map is shared between copies.
  */
 class FixedElement : public std::enable_shared_from_this<FixedElement> {
  public:
@@ -64,24 +71,31 @@ class FixedElement : public std::enable_shared_from_this<FixedElement> {
    * @return True if at least one feature is covering element.
    */
   bool IsCovered() { return covered_ > 0; }
+  /**
+   * Number of features covering this element.
+   */
+  int covered() const { return covered_; }
   /**
    * Getters and setters
    */
-  const std::string &gene() const { return gene_; }
-  void gene(const std::string &gene) { gene_ = gene; }
-  std::string const &name() const { return name_; }
+  const std::string &gene() const { return *gene_; }
+  void gene(const std::string &gene) { gene_ = Intern(gene); }
+  std::string const &name() const { return *name_; }
   int start() const { return start_; }
   int stop() const { return stop_; }
   int reading_frame() const { return reading_frame_; }
   void reading_frame(int reading_frame) { reading_frame_ = reading_frame; }
   bool first_exposure() const { return first_exposure_; }
   void first_exposure(bool first_exposure) { first_exposure_ = first_exposure; }
+  const std::map<std::string, double> &interactions() const {
+    return *interactions_;
+  }
 
  protected:
   /**
-   * Name of this feature.
+   * Name of this feature (interned).
    */
-  std::string name_;
+  const std::string *name_;
   /**
    * The start site of the feature. Usually the most upstream site position.
    */
@@ -92,14 +106,14 @@ class FixedElement : public std::enable_shared_from_this<FixedElement> {
   int stop_;
   /**
    * Vector of names of other features/polymerases that this feature interacts
-   * with.
+   * with. Shared by all copies of this element.
    */
-  std::map<std::string, double> interactions_;
+  std::shared_ptr<const std::map<std::string, double>> interactions_;
   /**
-   * Name of gene associated with this FixedElement. This is the value that
-   * will get reported to the species tracker.
+   * Name of gene associated with this FixedElement (interned). This is the
+   * value that will get reported to the species tracker.
    */
-  std::string gene_;
+  const std::string *gene_;
   /**
    * Count of how many features are currently covering this element.
    */
@@ -109,9 +123,9 @@ class FixedElement : public std::enable_shared_from_this<FixedElement> {
    */
   int old_covered_;
   /**
-   * Reading frame for FixedElement.
+   * Reading frame for FixedElement (0, 1, 2, or -1 for any frame).
    */
-  int reading_frame_;
+  int8_t reading_frame_;
   /**
    * Has the site been exposed before?
    */
@@ -219,7 +233,8 @@ class ReleaseSite : public FixedElement {
   bool readthrough() const { return readthrough_; }
   void readthrough(bool readthrough) { readthrough_ = readthrough; }
   double efficiency(const std::string &pol_name) {
-    return interactions_[pol_name];
+    auto it = interactions_->find(pol_name);
+    return it == interactions_->end() ? 0 : it->second;
   }
 
  private:
@@ -233,6 +248,10 @@ class ReleaseSite : public FixedElement {
 /**
  * Abstract class for all elements capable of moving on a polymer. This includes
  * polymerase, ribosomes, masks, and RNases.
+ *
+ * Models can hold 10^5 ribosomes at once, so the layout is kept compact:
+ * names are interned, positions are 32-bit, and the speed, which is always a
+ * whole number of bp/s, is stored as a float.
  */
 class MobileElement : public std::enable_shared_from_this<MobileElement> {
  public:
@@ -264,7 +283,7 @@ class MobileElement : public std::enable_shared_from_this<MobileElement> {
   /**
    * Getters and setters.
    */
-  std::string const &name() const { return name_; }
+  std::string const &name() const { return *name_; }
   int start() const { return start_; }
   int stop() const { return stop_; }
   void start(int start) { start_ = start; }
@@ -273,15 +292,21 @@ class MobileElement : public std::enable_shared_from_this<MobileElement> {
   int footprint() const { return footprint_; }
   int reading_frame() const { return reading_frame_; }
   void reading_frame(int reading_frame) { reading_frame_ = reading_frame; }
-  std::string gene_bound() const { return gene_bound_; }
-  void gene_bound(std::string gene) { gene_bound_ = gene; }
+  const std::string &gene_bound() const { return *gene_bound_; }
+  void gene_bound(const std::string &gene) { gene_bound_ = Intern(gene); }
+  int id() const { return id_; }
+  void id(int id) { id_ = id; }
 
  protected:
   /**
-   * Name of this feature.
+   * Name of this feature (interned).
    */
-  std::string name_;
-
+  const std::string *name_;
+  /**
+   * Which gene did this MobileElement originally bind to? (interned, used for
+   * ribosomes)
+   */
+  const std::string *gene_bound_;
   /**
    * The start site of the feature. Usually the most upstream site position.
    */
@@ -295,18 +320,17 @@ class MobileElement : public std::enable_shared_from_this<MobileElement> {
    */
   int footprint_;
   /**
-   * Speed in bp/s.
+   * Unique id, assigned when this MobileElement binds to a polymer.
    */
-  double speed_;
+  int id_ = 0;
   /**
-   * Reading frame of polymerase (0, 1, or 2).
+   * Speed in bp/s. Exact for any integer speed below 2^24 bp/s.
    */
-  int reading_frame_;
+  float speed_;
   /**
-   * Which gene did this MobileElement originally bind to?
-   * (used for ribosomes)
+   * Reading frame of polymerase (0, 1, or 2).
    */
-  std::string gene_bound_ = "";
+  int8_t reading_frame_;
 };
 
 /**
@@ -378,6 +402,9 @@ class Mask : public MobileElement {
    * @return bool true if elements interact
    */
   bool CheckInteraction (const std::string &name) const;
+  const std::map<std::string, double> &interactions() const {
+    return interactions_;
+  }
 
  private:
   /**
@@ -0,0 +1,340 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "choices.hpp"
+#include "flat_transcript.hpp"
+#include "intern.hpp"
+#include "tracker.hpp"
+
+namespace {
+
+// Copy intervals with fresh copies of their elements
+template <typename T>
+std::vector<Interval<std::shared_ptr<T>>> CloneIntervals(
+    const std::vector<Interval<std::shared_ptr<T>>> &intervals) {
+  std::vector<Interval<std::shared_ptr<T>>> clones;
+  clones.reserve(intervals.size());
+  for (const auto &interval : intervals) {
+    clones.emplace_back(interval.start, interval.stop, interval.value->Clone());
+  }
+  return clones;
+}
+
+// Offsets of the first element at each position from `first` to one past
+// `last`, for elements sorted by `position`
+template <typename F>
+std::vector<int> PositionOffsets(int count, int first, int last, F position) {
+  std::vector<int> offsets(last - first + 2, 0);
+  for (int i = 0; i < count; i++) {
+    offsets[position(i) - first + 1]++;
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  return offsets;
+}
+
+// Range of offsets of elements at `position`
+std::pair<int, int> OffsetRange(const std::vector<int> &offsets, int first,
+                                int position) {
+  int index = position - first;
+  if (index < 0 || index + 1 >= int(offsets.size())) {
+    return {0, 0};
+  }
+  return {offsets[index], offsets[index + 1]};
+}
+
+}  // namespace
+
+FlatTranscript::FlatTranscript(const Transcript &transcript)
+    : Transcript(transcript.name(), transcript.start(), transcript.stop(),
+                 CloneIntervals(transcript.GetBindingIntervals()),
+                 CloneIntervals(transcript.GetReleaseIntervals()),
+                 transcript.GetMask(),
+                 std::make_shared<std::vector<double>>(transcript.weights())) {
+  if (transcript.num_attached() != 0) {
+    throw std::invalid_argument("Transcript '" + name_ +
+                                "' already has ribosomes bound.");
+  }
+  attached_ = false;
+  bindings_ = transcript.bindings();
+
+  for (const auto &interval : binding_intervals_) {
+    sites_.push_back(interval.value.get());
+  }
+  std::stable_sort(sites_.begin(), sites_.end(),
+                   [](const BindingSite *a, const BindingSite *b) {
+                     return a->start() < b->start();
+                   });
+  by_stop_.resize(sites_.size());
+  std::iota(by_stop_.begin(), by_stop_.end(), 0);
+  std::stable_sort(by_stop_.begin(), by_stop_.end(), [this](int a, int b) {
+    return sites_[a]->stop() < sites_[b]->stop();
+  });
+  first_ = start_;
+  int last = stop_ + 1;
+  for (const auto site : sites_) {
+    first_ = std::min(first_, site->start());
+    last = std::max(last, site->stop());
+    longest_site_ = std::max(longest_site_, site->stop() - site->start());
+  }
+  start_offsets_ = PositionOffsets(sites_.size(), first_, last, [this](int i) {
+    return sites_[i]->start();
+  });
+  stop_offsets_ = PositionOffsets(sites_.size(), first_, last, [this](int i) {
+    return sites_[by_stop_[i]]->stop();
+  });
+
+  // Stop codons made by AddGene() always terminate ribosomes of their gene,
+  // so where a ribosome terminates is known when it binds
+  for (const auto &interval : release_intervals_) {
+    if (interval.value->efficiency("__ribosome") < 1) {
+      throw std::invalid_argument(
+          "Translation engine: stop codon of " + interval.value->gene() +
+          " on transcript '" + name_ + "' does not always terminate.");
+    }
+    stop_codons_.push_back(interval.value.get());
+  }
+}
+
+std::pair<int, int> FlatTranscript::Starting(int position) const {
+  return OffsetRange(start_offsets_, first_, position);
+}
+
+std::pair<int, int> FlatTranscript::Stopping(int position) const {
+  return OffsetRange(stop_offsets_, first_, position);
+}
+
+template <typename F>
+void FlatTranscript::ForOverlapping(int start, int stop, F visit) {
+  int from = Starting(std::max(first_, start - longest_site_)).first;
+  int to = Starting(std::min(stop, first_ + int(start_offsets_.size()) - 2))
+               .second;
+  for (int i = from; i < to; i++) {
+    if (sites_[i]->stop() >= start) {
+      visit(sites_[i]);
+    }
+  }
+}
+
+void FlatTranscript::Initialize() {
+  // Same as Polymer::Initialize(): cover sites under the mask and expose
+  // the rest
+  auto &tracker = SpeciesTracker::Instance();
+  ForOverlapping(mask_.start(), mask_.stop(), [&](BindingSite *site) {
+    tracker.Add(site->name(), shared_from_this());
+    site->Cover();
+    site->ResetState();
+  });
+  for (auto codon : stop_codons_) {
+    if (codon->start() <= mask_.stop() && codon->stop() >= mask_.start()) {
+      codon->Cover();
+      codon->ResetState();
+    }
+  }
+  total_elements_ = 0;
+  degraded_elements_ = 0;
+  for (auto site : sites_) {
+    if (site->start() >= start_ && site->stop() <= mask_.start()) {
+      tracker.Add(site->name(), shared_from_this());
+      site->Uncover();
+      site->ResetState();
+      LogUncover(site->name());
+      total_elements_ += 1;
+    }
+  }
+}
+
+void FlatTranscript::Unlink() {
+  auto &tracker = SpeciesTracker::Instance();
+  ForOverlapping(start_, stop_, [&](BindingSite *site) {
+    tracker.Remove(site->name(), shared_from_this());
+  });
+}
+
+void FlatTranscript::Bind(MobileElement::Ptr pol,
+                          const std::string &promoter_name) {
+  std::vector<BindingSite *> choices;
+  ForOverlapping(start_, mask_.start(), [&](BindingSite *site) {
+    if (site->name() == promoter_name && !site->IsCovered()) {
+      choices.push_back(site);
+    }
+  });
+  if (choices.empty()) {
+    throw std::runtime_error("Polymerase " + pol->name() +
+                             " could not find free promoter " + promoter_name +
+                             " to bind in the polymer " + name_);
+  }
+  BindingSite *site = Random::WeightedChoice(choices);
+  if (!site->CheckInteraction(pol->name())) {
+    throw std::runtime_error("Polymerase " + pol->name() +
+                             " does not interact with promoter " +
+                             promoter_name);
+  }
+  pol->start(site->start());
+  pol->stop(site->start() + pol->footprint() - 1);
+  pol->reading_frame(site->reading_frame());
+  if (pol->name() == "__ribosome") {
+    pol->gene_bound(site->gene());
+  }
+  if (pol->stop() >= mask_.start()) {
+    throw std::runtime_error(
+        "MobileElement " + pol->name() +
+        " will overlap with mask upon promoter binding. This may cause the "
+        "polymerase to stall and produce unexpected behavior.");
+  }
+  auto &tracker = SpeciesTracker::Instance();
+  ForOverlapping(pol->start(), pol->stop(), [&](BindingSite *covered) {
+    covered->Cover();
+    if (covered->WasCovered()) {
+      LogCover(covered->name());
+    }
+    covered->ResetState();
+    if (covered->CheckInteraction("__ribosome")) {
+      tracker.IncrementRibo(covered->gene(), 1);
+    }
+  });
+
+  pol->id(tracker.NextId());
+  Ribosome ribosome;
+  ribosome.id = pol->id();
+  ribosome.start = pol->start();
+  ribosome.stop = pol->stop();
+  ribosome.speed = pol->speed();
+  ribosome.name = Intern(pol->name());
+  ribosome.gene = Intern(pol->gene_bound());
+  ribosome.reading_frame = pol->reading_frame();
+  ribosome.terminate_at = TerminationPosition(ribosome);
+  double weight =
+      pol->name() == "__ribosome" ? weights()[ribosome.stop - 1] : 1.0;
+  auto it = std::upper_bound(ribosomes_.begin(), ribosomes_.end(), ribosome,
+                             [](const Ribosome &a, const Ribosome &b) {
+                               return a.start < b.start;
+                             });
+  props_.insert(props_.begin() + (it - ribosomes_.begin()),
+                weight * ribosome.speed);
+  ribosomes_.insert(it, ribosome);
+  prop_sum_ = std::accumulate(props_.begin(), props_.end(), 0.0);
+  tracker.journal_.LogPolymerase(id_, *pol);
+}
+
+int FlatTranscript::TerminationPosition(const Ribosome &ribosome) const {
+  // After each move, a ribosome terminates if it overlaps a stop codon of
+  // its gene in its reading frame
+  int footprint = ribosome.stop - ribosome.start + 1;
+  int position = std::numeric_limits<int>::max();
+  for (auto codon : stop_codons_) {
+    if (codon->gene() != *ribosome.gene ||
+        !codon->CheckInteraction(*ribosome.name, ribosome.reading_frame)) {
+      continue;
+    }
+    int first = std::max(codon->start(), ribosome.stop + 1);
+    if (first <= codon->stop() + footprint - 1) {
+      position = std::min(position, first);
+    }
+  }
+  return position;
+}
+
+void FlatTranscript::Execute() {
+  if (prop_sum_ == 0) {
+    throw std::runtime_error(
+        "Attempting to execute polymer with reaction propensity of 0.");
+  }
+  double target = Random::random() * prop_sum_;
+  double cumulative = 0;
+  int index = 0;
+  for (int i = 0; i < int(props_.size()); i++) {
+    if (props_[i] > 0) {
+      index = i;
+      cumulative += props_[i];
+      if (target < cumulative) {
+        break;
+      }
+    }
+  }
+  MoveRibosome(index);
+}
+
+void FlatTranscript::MoveRibosome(int index) {
+  auto &ribosome = ribosomes_[index];
+  int old_start = ribosome.start;
+  int old_stop = ribosome.stop;
+  // Blocked by the ribosome ahead
+  if (index + 1 < int(ribosomes_.size()) &&
+      old_stop + 1 >= ribosomes_[index + 1].start) {
+    return;
+  }
+  ribosome.start++;
+  ribosome.stop++;
+
+  auto &tracker = SpeciesTracker::Instance();
+  // Expose sites that the trailing edge has left
+  auto behind = Stopping(old_start);
+  for (int i = behind.first; i < behind.second; i++) {
+    auto site = sites_[by_stop_[i]];
+    site->Uncover();
+    if (site->WasUncovered()) {
+      LogUncover(site->name());
+      if (!site->first_exposure() && site->CheckInteraction("__ribosome")) {
+        tracker.IncrementTranscript(site->gene(), 1);
+        site->first_exposure(true);
+        total_elements_ += 1;
+      }
+    }
+    site->ResetState();
+  }
+  // Cover sites under the leading edge (as Polymer::CheckAhead(), one
+  // position behind it)
+  auto ahead = Starting(old_stop);
+  for (int i = ahead.first; i < ahead.second; i++) {
+    auto site = sites_[i];
+    if (site->stop() > old_stop) {
+      site->Cover();
+      if (site->WasCovered()) {
+        LogCover(site->name());
+      }
+      site->ResetState();
+    }
+  }
+
+  bool run_off = ribosome.stop >= stop_;
+  if (run_off || ribosome.stop >= ribosome.terminate_at) {
+    Ribosome released = ribosome;
+    ribosomes_.erase(ribosomes_.begin() + index);
+    props_.erase(props_.begin() + index);
+    prop_sum_ = std::accumulate(props_.begin(), props_.end(), 0.0);
+    termination_signal_.Emit(wrapper(), *released.name,
+                             run_off ? "NA" : *released.gene);
+    LogRibosome(released, true);
+    ForOverlapping(old_start, released.stop, [this](BindingSite *site) {
+      site->Uncover();
+      if (site->WasUncovered()) {
+        LogUncover(site->name());
+      }
+      site->ResetState();
+    });
+    return;
+  }
+  LogRibosome(ribosome);
+
+  if (*ribosome.name == "__ribosome") {
+    const auto &weights = *weights_;
+    if (ribosome.stop - 1 >= int(weights.size())) {
+      throw std::runtime_error("Weight is missing for this position.");
+    }
+    double prop = weights[ribosome.stop - 1] * ribosome.speed;
+    prop_sum_ += prop - props_[index];
+    props_[index] = prop;
+  }
+}
+
+void FlatTranscript::LogRibosome(const Ribosome &ribosome, bool released) {
+  auto &journal = SpeciesTracker::Instance().journal_;
+  if (journal.enabled()) {
+    journal.LogPolymerase(PolymeraseState{ribosome.id, id_, *ribosome.name,
+                                          ribosome.start, ribosome.stop,
+                                          released});
+  }
+}
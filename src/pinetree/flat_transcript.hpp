@@ -0,0 +1,108 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_FLAT_TRANSCRIPT_HPP  // header guard
+#define SRC_FLAT_TRANSCRIPT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "polymer.hpp"
+
+/**
+ * Transcript for translation-only models (see
+ * Model::EnableTranslationEngine()). A transcript that is not made by a genome
+ * has no mask, no polymerase making it and no RNases, so only ribosomes move
+ * on it. Instead of interval trees and a MobileElement per ribosome, it keeps
+ * ribosomes in a flat array ordered by position, and its binding sites in
+ * arrays indexed by the positions where they start and stop. The position at
+ * which each ribosome terminates is computed when it binds. Binding sites,
+ * species counts and termination signals behave exactly as on a Transcript.
+ */
+class FlatTranscript : public Transcript {
+ public:
+  /**
+   * Copy the layout of a transcript that has been registered but has no
+   * ribosomes bound yet.
+   *
+   * @param transcript transcript made with Transcript(name, length)
+   */
+  explicit FlatTranscript(const Transcript &transcript);
+  typedef std::shared_ptr<FlatTranscript> Ptr;
+  /**
+   * A ribosome bound to this transcript.
+   */
+  struct Ribosome {
+    int id;
+    int start;
+    int stop;
+    /**
+     * Stop position at which the ribosome reaches the stop codon of its gene
+     * (past the end of the transcript if it runs off instead).
+     */
+    int terminate_at;
+    double speed;
+    const std::string *name;
+    const std::string *gene;
+    int8_t reading_frame;
+  };
+  /**
+   * Register binding sites with SpeciesTracker and expose them.
+   */
+  void Initialize() override;
+  void Bind(MobileElement::Ptr pol, const std::string &promoter_name) override;
+  /**
+   * Move a ribosome chosen by its propensity and deal with collisions,
+   * binding sites and terminations.
+   */
+  void Execute() override;
+  void Unlink() override;
+  double prop_sum() override { return prop_sum_; }
+  const std::vector<Ribosome> &ribosomes() const { return ribosomes_; }
+
+ private:
+  /**
+   * Binding sites ordered by start position, and their indices ordered by
+   * stop position. The sites that start (or stop) at position p are
+   * sites_[start_offsets_[p - first_]] up to (but excluding)
+   * sites_[start_offsets_[p - first_ + 1]], and likewise for stops.
+   */
+  std::vector<BindingSite *> sites_;
+  std::vector<int> by_stop_;
+  std::vector<int> start_offsets_;
+  std::vector<int> stop_offsets_;
+  int first_ = 0;
+  int longest_site_ = 0;
+  /**
+   * Stop codons, which always terminate ribosomes of their gene.
+   */
+  std::vector<ReleaseSite *> stop_codons_;
+  /**
+   * Ribosomes ordered by position, and their movement propensities.
+   */
+  std::vector<Ribosome> ribosomes_;
+  std::vector<double> props_;
+  double prop_sum_ = 0;
+  /**
+   * Call `visit` with every binding site that overlaps [start, stop].
+   */
+  template <typename F>
+  void ForOverlapping(int start, int stop, F visit);
+  /**
+   * Binding sites that start (or stop) at `position`, as a range of
+   * offsets.
+   */
+  std::pair<int, int> Starting(int position) const;
+  std::pair<int, int> Stopping(int position) const;
+  /**
+   * Stop position at which a newly bound ribosome terminates.
+   */
+  int TerminationPosition(const Ribosome &ribosome) const;
+  /**
+   * Record the position of a ribosome in the change journal.
+   */
+  void LogRibosome(const Ribosome &ribosome, bool released = false);
+  void MoveRibosome(int index);
+};
+
+#endif  // header guard
@@ -0,0 +1,376 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "genbank.hpp"
+
+namespace {
+
+// Column at which feature locations and qualifiers begin
+const std::size_t kFeatureColumn = 21;
+
+std::string Trim(const std::string &text) {
+  auto first = text.find_first_not_of(" \t\r");
+  if (first == std::string::npos) {
+    return "";
+  }
+  auto last = text.find_last_not_of(" \t\r");
+  return text.substr(first, last - first + 1);
+}
+
+bool StartsWith(const std::string &text, const std::string &prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Parse a location such as "123..456", "complement(<1..>200)" or
+// "join(1..5,10..20)". Compound locations are reduced to their full span.
+void ParseLocation(const std::string &location, GenbankFeature &feature) {
+  feature.complement = location.find("complement(") != std::string::npos;
+  std::vector<int> positions;
+  int value = -1;
+  for (char c : location + " ") {
+    if (std::isdigit(static_cast<unsigned char>(c))) {
+      value = (value == -1 ? 0 : value * 10) + (c - '0');
+    } else if (value != -1) {
+      positions.push_back(value);
+      value = -1;
+    }
+  }
+  if (positions.empty()) {
+    throw std::invalid_argument("GenBank: could not parse location '" +
+                                location + "'.");
+  }
+  feature.start = *std::min_element(positions.begin(), positions.end());
+  feature.stop = *std::max_element(positions.begin(), positions.end());
+}
+
+// Finish a qualifier value: strip quotes and, for translations, whitespace
+// introduced by line wrapping.
+void FinishQualifier(GenbankFeature &feature) {
+  if (feature.qualifiers.empty()) {
+    return;
+  }
+  auto &qualifier = feature.qualifiers.back();
+  auto &value = qualifier.second;
+  if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+    value = value.substr(1, value.size() - 2);
+  }
+  if (qualifier.first == "translation") {
+    value.erase(std::remove(value.begin(), value.end(), ' '), value.end());
+  }
+}
+
+bool QuoteOpen(const std::string &value) {
+  return !value.empty() && value.front() == '"' &&
+         (value.size() == 1 || value.back() != '"');
+}
+
+const std::map<std::string, char> &CodonTable() {
+  static const std::map<std::string, char> table = [] {
+    const std::string bases = "TCAG";
+    const std::string amino_acids =
+        "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG";
+    std::map<std::string, char> codons;
+    int index = 0;
+    for (char first : bases) {
+      for (char second : bases) {
+        for (char third : bases) {
+          codons[std::string{first, second, third}] = amino_acids[index++];
+        }
+      }
+    }
+    return codons;
+  }();
+  return table;
+}
+
+std::string Translate(const std::string &nucleotides) {
+  std::string protein;
+  const auto &table = CodonTable();
+  for (std::size_t i = 0; i + 3 <= nucleotides.size(); i += 3) {
+    auto it = table.find(nucleotides.substr(i, 3));
+    char aa = (it == table.end()) ? 'X' : it->second;
+    if (aa == '*') {
+      break;
+    }
+    protein += aa;
+  }
+  return protein;
+}
+
+std::string Label(const GenbankFeature &feature, const GenbankRules &rules) {
+  const auto *label = feature.Qualifier(rules.label_qualifier);
+  return label == nullptr ? "" : *label;
+}
+
+bool HasRegulatoryClass(const GenbankFeature &feature,
+                        const std::string &regulatory_class) {
+  if (feature.type == regulatory_class) {
+    return true;
+  }
+  if (feature.type != "regulatory") {
+    return false;
+  }
+  for (const auto &qualifier : feature.qualifiers) {
+    if (qualifier.first == "regulatory_class" &&
+        qualifier.second == regulatory_class) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const std::map<std::string, double> *LookupParameters(
+    const std::map<std::string, std::map<std::string, double>> &parameters,
+    const GenbankRules &rules, const std::string &label) {
+  auto cls = rules.classes.find(label);
+  const std::string &key = (cls == rules.classes.end()) ? label : cls->second;
+  auto it = parameters.find(key);
+  return (it == parameters.end()) ? nullptr : &it->second;
+}
+
+}  // namespace
+
+const std::string *GenbankFeature::Qualifier(const std::string &key) const {
+  for (const auto &qualifier : qualifiers) {
+    if (qualifier.first == key) {
+      return &qualifier.second;
+    }
+  }
+  return nullptr;
+}
+
+GenbankRecord GenbankRecord::Read(std::istream &in) {
+  enum Section { kHeader, kFeatures, kOrigin };
+  GenbankRecord record;
+  Section section = kHeader;
+  bool in_location = false;
+  std::string location;
+  std::string line;
+
+  auto finish_feature = [&]() {
+    if (!record.features.empty()) {
+      if (in_location) {
+        ParseLocation(location, record.features.back());
+      }
+      FinishQualifier(record.features.back());
+    }
+    in_location = false;
+  };
+
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (StartsWith(line, "//")) {
+      break;
+    }
+    if (StartsWith(line, "LOCUS")) {
+      std::stringstream tokens(line.substr(5));
+      std::string length;
+      tokens >> record.name >> length;
+      try {
+        record.length_ = std::stoi(length);
+      } catch (const std::exception &) {
+        record.length_ = 0;
+      }
+      continue;
+    }
+    if (StartsWith(line, "FEATURES")) {
+      section = kFeatures;
+      continue;
+    }
+    if (StartsWith(line, "ORIGIN")) {
+      finish_feature();
+      section = kOrigin;
+      continue;
+    }
+    if (section == kFeatures) {
+      if (!line.empty() && line[0] != ' ') {
+        // Another top-level section (e.g. CONTIG or BASE COUNT)
+        finish_feature();
+        section = kHeader;
+        continue;
+      }
+      if (line.size() <= kFeatureColumn) {
+        continue;
+      }
+      std::string key = Trim(line.substr(0, kFeatureColumn));
+      std::string rest = Trim(line.substr(kFeatureColumn));
+      if (!key.empty()) {
+        // New feature
+        finish_feature();
+        GenbankFeature feature;
+        feature.type = key;
+        record.features.push_back(feature);
+        location = rest;
+        in_location = true;
+        continue;
+      }
+      if (record.features.empty()) {
+        continue;
+      }
+      auto &feature = record.features.back();
+      bool continuation = !feature.qualifiers.empty() &&
+                          QuoteOpen(feature.qualifiers.back().second);
+      if (!continuation && StartsWith(rest, "/")) {
+        if (in_location) {
+          ParseLocation(location, feature);
+          in_location = false;
+        }
+        FinishQualifier(feature);
+        auto equals = rest.find('=');
+        if (equals == std::string::npos) {
+          feature.qualifiers.emplace_back(rest.substr(1), "");
+        } else {
+          feature.qualifiers.emplace_back(rest.substr(1, equals - 1),
+                                          rest.substr(equals + 1));
+        }
+      } else if (in_location) {
+        location += rest;
+      } else if (!feature.qualifiers.empty()) {
+        feature.qualifiers.back().second += " " + rest;
+      }
+    } else if (section == kOrigin) {
+      for (char c : line) {
+        if (std::isalpha(static_cast<unsigned char>(c))) {
+          record.sequence += std::toupper(static_cast<unsigned char>(c));
+        }
+      }
+    }
+  }
+  if (section == kFeatures) {
+    finish_feature();
+  }
+  if (!record.sequence.empty()) {
+    record.length_ = record.sequence.size();
+  }
+  if (record.length_ <= 0) {
+    throw std::invalid_argument(
+        "GenBank: record has no LOCUS length or sequence.");
+  }
+  return record;
+}
+
+GenbankRecord GenbankRecord::FromFile(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Could not open GenBank file '" + path + "'.");
+  }
+  return Read(in);
+}
+
+std::vector<double> CodonWeights(const GenbankRecord &record,
+                                 const GenbankRules &rules) {
+  if (record.sequence.size() != static_cast<std::size_t>(record.length())) {
+    throw std::invalid_argument(
+        "GenBank: codon weights require the record sequence (ORIGIN).");
+  }
+  std::vector<double> weights(record.length(), 0.0);
+  for (const auto &feature : record.features) {
+    if (feature.type != "CDS" || feature.complement ||
+        rules.ignore.count(Label(feature, rules)) != 0) {
+      continue;
+    }
+    auto nuc_seq = record.sequence.substr(feature.start - 1,
+                                          feature.stop - feature.start + 1);
+    const auto *translation = feature.Qualifier("translation");
+    auto aa_seq = (translation == nullptr) ? Translate(nuc_seq) : *translation;
+    for (std::size_t index = 0; index < nuc_seq.size(); index++) {
+      std::size_t aa_index = index / 3;
+      if (aa_index >= aa_seq.size()) {
+        break;
+      }
+      double weight = 1.0;
+      auto optimal = rules.optimal_codons.find(aa_seq[aa_index]);
+      if (optimal != rules.optimal_codons.end()) {
+        auto codon = nuc_seq.substr(aa_index * 3, 3);
+        if (std::find(optimal->second.begin(), optimal->second.end(), codon) !=
+            optimal->second.end()) {
+          weight = rules.optimal_codon_weight;
+        }
+      }
+      weights[feature.start - 1 + index] = weight;
+    }
+  }
+  // Normalize over coding positions; non-coding positions get a weight of 1
+  double sum = 0;
+  int non_zero = 0;
+  for (double weight : weights) {
+    if (weight != 0) {
+      sum += weight;
+      non_zero++;
+    }
+  }
+  double mean = (non_zero == 0) ? 1.0 : sum / non_zero;
+  for (auto &weight : weights) {
+    weight = (weight == 0) ? 1.0 : weight / mean;
+  }
+  return weights;
+}
+
+Genome::Ptr BuildGenome(const GenbankRecord &record, const GenbankRules &rules,
+                        const std::string &name) {
+  auto genome = std::make_shared<Genome>(name.empty() ? record.name : name,
+                                         record.length());
+  for (const auto &feature : record.features) {
+    auto label = Label(feature, rules);
+    // Genomes are transcribed in one direction only
+    if (feature.complement || rules.ignore.count(label) != 0) {
+      continue;
+    }
+    auto renamed = rules.rename.find(label);
+    auto element_name =
+        (renamed == rules.rename.end()) ? label : renamed->second;
+    if (HasRegulatoryClass(feature, "promoter")) {
+      const auto *interactions =
+          LookupParameters(rules.promoter_interactions, rules, label);
+      if (interactions == nullptr) {
+        throw std::invalid_argument("GenBank: promoter strength for '" +
+                                    label + "' not assigned.");
+      }
+      // Short promoters are widened upstream of their start, so that a
+      // polymerase can bind them
+      int start = feature.start;
+      if (feature.stop - feature.start < rules.min_promoter_length) {
+        start = std::max(1, feature.start - rules.min_promoter_length);
+      }
+      genome->AddPromoter(element_name, start, feature.stop, *interactions);
+    } else if (HasRegulatoryClass(feature, "terminator")) {
+      const auto *interactions =
+          LookupParameters(rules.terminator_interactions, rules, label);
+      if (interactions == nullptr) {
+        if (rules.default_terminator_interactions.empty()) {
+          throw std::invalid_argument("GenBank: terminator efficiency for '" +
+                                      label + "' not assigned.");
+        }
+        interactions = &rules.default_terminator_interactions;
+      }
+      genome->AddTerminator(element_name, feature.start, feature.stop,
+                            *interactions);
+    } else if (feature.type == rules.gene_feature) {
+      if (element_name.empty()) {
+        throw std::invalid_argument("GenBank: gene at position " +
+                                    std::to_string(feature.start) +
+                                    " has no '" + rules.label_qualifier +
+                                    "' qualifier.");
+      }
+      genome->AddGene(element_name, feature.start, feature.stop,
+                      std::max(1, feature.start - rules.rbs_length),
+                      feature.start, rules.rbs_strength);
+    }
+  }
+  if (!rules.optimal_codons.empty()) {
+    genome->AddWeights(CodonWeights(record, rules));
+  }
+  return genome;
+}
+
+Genome::Ptr ReadGenbank(const std::string &path, const GenbankRules &rules,
+                        const std::string &name) {
+  return BuildGenome(GenbankRecord::FromFile(path), rules, name);
+}
@@ -0,0 +1,156 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_GENBANK_HPP  // header guard
+#define SRC_GENBANK_HPP
+
+#include <istream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "polymer.hpp"
+
+/**
+ * A single entry of the FEATURES table of a GenBank record. Coordinates are
+ * 1-based and inclusive, like the coordinates used by Genome.
+ */
+struct GenbankFeature {
+  std::string type;
+  int start = 0;
+  int stop = 0;
+  /**
+   * True if the feature lies on the reverse strand.
+   */
+  bool complement = false;
+  /**
+   * Qualifier values in file order. A qualifier may appear more than once.
+   */
+  std::vector<std::pair<std::string, std::string>> qualifiers;
+  /**
+   * Look up the first value of a qualifier.
+   *
+   * @return pointer to value, or nullptr if the qualifier is not present
+   */
+  const std::string *Qualifier(const std::string &key) const;
+};
+
+/**
+ * Features and sequence of a single-record GenBank flat file.
+ */
+struct GenbankRecord {
+  /**
+   * Name from the LOCUS line.
+   */
+  std::string name;
+  /**
+   * Upper-case nucleotide sequence from the ORIGIN section.
+   */
+  std::string sequence;
+  std::vector<GenbankFeature> features;
+  /**
+   * Parse the first record of a GenBank file.
+   */
+  static GenbankRecord Read(std::istream &in);
+  static GenbankRecord FromFile(const std::string &path);
+  /**
+   * Sequence length, or the LOCUS length if the file has no ORIGIN section.
+   */
+  int length() const { return length_; }
+
+ private:
+  int length_ = 0;
+};
+
+/**
+ * Rules that control how GenBank features are turned into promoters,
+ * terminators and genes. Features are identified by a label, the value of
+ * `label_qualifier` (e.g. "note" or "gene").
+ */
+struct GenbankRules {
+  /**
+   * Qualifier used to name features.
+   */
+  std::string label_qualifier = "note";
+  /**
+   * Feature type that defines genes (CDS weights always come from "CDS").
+   */
+  std::string gene_feature = "gene";
+  /**
+   * Labels of features to skip entirely.
+   */
+  std::set<std::string> ignore;
+  /**
+   * Map of original label to the name used in the Genome.
+   */
+  std::map<std::string, std::string> rename;
+  /**
+   * Map of label to parameter class (e.g. a promoter strength class). Labels
+   * without a class are looked up directly in the parameter maps below.
+   */
+  std::map<std::string, std::string> classes;
+  /**
+   * Map of class (or label) to polymerase binding constants.
+   */
+  std::map<std::string, std::map<std::string, double>> promoter_interactions;
+  /**
+   * Map of class (or label) to termination efficiencies.
+   */
+  std::map<std::string, std::map<std::string, double>> terminator_interactions;
+  /**
+   * Interactions for terminators not found in `terminator_interactions`. If
+   * empty, unmatched terminators are an error. Promoters must always match.
+   */
+  std::map<std::string, double> default_terminator_interactions;
+  /**
+   * Promoters shorter than this start this many positions further
+   * upstream.
+   */
+  int min_promoter_length = 35;
+  /**
+   * Length of ribosome binding site placed immediately upstream of each gene.
+   */
+  int rbs_length = 30;
+  /**
+   * Binding constant of each ribosome binding site.
+   */
+  double rbs_strength = 1e7;
+  /**
+   * Map of one-letter amino acid code to its preferred codons. When
+   * non-empty, translation weights are computed from CDS features: preferred
+   * codons get `optimal_codon_weight`, other codons 1.0, and the weights are
+   * normalized to a mean of 1.0 over all coding positions.
+   */
+  std::map<char, std::vector<std::string>> optimal_codons;
+  double optimal_codon_weight = 1.0;
+};
+
+/**
+ * Build a Genome directly from the features of a GenBank record.
+ *
+ * @param record parsed GenBank record
+ * @param rules rules for filtering, renaming and parameterizing features
+ * @param name name of Genome (defaults to the LOCUS name)
+ *
+ * @return pointer to a new Genome containing promoters, terminators, genes
+ *  and (optionally) codon-based translation weights
+ */
+Genome::Ptr BuildGenome(const GenbankRecord &record, const GenbankRules &rules,
+                        const std::string &name = "");
+
+/**
+ * Convenience wrapper that parses a GenBank file and builds a Genome.
+ */
+Genome::Ptr ReadGenbank(const std::string &path, const GenbankRules &rules,
+                        const std::string &name = "");
+
+/**
+ * Compute per-position translation weights from the CDS features of a
+ * record, as described for GenbankRules::optimal_codons.
+ *
+ * @return vector of weights with one entry per base pair
+ */
+std::vector<double> CodonWeights(const GenbankRecord &record,
+                                 const GenbankRules &rules);
+
+#endif  // header guard
@@ -0,0 +1,164 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "generator.hpp"
+
+namespace {
+
+// Layout of a genome segment, relative to the segment start
+const int kPromoterLength = 30;
+const int kRnaseSiteStart = 30;
+const int kRnaseSiteLength = 10;
+const int kRbsStart = 45;
+const int kGeneStart = 60;
+const int kTerminatorLength = 10;
+const int kMinGeneLength = 30;
+// Layout of a transcript segment
+const int kTranscriptRbsStart = 10;
+const int kTranscriptGeneStart = 25;
+const int kTranscriptGeneEnd = 5;
+
+void Check(bool condition, const std::string &message) {
+  if (!condition) {
+    throw std::invalid_argument("Model generator: " + message);
+  }
+}
+
+void CheckConfig(const GeneratorConfig &config) {
+  Check(config.num_genomes >= 0, "num_genomes must not be negative.");
+  Check(config.num_transcripts >= 0, "num_transcripts must not be negative.");
+  Check(config.num_genomes + config.num_transcripts > 0,
+        "model needs at least one genome or transcript.");
+  Check(config.cell_volume > 0, "cell_volume must be positive.");
+  if (config.num_genomes > 0) {
+    Check(config.num_genes > 0, "num_genes must be positive.");
+    Check(config.genome_length / config.num_genes >=
+              kGeneStart + kMinGeneLength + kTerminatorLength,
+          "genome_length is too short for num_genes (each gene needs " +
+              std::to_string(kGeneStart + kMinGeneLength + kTerminatorLength) +
+              " bp).");
+    Check(config.num_promoters >= 0 &&
+              config.num_promoters <= config.num_genes,
+          "num_promoters must be between 0 and num_genes.");
+    Check(config.num_rnase_sites >= 0 &&
+              config.num_rnase_sites <= config.num_genes,
+          "num_rnase_sites must be between 0 and num_genes.");
+    Check(config.promoter_strength_sigma >= 0,
+          "promoter_strength_sigma must not be negative.");
+  }
+  if (config.num_transcripts > 0) {
+    Check(config.transcript_genes > 0, "transcript_genes must be positive.");
+    Check(config.transcript_length / config.transcript_genes >=
+              kTranscriptGeneStart + kMinGeneLength + kTranscriptGeneEnd,
+          "transcript_length is too short for transcript_genes.");
+  }
+}
+
+// Pick `count` distinct indices from [0, n). Index 0 is always chosen first
+// if `include_first` is set.
+std::vector<bool> ChooseSegments(int n, int count, bool include_first,
+                                 std::mt19937 &rng) {
+  std::vector<int> indices(n);
+  std::iota(indices.begin(), indices.end(), 0);
+  int offset = (include_first && count > 0) ? 1 : 0;
+  std::shuffle(indices.begin() + offset, indices.end(), rng);
+  std::vector<bool> chosen(n, false);
+  for (int i = 0; i < count; i++) {
+    chosen[indices[i]] = true;
+  }
+  return chosen;
+}
+
+Transcript::Ptr GenerateTranscript(const GeneratorConfig &config, int index) {
+  auto name = "transcript" + std::to_string(index + 1);
+  auto transcript =
+      std::make_shared<Transcript>(name, config.transcript_length);
+  int segment = config.transcript_length / config.transcript_genes;
+  for (int i = 0; i < config.transcript_genes; i++) {
+    int start = i * segment + 1;
+    transcript->AddGene("tx_gene" + std::to_string(i + 1),
+                        start + kTranscriptGeneStart,
+                        start + segment - 1 - kTranscriptGeneEnd,
+                        start + kTranscriptRbsStart,
+                        start + kTranscriptGeneStart, config.rbs_strength);
+  }
+  return transcript;
+}
+
+}  // namespace
+
+Genome::Ptr GenerateGenome(const GeneratorConfig &config, int index,
+                           std::mt19937 &rng) {
+  auto prefix = "g" + std::to_string(index + 1) + "_";
+  // Only site-specific RNase binding; no external degradation
+  auto genome = std::make_shared<Genome>(
+      "genome" + std::to_string(index + 1), config.genome_length, 0.0,
+      config.rnase_speed, config.rnase_footprint);
+
+  int segment = config.genome_length / config.num_genes;
+  auto promoters =
+      ChooseSegments(config.num_genes, config.num_promoters, true, rng);
+  auto rnase_sites =
+      ChooseSegments(config.num_genes, config.num_rnase_sites, false, rng);
+  std::lognormal_distribution<double> strength(
+      std::log(config.promoter_strength), config.promoter_strength_sigma);
+
+  int promoter_count = 0;
+  int terminator_count = 0;
+  for (int i = 0; i < config.num_genes; i++) {
+    int start = i * segment + 1;
+    int stop = start + segment - 1;
+    if (promoters[i]) {
+      auto value = (config.promoter_strength_sigma == 0)
+                       ? config.promoter_strength
+                       : strength(rng);
+      genome->AddPromoter(prefix + "p" + std::to_string(++promoter_count),
+                          start, start + kPromoterLength - 1,
+                          {{config.polymerase_name, value}});
+    }
+    if (rnase_sites[i]) {
+      genome->AddRnaseSite(prefix + "rnase" + std::to_string(i + 1),
+                           start + kRnaseSiteStart,
+                           start + kRnaseSiteStart + kRnaseSiteLength - 1,
+                           config.rnase_rate);
+    }
+    genome->AddGene("gene" + std::to_string(i + 1), start + kGeneStart,
+                    stop - kTerminatorLength, start + kRbsStart,
+                    start + kGeneStart, config.rbs_strength);
+    // End the operon if the next segment starts a new one
+    bool last = (i == config.num_genes - 1);
+    if (last || promoters[i + 1]) {
+      genome->AddTerminator(
+          prefix + "t" + std::to_string(++terminator_count),
+          stop - kTerminatorLength + 1, stop,
+          {{config.polymerase_name,
+            last ? 1.0 : config.terminator_efficiency}});
+    }
+  }
+  return genome;
+}
+
+std::shared_ptr<Model> GenerateModel(const GeneratorConfig &config) {
+  CheckConfig(config);
+  std::mt19937 rng(config.seed);
+  auto model = std::make_shared<Model>(config.cell_volume);
+  model->seed(config.seed);
+  if (config.num_genomes > 0) {
+    model->AddPolymerase(config.polymerase_name, config.polymerase_footprint,
+                         config.polymerase_speed, config.polymerase_copies);
+  }
+  model->AddRibosome(config.ribosome_footprint, config.ribosome_speed,
+                     config.ribosome_copies);
+  for (int i = 0; i < config.num_genomes; i++) {
+    model->RegisterGenome(GenerateGenome(config, i, rng));
+  }
+  for (int i = 0; i < config.num_transcripts; i++) {
+    model->RegisterTranscript(GenerateTranscript(config, i));
+  }
+  return model;
+}
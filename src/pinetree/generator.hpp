@@ -0,0 +1,95 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_GENERATOR_HPP  // header guard
+#define SRC_GENERATOR_HPP
+
+#include <memory>
+#include <random>
+#include <string>
+
+#include "model.hpp"
+
+/**
+ * Parameters of a synthetic model, used to study how the simulation engine
+ * scales with model size.
+ *
+ * Each genome is divided into `num_genes` equal segments. A segment holds
+ * (in order) room for a promoter, room for an RNase site, a ribosome binding
+ * site and a gene. The first segment always has a promoter; the remaining
+ * promoters are assigned to randomly chosen segments, and every operon ends
+ * with a terminator just before the next promoter (or the end of the genome).
+ * Genomes share gene names, so they produce the same proteins, but have
+ * their own promoter, terminator and RNase site names and promoter strengths.
+ */
+struct GeneratorConfig {
+  /**
+   * Seed for the random choices made while building the model. The same
+   * seed is passed to Model::seed().
+   */
+  int seed = 1;
+  double cell_volume = 8e-16;
+  int num_genomes = 1;
+  int genome_length = 10000;
+  int num_genes = 10;
+  int num_promoters = 3;
+  /**
+   * Median polymerase binding constant of promoters.
+   */
+  double promoter_strength = 2e8;
+  /**
+   * Spread of promoter binding constants: the standard deviation of their
+   * natural logarithm (0 gives identical promoters).
+   */
+  double promoter_strength_sigma = 0.0;
+  /**
+   * Efficiency of terminators between operons. The terminator at the end of
+   * each genome always has an efficiency of 1.0.
+   */
+  double terminator_efficiency = 0.8;
+  std::string polymerase_name = "rnapol";
+  int polymerase_copies = 10;
+  double polymerase_speed = 40;
+  int polymerase_footprint = 10;
+  int ribosome_copies = 100;
+  double ribosome_speed = 30;
+  int ribosome_footprint = 10;
+  double rbs_strength = 1e7;
+  /**
+   * Number of internal RNase sites per genome, placed in randomly chosen
+   * segments. Transcripts are only degraded if this is non-zero.
+   */
+  int num_rnase_sites = 0;
+  double rnase_rate = 1e-2;
+  double rnase_speed = 20;
+  int rnase_footprint = 10;
+  /**
+   * Transcripts registered directly with the model, independently of any
+   * genome. They share gene names with each other but not with genomes.
+   */
+  int num_transcripts = 0;
+  int transcript_length = 1000;
+  int transcript_genes = 3;
+};
+
+/**
+ * Build a Genome from a synthetic layout.
+ *
+ * @param config generator parameters
+ * @param index index of this genome, used in element names
+ * @param rng random number generator for promoter positions, strengths and
+ *  RNase site positions
+ */
+Genome::Ptr GenerateGenome(const GeneratorConfig &config, int index,
+                           std::mt19937 &rng);
+
+/**
+ * Build a complete Model from synthetic genomes and transcripts. Building
+ * the model does not draw from the simulation's random number generator.
+ *
+ * @param config generator parameters
+ *
+ * @return seeded model with polymerases, ribosomes, genomes and transcripts
+ */
+std::shared_ptr<Model> GenerateModel(const GeneratorConfig &config);
+
+#endif  // header guard
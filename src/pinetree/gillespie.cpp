@@ -1,14 +1,23 @@
+#include <cmath>
+#include <limits>
+#include <numeric>
+
 #include "gillespie.hpp"
 #include "choices.hpp"
+#include "tracker.hpp"
 
 void Gillespie::LinkReaction(Reaction::Ptr reaction) {
   auto it = std::find(reactions_.begin(), reactions_.end(), reaction);
   if (it == reactions_.end()) {
     reaction->index(reactions_.size());
     double new_prop = reaction->CalculatePropensity();
+    evaluations_++;
     alpha_list_.push_back(new_prop);
     alpha_sum_ += new_prop;
     reactions_.push_back(reaction);
+    if (bounded_) {
+      AddBounds(reactions_.size() - 1);
+    }
   }
 }
 
@@ -21,8 +30,32 @@ void Gillespie::DeleteReaction(int index) {
   alpha_sum_ -= reactions_[index]->CalculatePropensity();
   // Remove from alpha list
   alpha_list_.erase(alpha_list_.begin() + index);
+  if (bounded_) {
+    upper_sum_ -= upper_list_[index];
+    lower_list_.erase(lower_list_.begin() + index);
+    upper_list_.erase(upper_list_.begin() + index);
+    bound_reactions_.erase(bound_reactions_.begin() + index);
+  }
   // Remove from reactions list
   reactions_.erase(reactions_.begin() + index);
+  removed_++;
+}
+
+void Gillespie::UnlinkReaction(Reaction::Ptr reaction) {
+  auto it = std::find(reactions_.begin(), reactions_.end(), reaction);
+  if (it == reactions_.end()) {
+    return;
+  }
+  auto index = std::distance(reactions_.begin(), it);
+  alpha_sum_ -= alpha_list_[index];
+  alpha_list_.erase(alpha_list_.begin() + index);
+  if (bounded_) {
+    upper_sum_ -= upper_list_[index];
+    lower_list_.erase(lower_list_.begin() + index);
+    upper_list_.erase(upper_list_.begin() + index);
+    bound_reactions_.erase(bound_reactions_.begin() + index);
+  }
+  reactions_.erase(it);
 }
 
 void Gillespie::UpdatePropensity(Reaction::Ptr reaction) {
@@ -35,42 +68,99 @@ void Gillespie::UpdatePropensity(Reaction::Ptr reaction) {
   // double diff = new_prop - alpha_list_[index];
   // alpha_sum_ += diff;
   // alpha_list_[index] = new_prop;
-  double alpha_diff = reaction->CalculatePropensity();
   auto it = std::find(reactions_.begin(), reactions_.end(), reaction);
-  if (it != reactions_.end()) {
-    auto index = std::distance(reactions_.begin(), it);
-    alpha_list_[index] += alpha_diff;
-  } else {
+  if (it == reactions_.end()) {
     // Don't throw an error unless everything has been initialized
-    if (initialized_ == true) {
+    if (initialized_ == true && !ignore_unlinked_) {
       throw std::runtime_error(
           "Attempting to update propensity of invalid reaction.");
     }
+    // The propensity of a reaction that is not linked yet is calculated when
+    // it is linked. Calculating it here would update the reaction's cached
+    // propensity without updating alpha_list_ (e.g. for autocatalytic
+    // reactions, whose products are also reactants).
+    return;
+  }
+  auto index = std::distance(reactions_.begin(), it);
+  if (bounded_ && bound_reactions_[index] != nullptr) {
+    // The bounds still hold unless a reactant count left its interval
+    if (!bound_reactions_[index]->InBounds()) {
+      SetBounds(index);
+    }
+    return;
   }
+  double alpha_diff = reaction->CalculatePropensity();
+  evaluations_++;
+  alpha_list_[index] += alpha_diff;
   alpha_sum_ += alpha_diff;
+  if (bounded_) {
+    upper_sum_ += alpha_diff;
+    lower_list_[index] = alpha_list_[index];
+    upper_list_[index] = alpha_list_[index];
+  }
+}
+
+void Gillespie::EnableRejectionSampling(double fluctuation) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Gillespie: Rejection sampling must be enabled before the first "
+        "iteration.");
+  }
+  if (fluctuation <= 0) {
+    throw std::invalid_argument(
+        "Gillespie: Fluctuation interval must be positive.");
+  }
+  fluctuation_ = fluctuation;
+}
+
+void Gillespie::AddBounds(std::size_t index) {
+  auto species_reaction =
+      std::dynamic_pointer_cast<SpeciesReaction>(reactions_[index]);
+  bool bound = species_reaction && species_reaction->bounded();
+  bound_reactions_.push_back(bound ? species_reaction.get() : nullptr);
+  lower_list_.push_back(alpha_list_[index]);
+  upper_list_.push_back(alpha_list_[index]);
+  upper_sum_ += alpha_list_[index];
+  if (bound) {
+    SetBounds(index);
+  }
+}
+
+void Gillespie::SetBounds(std::size_t index) {
+  auto reaction = bound_reactions_[index];
+  reaction->ComputeBounds(fluctuation_);
+  upper_sum_ += reaction->upper_bound() - upper_list_[index];
+  lower_list_[index] = reaction->lower_bound();
+  upper_list_[index] = reaction->upper_bound();
+}
+
+void Gillespie::ScheduleEvent(double time, std::function<void()> action) {
+  events_.emplace(time, std::move(action));
 }
 
 void Gillespie::Iterate() {
+  IterateUntil(std::numeric_limits<double>::infinity());
+}
+
+bool Gillespie::IterateUntil(double time_limit) {
   // Make sure propensities have been initialized
   if (initialized_ == false) {
     Initialize();
   }
 
-  // Basic sanity checks
-  if (alpha_sum_ <= 0) {
-    throw std::runtime_error(
-        "Gillespie: Propensity of system is 0. No reactions will execute.");
+  horizon_ = time_limit;
+  auto next_reaction = bounded_ ? SelectRejection() : SelectDirect();
+  if (next_reaction < 0) {
+    return false;
   }
-  double random_num = Random::random();
-  // Calculate tau, i.e. time until next reaction
-  double tau = (1.0 / alpha_sum_) * std::log(1.0 / random_num);
-  if (!std::isnormal(tau)) {
-    throw std::underflow_error("Underflow error.");
+  auto &observers = SpeciesTracker::Instance().observers_;
+  if (observers.active()) {
+    observers.time = time_;
   }
-  time_ += tau;
-  // Randomly select next reaction to execute, weighted by propensities
-  auto next_reaction = Random::WeightedChoiceIndex(reactions_, alpha_list_);
   reactions_[next_reaction]->Execute();
+  if (observers.active()) {
+    observers.Reaction(*reactions_[next_reaction]);
+  }
   // std::cout << std::to_string(alpha_list_[next_reaction]) << std::endl;
   UpdatePropensity(reactions_[next_reaction]);
   if (reactions_[next_reaction]->remove() == true) {
@@ -78,6 +168,90 @@ void Gillespie::Iterate() {
     DeleteReaction(next_reaction);
   }
   iteration_++;
+  return true;
+}
+
+double Gillespie::DrawTau(double total) {
+  // Basic sanity checks
+  if (total <= 0) {
+    if (events_.empty() && std::isinf(horizon_)) {
+      throw std::runtime_error(
+          "Gillespie: Propensity of system is 0. No reactions will execute.");
+    }
+    return std::numeric_limits<double>::infinity();
+  }
+  double random_num = Random::random();
+  // Calculate tau, i.e. time until next reaction
+  double tau = (1.0 / total) * std::log(1.0 / random_num);
+  if (!std::isnormal(tau)) {
+    throw std::underflow_error("Underflow error.");
+  }
+  return tau;
+}
+
+bool Gillespie::ApplyDueEvent(double tau) {
+  if (events_.empty() ||
+      events_.begin()->first > std::min(time_ + tau, horizon_)) {
+    return false;
+  }
+  // Apply the next scheduled action at its exact time. Waiting times are
+  // memoryless, so the time to the next reaction is drawn again afterwards
+  // with the new propensities.
+  auto event = events_.begin();
+  time_ = std::max(time_, event->first);
+  auto action = std::move(event->second);
+  events_.erase(event);
+  action();
+  return true;
+}
+
+int Gillespie::SelectDirect() {
+  double tau = DrawTau(alpha_sum_);
+  while (ApplyDueEvent(tau)) {
+    tau = DrawTau(alpha_sum_);
+  }
+  if (time_ + tau > horizon_) {
+    time_ = horizon_;
+    return -1;
+  }
+  time_ += tau;
+  // Randomly select next reaction to execute, weighted by propensities
+  return Random::WeightedChoiceIndex(reactions_, alpha_list_);
+}
+
+int Gillespie::SelectRejection() {
+  while (true) {
+    // Candidates arrive at the total upper bound; time advances for
+    // rejected candidates too
+    double tau = DrawTau(upper_sum_);
+    if (ApplyDueEvent(tau)) {
+      continue;
+    }
+    if (time_ + tau > horizon_) {
+      time_ = horizon_;
+      return -1;
+    }
+    time_ += tau;
+    auto candidate = Random::WeightedChoiceIndex(reactions_, upper_list_);
+    if (candidate >= int(reactions_.size())) {
+      // The running total has drifted above the sum of the bounds
+      upper_sum_ =
+          std::accumulate(upper_list_.begin(), upper_list_.end(), 0.0);
+      continue;
+    }
+    double threshold = Random::random() * upper_list_[candidate];
+    if (threshold <= lower_list_[candidate]) {
+      return candidate;
+    }
+    // Only now is the exact propensity needed
+    double alpha_diff = reactions_[candidate]->CalculatePropensity();
+    evaluations_++;
+    alpha_list_[candidate] += alpha_diff;
+    alpha_sum_ += alpha_diff;
+    if (threshold <= alpha_list_[candidate]) {
+      return candidate;
+    }
+  }
 }
 
 void Gillespie::Initialize() {
@@ -95,5 +269,11 @@ void Gillespie::Initialize() {
   // for (const auto &alpha : alpha_list_) {
   //  alpha_sum_ += alpha;
   // }
+  if (fluctuation_ > 0) {
+    bounded_ = true;
+    for (std::size_t i = 0; i < reactions_.size(); i++) {
+      AddBounds(i);
+    }
+  }
   initialized_ = true;
 }
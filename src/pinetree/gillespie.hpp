@@ -1,6 +1,10 @@
 #ifndef SRC_GILLESPIE_HPP  // header guard
 #define SRC_GILLESPIE_HPP
 
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <map>
 #include <vector>
 
 #include "reaction.hpp"
@@ -15,24 +19,93 @@ class Gillespie {
    * Remove Reaction object from reaction queue.
    */
   void DeleteReaction(int index);
+  /**
+   * Remove a reaction that was linked but will never execute (e.g. because
+   * one of its reactants can never be produced). Unlike DeleteReaction(),
+   * this is not counted in removed().
+   */
+  void UnlinkReaction(Reaction::Ptr reaction);
   /**
    * Update propensity of a reaction.
    */
   void UpdatePropensity(Reaction::Ptr reaction);
   /**
-   * Execute one iteration of the gillespie algorithm.
+   * Schedule an action at a fixed simulated time. The action is applied
+   * exactly at that time, between reactions, and may change species counts,
+   * rate constants or the set of reactions. Actions scheduled for the same
+   * time are applied in the order they were scheduled.
+   */
+  void ScheduleEvent(double time, std::function<void()> action);
+  /**
+   * Select reactions with the rejection-based SSA (Thanh, Priami and
+   * Zunino, 2014) instead of the direct method. Species reactions keep
+   * bounds on their propensity that hold while the count of each reactant
+   * stays within `fluctuation` (a fraction of its count, and at least one
+   * copy) of the count when the bounds were computed. Candidates are drawn
+   * from the upper bounds and accepted against the lower bound, so their
+   * exact propensity is only computed when that test fails, and bounds are
+   * recomputed only when a count leaves its interval. Other reactions keep
+   * exact propensities. Must be called before the first iteration.
+   */
+  void EnableRejectionSampling(double fluctuation);
+  /**
+   * Ignore propensity updates of reactions that are not in the queue once it
+   * is initialized, instead of throwing. Used when polymers are simulated
+   * outside of the queue (see Model::EnableParallel()).
+   */
+  void ignore_unlinked(bool ignore) { ignore_unlinked_ = ignore; }
+  /**
+   * Execute one iteration of the gillespie algorithm: apply every scheduled
+   * action that is due before the next reaction, then execute the reaction.
    */
   void Iterate();
+  /**
+   * Like Iterate(), but stop at `time_limit` instead of executing a reaction
+   * (or applying a scheduled action) that would happen after it. Waiting
+   * times are memoryless, so iterating again later gives the same dynamics.
+   *
+   * @return true if a reaction was executed, false if time is now time_limit
+   */
+  bool IterateUntil(double time_limit);
   /**
    * Getters and setters.
    */
   double time() { return time_; }
+  /**
+   * Address of the simulated time, for readers that need it on every change
+   * of a count.
+   */
+  const double *clock() const { return &time_; }
+  long iteration() const { return iteration_; }
+  /**
+   * Number of reactions that have been removed from the reaction queue (i.e.
+   * degraded transcripts).
+   */
+  long removed() const { return removed_; }
+  /**
+   * Number of times the propensity of a reaction has been calculated.
+   */
+  long propensity_evaluations() const { return evaluations_; }
+  /**
+   * Number of scheduled actions that have not been applied yet.
+   */
+  int pending_events() const { return events_.size(); }
+  /**
+   * Total propensity of the reactions in the queue (the sum of their upper
+   * bounds with rejection sampling).
+   */
+  double propensity() const { return bounded_ ? upper_sum_ : alpha_sum_; }
+  /**
+   * Reactions in the queue, including one PolymerWrapper per polymer.
+   */
+  const Reaction::VecPtr &reactions() const { return reactions_; }
 
  private:
   /**
    * True if Initialize() has been called.
    */
   bool initialized_ = false;
+  bool ignore_unlinked_ = false;
   /**
    * Current simulation time.
    */
@@ -40,7 +113,12 @@ class Gillespie {
   /**
    * Current simulation iteration.
    */
-  int iteration_ = 0;
+  long iteration_ = 0;
+  /**
+   * Running count of removed reactions.
+   */
+  long removed_ = 0;
+  long evaluations_ = 0;
   /**
    * Vector of individual reaction propensities in same order as reactions_.
    */
@@ -53,10 +131,58 @@ class Gillespie {
    * Vector of all reactions.
    */
   Reaction::VecPtr reactions_;
+  /**
+   * Scheduled actions, ordered by time.
+   */
+  std::multimap<double, std::function<void()>> events_;
+  /**
+   * Time that the current iteration must not pass.
+   */
+  double horizon_ = std::numeric_limits<double>::infinity();
+  /**
+   * Fluctuation interval for rejection-based sampling (0 for the direct
+   * method), and whether the bounds below are in use.
+   */
+  double fluctuation_ = 0;
+  bool bounded_ = false;
+  /**
+   * Lower and upper propensity bounds in same order as reactions_, and the
+   * species reactions they are computed from (null for reactions with exact
+   * bounds). For species reactions, alpha_list_ holds the propensity when it
+   * was last calculated.
+   */
+  std::vector<double> lower_list_;
+  std::vector<double> upper_list_;
+  std::vector<SpeciesReaction *> bound_reactions_;
+  double upper_sum_ = 0;
   /**
    * Compute all propensities after all reactions have been added.
    */
   void Initialize();
+  /**
+   * Apply the next scheduled action if it is due within `tau` of the
+   * current time.
+   *
+   * @return true if an action was applied
+   */
+  bool ApplyDueEvent(double tau);
+  /**
+   * Draw the time to the next reaction at total propensity `total`
+   * (infinite if it is 0).
+   */
+  double DrawTau(double total);
+  /**
+   * Advance time to the next reaction and select it, with the direct method
+   * or by rejection sampling (-1 if it would happen after horizon_).
+   */
+  int SelectDirect();
+  int SelectRejection();
+  /**
+   * Add the reaction at `index` (the last one with bounds so far) to the
+   * bounds, or recompute its bounds.
+   */
+  void AddBounds(std::size_t index);
+  void SetBounds(std::size_t index);
 };
 
 #endif  // header guard
\ No newline at end of file
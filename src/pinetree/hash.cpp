@@ -0,0 +1,68 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <cstdio>
+#include <cstring>
+
+#include "hash.hpp"
+
+void Fnv1a::AddBytes(const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash_ ^= bytes[i];
+    hash_ *= 1099511628211ULL;
+  }
+}
+
+Fnv1a &Fnv1a::Add(int value) {
+  int64_t wide = value;
+  AddBytes(&wide, sizeof(wide));
+  return *this;
+}
+
+Fnv1a &Fnv1a::Add(double value) {
+  // Treat -0.0 as 0.0, so that equal numbers hash equally
+  if (value == 0) {
+    value = 0;
+  }
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  AddBytes(&bits, sizeof(bits));
+  return *this;
+}
+
+Fnv1a &Fnv1a::Add(const std::string &value) {
+  Add(int(value.size()));
+  AddBytes(value.data(), value.size());
+  return *this;
+}
+
+Fnv1a &Fnv1a::Add(const std::vector<double> &values) {
+  Add(int(values.size()));
+  for (double value : values) {
+    Add(value);
+  }
+  return *this;
+}
+
+Fnv1a &Fnv1a::Add(const std::vector<std::string> &values) {
+  Add(int(values.size()));
+  for (const auto &value : values) {
+    Add(value);
+  }
+  return *this;
+}
+
+Fnv1a &Fnv1a::Add(const std::map<std::string, double> &values) {
+  Add(int(values.size()));
+  for (const auto &item : values) {
+    Add(item.first).Add(item.second);
+  }
+  return *this;
+}
+
+std::string Fnv1a::hex() const {
+  char digits[17];
+  std::snprintf(digits, sizeof(digits), "%016llx",
+                static_cast<unsigned long long>(hash_));
+  return digits;
+}
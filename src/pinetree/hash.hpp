@@ -0,0 +1,36 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_HASH_HPP  // header guard
+#define SRC_HASH_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * 64-bit FNV-1a hash of a sequence of values, used to identify model
+ * definitions. Numbers are hashed by their exact bit patterns and strings and
+ * containers are prefixed with their length, so that different sequences of
+ * values cannot run together into the same bytes.
+ */
+class Fnv1a {
+ public:
+  Fnv1a &Add(int value);
+  Fnv1a &Add(double value);
+  Fnv1a &Add(const std::string &value);
+  Fnv1a &Add(const std::vector<double> &values);
+  Fnv1a &Add(const std::vector<std::string> &values);
+  Fnv1a &Add(const std::map<std::string, double> &values);
+  uint64_t value() const { return hash_; }
+  /**
+   * Hash as 16 hexadecimal digits.
+   */
+  std::string hex() const;
+
+ private:
+  uint64_t hash_ = 14695981039346656037ULL;
+  void AddBytes(const void *data, size_t size);
+};
+
+#endif  // header guard
@@ -0,0 +1,15 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <mutex>
+#include <unordered_set>
+
+#include "intern.hpp"
+
+const std::string *Intern(const std::string &name) {
+  // Nodes of an unordered_set never move, so pointers to its elements
+  // survive rehashing
+  static std::unordered_set<std::string> names;
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  return &*names.insert(name).first;
+}
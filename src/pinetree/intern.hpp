@@ -0,0 +1,21 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_INTERN_HPP  // header guard
+#define SRC_INTERN_HPP
+
+#include <string>
+
+/**
+ * Return the single shared copy of `name`. The same element, gene, and
+ * polymerase names repeat on every copy of a polymer, so elements store a
+ * pointer to the interned name instead of their own string. Interned names
+ * are never freed, and pointers to them stay valid for the lifetime of the
+ * program. Safe to call from multiple threads.
+ *
+ * @param name name to intern
+ *
+ * @return pointer to the interned copy of name
+ */
+const std::string *Intern(const std::string &name);
+
+#endif  // SRC_INTERN_HPP
@@ -0,0 +1,40 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include "journal.hpp"
+
+void ChangeJournal::Enable(const std::map<std::string, int> &species) {
+  if (enabled_) {
+    return;
+  }
+  enabled_ = true;
+  for (const auto &elem : species) {
+    species_.insert(elem.first);
+  }
+}
+
+void ChangeJournal::Clear() {
+  enabled_ = false;
+  species_.clear();
+  polymerases_.clear();
+  created_.clear();
+  destroyed_.clear();
+}
+
+ChangeDelta ChangeJournal::Collect(double time,
+                                   const std::map<std::string, int> &species) {
+  ChangeDelta delta;
+  delta.time = time;
+  for (const auto &name : species_) {
+    auto it = species.find(name);
+    delta.species[name] = (it == species.end()) ? 0 : it->second;
+  }
+  delta.polymerases.reserve(polymerases_.size());
+  for (const auto &elem : polymerases_) {
+    delta.polymerases.push_back(elem.second);
+  }
+  delta.transcripts_created.swap(created_);
+  delta.transcripts_destroyed.swap(destroyed_);
+  species_.clear();
+  polymerases_.clear();
+  return delta;
+}
@@ -0,0 +1,149 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_JOURNAL_HPP  // header guard
+#define SRC_JOURNAL_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "deferred.hpp"
+#include "feature.hpp"
+
+/**
+ * Position of a polymerase, ribosome or RNase at the end of a step.
+ */
+struct PolymeraseState {
+  /**
+   * Unique id of the mobile element.
+   */
+  int id;
+  /**
+   * Id of the genome or transcript the mobile element is bound to.
+   */
+  int polymer_id;
+  std::string name;
+  int start;
+  int stop;
+  /**
+   * True if the mobile element has left the polymer.
+   */
+  bool released;
+};
+
+/**
+ * A transcript created during a step. Coordinates are genomic coordinates.
+ */
+struct TranscriptState {
+  int id;
+  std::string name;
+  int start;
+  int stop;
+};
+
+/**
+ * Everything that changed between two calls to ChangeJournal::Collect().
+ */
+struct ChangeDelta {
+  /**
+   * Simulated time at which the delta was collected.
+   */
+  double time = 0;
+  /**
+   * New copy numbers of species whose count changed.
+   */
+  std::map<std::string, int> species;
+  /**
+   * Final states of mobile elements that bound, moved or were released, in
+   * order of id.
+   */
+  std::vector<PolymeraseState> polymerases;
+  /**
+   * Transcripts that were created.
+   */
+  std::vector<TranscriptState> transcripts_created;
+  /**
+   * Ids of transcripts that were completely degraded.
+   */
+  std::vector<int> transcripts_destroyed;
+};
+
+/**
+ * Records changes to species counts, polymerase positions and transcripts so
+ * that callers can update a view of the simulation incrementally. Changes are
+ * coalesced: a polymerase that moved many times appears once, with its final
+ * position. Recording is off until Enable() is called.
+ */
+class ChangeJournal {
+ public:
+  /**
+   * Start recording. The first delta reports all current species counts.
+   *
+   * @param species current species counts
+   */
+  void Enable(const std::map<std::string, int> &species);
+  /**
+   * Stop recording and discard any recorded changes.
+   */
+  void Clear();
+  bool enabled() const { return enabled_; }
+  /**
+   * Record that the count of a species changed.
+   */
+  void LogSpecies(const std::string &name) {
+    if (enabled_) {
+      species_.insert(name);
+    }
+  }
+  /**
+   * Record the current position of a mobile element.
+   *
+   * @param polymer_id id of polymer that pol is bound to
+   * @param pol mobile element that bound or moved
+   * @param released true if pol is leaving the polymer
+   */
+  void LogPolymerase(int polymer_id, const MobileElement &pol,
+                     bool released = false) {
+    if (enabled_) {
+      LogPolymerase(PolymeraseState{pol.id(), polymer_id, pol.name(),
+                                    pol.start(), pol.stop(), released});
+    }
+  }
+  void LogPolymerase(const PolymeraseState &state) {
+    auto store = [this](const PolymeraseState &state) {
+      polymerases_[state.id] = state;
+    };
+    if (enabled_ && !Defer(store, state)) {
+      store(state);
+    }
+  }
+  void LogTranscriptCreated(int id, const std::string &name, int start,
+                            int stop) {
+    if (enabled_) {
+      created_.push_back(TranscriptState{id, name, start, stop});
+    }
+  }
+  void LogTranscriptDestroyed(int id) {
+    if (enabled_ &&
+        !Defer(&ChangeJournal::LogTranscriptDestroyed, this, id)) {
+      destroyed_.push_back(id);
+    }
+  }
+  /**
+   * Return all changes recorded since the last call and start a new delta.
+   *
+   * @param time current simulated time
+   * @param species current species counts
+   */
+  ChangeDelta Collect(double time, const std::map<std::string, int> &species);
+
+ private:
+  bool enabled_ = false;
+  std::set<std::string> species_;
+  std::map<int, PolymeraseState> polymerases_;
+  std::vector<TranscriptState> created_;
+  std::vector<int> destroyed_;
+};
+
+#endif  // header guard
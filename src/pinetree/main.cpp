@@ -0,0 +1,245 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+/**
+ * Standalone command line runner. Loads a model file, simulates it and
+ * writes species counts to a tab-separated output file.
+ *
+ * Usage: pinetree MODEL_FILE [--seed SEED] [--output PATH] [--stats PATH]
+ *                 [--prune] [--slow-scale] [--rssa] [--parallel THREADS]
+ *                 [--observer LIBRARY[:ARGS]] [--cache DIR]
+ *                 [--replicates N [--workers WORKERS]]
+ *                 [--averages] [--extremes]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model_file.hpp"
+
+namespace {
+
+void PrintUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " MODEL_FILE [--seed SEED] [--output PATH] [--stats PATH]"
+               " [--prune] [--slow-scale] [--rssa] [--parallel THREADS]"
+               " [--observer LIBRARY[:ARGS]] [--cache DIR]"
+               " [--replicates N [--workers WORKERS]]"
+               " [--averages] [--extremes]\n\n"
+               "Simulate a pinetree model file and write species counts.\n\n"
+               "  -s, --seed SEED    random seed (overrides model file)\n"
+               "  -o, --output PATH  output file (default: counts.tsv)\n"
+               "  --stats PATH       write run statistics as JSON to PATH\n"
+               "  --prune            drop reactions and species that can never "
+               "change\n"
+               "  --slow-scale       hold fast reversible reactions in "
+               "quasi-equilibrium\n"
+               "  --rssa             select reactions with the rejection-based "
+               "SSA\n"
+               "  --parallel THREADS move polymerases and ribosomes on THREADS "
+               "threads\n"
+               "  --observer LIBRARY[:ARGS]\n"
+               "                     load an observer plugin, passing ARGS "
+               "to it\n"
+               "  --cache DIR        reuse output of identical earlier runs "
+               "cached in DIR\n"
+               "  --replicates N     run N replicates with seeds SEED to "
+               "SEED + N - 1\n"
+               "                     and write them to one output file with "
+               "a seed column\n"
+               "  --workers WORKERS  number of worker processes for "
+               "--replicates\n"
+               "                     (default: number of cores)\n"
+               "  --averages         write averages over each time step "
+               "instead of\n"
+               "                     counts at each output time\n"
+               "  --extremes         like --averages, adding minimum and "
+               "maximum columns\n"
+               "  -h, --help         show this message\n";
+}
+
+void WriteStats(const std::string &path, const std::string &model_path,
+                int seed, double wall_time, const SimulationStats &stats,
+                const std::string &output) {
+  std::ifstream counts(output, std::ios::binary | std::ios::ate);
+  long output_bytes = counts ? long(counts.tellg()) : 0;
+  std::ofstream out(path);
+  if (!out) {
+    throw std::runtime_error("Could not open stats file '" + path + "'.");
+  }
+  out << "{\"model\": \"" << model_path << "\", \"seed\": " << seed
+      << ", \"events\": " << stats.events << ", \"wall_time\": " << wall_time
+      << ", \"events_per_second\": "
+      << (wall_time > 0 ? stats.events / wall_time : 0)
+      << ", \"peak_transcripts\": " << stats.peak_transcripts
+      << ", \"propensity_evaluations\": " << stats.propensity_evaluations
+      << ", \"output_bytes\": " << output_bytes
+      << ", \"cached\": " << (stats.cached ? "true" : "false") << "}\n";
+}
+
+void PrintPruned(const PruneReport &report) {
+  std::cerr << "Pruned " << report.reactions.size() << " reactions and "
+            << report.species.size() << " species.\n";
+  for (const auto &reaction : report.reactions) {
+    std::cerr << "  reaction: " << reaction << "\n";
+  }
+  for (const auto &species : report.species) {
+    std::cerr << "  species: " << species << "\n";
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  std::string model_path;
+  std::string output = "counts.tsv";
+  std::string stats_path;
+  int seed = -1;
+  bool has_seed = false;
+  bool prune = false;
+  bool slow_scale = false;
+  bool rssa = false;
+  int threads = 0;
+  std::vector<std::string> observers;
+  std::string cache;
+  int replicates = 0;
+  bool averages = false;
+  bool extremes = false;
+  int workers = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      return 0;
+    } else if ((arg == "-s" || arg == "--seed") && i + 1 < argc) {
+      try {
+        seed = std::stoi(argv[++i]);
+      } catch (const std::exception &) {
+        std::cerr << "Invalid seed '" << argv[i] << "'." << std::endl;
+        return 2;
+      }
+      has_seed = true;
+    } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+      output = argv[++i];
+    } else if (arg == "--stats" && i + 1 < argc) {
+      stats_path = argv[++i];
+    } else if (arg == "--prune") {
+      prune = true;
+    } else if (arg == "--slow-scale") {
+      slow_scale = true;
+    } else if (arg == "--rssa") {
+      rssa = true;
+    } else if (arg == "--parallel" && i + 1 < argc) {
+      try {
+        threads = std::stoi(argv[++i]);
+      } catch (const std::exception &) {
+        std::cerr << "Invalid thread count '" << argv[i] << "'." << std::endl;
+        return 2;
+      }
+    } else if (arg == "--observer" && i + 1 < argc) {
+      observers.push_back(argv[++i]);
+    } else if (arg == "--cache" && i + 1 < argc) {
+      cache = argv[++i];
+    } else if (arg == "--averages") {
+      averages = true;
+    } else if (arg == "--extremes") {
+      averages = true;
+      extremes = true;
+    } else if (arg == "--replicates" && i + 1 < argc) {
+      try {
+        replicates = std::stoi(argv[++i]);
+      } catch (const std::exception &) {
+        std::cerr << "Invalid replicate count '" << argv[i] << "'."
+                  << std::endl;
+        return 2;
+      }
+    } else if (arg == "--workers" && i + 1 < argc) {
+      try {
+        workers = std::stoi(argv[++i]);
+      } catch (const std::exception &) {
+        std::cerr << "Invalid worker count '" << argv[i] << "'." << std::endl;
+        return 2;
+      }
+    } else if (arg[0] == '-' || !model_path.empty()) {
+      PrintUsage(argv[0]);
+      return 2;
+    } else {
+      model_path = arg;
+    }
+  }
+  if (model_path.empty()) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+
+  try {
+    auto model_file = ModelFile::FromFile(model_path);
+    auto model = model_file.Build();
+    if (has_seed) {
+      model->seed(seed);
+    }
+    if (!cache.empty()) {
+      model->EnableCache(cache);
+    }
+    for (const auto &observer : observers) {
+      auto colon = observer.find(':');
+      if (colon == std::string::npos) {
+        model->LoadObserver(observer);
+      } else {
+        model->LoadObserver(observer.substr(0, colon),
+                            observer.substr(colon + 1));
+      }
+    }
+    if (slow_scale) {
+      model->EnableSlowScale();
+    }
+    if (rssa) {
+      model->EnableRejectionSampling();
+    }
+    if (threads > 0) {
+      model->EnableParallel(threads);
+    }
+    if (averages) {
+      model->EnableTimeAverages(extremes);
+    }
+    if (prune) {
+      model->EnablePruning();
+      model->Initialize();
+      PrintPruned(model->pruned());
+    }
+    const auto &params = model_file.simulation();
+    if (replicates > 0) {
+      int first = has_seed ? seed : std::max(params.seed, 0);
+      std::vector<int> seeds;
+      for (int i = 0; i < replicates; i++) {
+        seeds.push_back(first + i);
+      }
+      auto report = model->SimulateEnsemble(seeds, params.runtime,
+                                            params.time_step, output, workers);
+      for (std::size_t i = 0; i < report.failed.size(); i++) {
+        std::cerr << "Replicate with seed " << report.failed[i]
+                  << " failed: " << report.errors[i] << std::endl;
+      }
+      std::cout << report.completed.size() << " of " << replicates
+                << " replicates completed." << std::endl;
+      return report.failed.empty() ? 0 : 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    model->Simulate(params.runtime, params.time_step, output);
+    std::chrono::duration<double> wall_time =
+        std::chrono::steady_clock::now() - start;
+    if (!stats_path.empty()) {
+      WriteStats(stats_path, model_path, has_seed ? seed : params.seed,
+                 wall_time.count(), model->stats(), output);
+    }
+  } catch (const std::exception &err) {
+    std::cerr << "Error: " << err.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
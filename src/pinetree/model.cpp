@@ -1,41 +1,658 @@
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <sys/stat.h>
+#include <thread>
+
+// MSVC provides stat() but not the POSIX file type macros
+#if !defined(S_ISDIR) && defined(S_IFDIR)
+#define S_ISDIR(mode) (((mode)&S_IFMT) == S_IFDIR)
+#endif
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "choices.hpp"
+#include "deferred.hpp"
+#include "ensemble.hpp"
 #include "model.hpp"
 #include "polymer.hpp"
 #include "tracker.hpp"
 
+namespace {
+
+// Mean-field lattice for the gene that starts at `rbs`, with the elongation
+// rates of a ribosome at each position between the binding site and the stop
+// codon of the gene
+MeanFieldTasep GeneLattice(const BindingSite::Ptr &rbs,
+                           const std::vector<Interval<ReleaseSite::Ptr>> &stops,
+                           const std::vector<double> &weights,
+                           const Polymerase &ribosome) {
+  ReleaseSite::Ptr stop_codon;
+  for (const auto &interval : stops) {
+    if (interval.value->gene() == rbs->gene()) {
+      stop_codon = interval.value;
+    }
+  }
+  if (!stop_codon) {
+    throw std::runtime_error("Mean-field translation: no stop codon for " +
+                             rbs->gene() + ".");
+  }
+  // A ribosome binds with its leading edge at rbs start + footprint - 1 and
+  // terminates when the leading edge reaches the stop codon
+  std::vector<double> rates;
+  for (int pos = rbs->start() + ribosome.footprint() - 1;
+       pos < stop_codon->start(); pos++) {
+    if (pos < 1 || pos > int(weights.size())) {
+      throw std::runtime_error("Mean-field translation: " + rbs->gene() +
+                               " extends past the end of its polymer.");
+    }
+    rates.push_back(ribosome.speed() * weights[pos - 1]);
+  }
+  return MeanFieldTasep(rates, ribosome.footprint(),
+                        rbs->stop() - rbs->start() + 1);
+}
+
+// Version of the simulation engine; results cached by another version are
+// not reused. Editable installs and development builds keep their version
+// number across engine changes, so builds are also told apart by commit and
+// compile time (CMake rebuilds this file whenever any engine source changes).
+#ifndef VERSION_INFO
+#define VERSION_INFO "development version"
+#endif
+#ifndef BUILD_ID
+#define BUILD_ID ""
+#endif
+const char *kEngineVersion =
+    "pinetree " VERSION_INFO " " BUILD_ID " " __DATE__ " " __TIME__;
+
+template <typename T>
+void HashSites(Fnv1a &hash, const std::vector<Interval<T>> &intervals) {
+  hash.Add(int(intervals.size()));
+  for (const auto &interval : intervals) {
+    const auto &site = *interval.value;
+    hash.Add(site.name())
+        .Add(site.start())
+        .Add(site.stop())
+        .Add(site.gene())
+        .Add(site.reading_frame())
+        .Add(site.interactions());
+  }
+}
+
+void HashPolymer(Fnv1a &hash, Polymer &polymer) {
+  const auto &mask = polymer.GetMask();
+  hash.Add(polymer.name())
+      .Add(polymer.start())
+      .Add(polymer.stop())
+      .Add(mask.start())
+      .Add(mask.stop())
+      .Add(mask.interactions())
+      .Add(polymer.weights());
+  HashSites(hash, polymer.GetBindingIntervals());
+  HashSites(hash, polymer.GetReleaseIntervals());
+}
+
+void HashGenome(Fnv1a &hash, Genome &genome) {
+  HashPolymer(hash, genome);
+  HashSites(hash, genome.GetTranscriptRbsIntervals());
+  HashSites(hash, genome.GetTranscriptStopSiteIntervals());
+  hash.Add(genome.transcript_weights())
+      .Add(genome.transcript_degradation_rate())
+      .Add(genome.transcript_degradation_rate_ext())
+      .Add(genome.rnase_speed())
+      .Add(genome.rnase_footprint())
+      .Add(genome.rnase_bindings());
+}
+
+// Describe a species reaction, e.g. "X + Y -> Z"
+std::string DescribeReaction(const std::vector<std::string> &reactants,
+                             const std::vector<std::string> &products,
+                             const std::string &arrow = "->") {
+  auto join = [](const std::vector<std::string> &names) {
+    std::string joined;
+    for (const auto &name : names) {
+      joined += (joined.empty() ? "" : " + ") + name;
+    }
+    return joined.empty() ? std::string("(none)") : joined;
+  };
+  return join(reactants) + " " + arrow + " " + join(products);
+}
+
+bool CopyFile(const std::string &from, const std::string &to) {
+  std::ifstream in(from, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::ofstream out(to, std::ios::binary | std::ios::trunc);
+  out << in.rdbuf();
+  return bool(out);
+}
+
+// Polymers simulated by one thread in a window of the parallel mode, with
+// the updates to shared state they queued
+struct Partition {
+  std::vector<PolymerWrapper *> wrappers;
+  double propensity = 0;
+  std::mt19937 generator;
+  DeferredQueue updates;
+  long events = 0;
+  std::exception_ptr error;
+};
+
+// Simulate the reactions on the polymers of `partition` from `start` until
+// `end`. Each polymer only changes itself (and attached transcripts, which
+// are in the same partition); everything else is queued.
+void SimulatePartition(Partition &partition, double start, double end) {
+  deferred_updates = &partition.updates;
+  Random::ThreadGenerator(&partition.generator);
+  try {
+    const auto &wrappers = partition.wrappers;
+    std::vector<double> props(wrappers.size());
+    double time = start;
+    while (true) {
+      double total = 0;
+      for (std::size_t i = 0; i < wrappers.size(); i++) {
+        props[i] =
+            wrappers[i]->remove() ? 0 : wrappers[i]->polymer()->prop_sum();
+        total += props[i];
+      }
+      if (total <= 0) {
+        break;
+      }
+      time += std::log(1.0 / Random::random()) / total;
+      if (time > end) {
+        break;
+      }
+      double target = Random::random() * total;
+      double cumulative = 0;
+      std::size_t chosen = 0;
+      for (std::size_t i = 0; i < wrappers.size(); i++) {
+        if (props[i] > 0) {
+          chosen = i;
+          cumulative += props[i];
+          if (target < cumulative) {
+            break;
+          }
+        }
+      }
+      wrappers[chosen]->Execute();
+      partition.events++;
+    }
+  } catch (...) {
+    partition.error = std::current_exception();
+  }
+  Random::ThreadGenerator(nullptr);
+  deferred_updates = nullptr;
+}
+
+}  // namespace
+
 Model::Model(double cell_volume) : cell_volume_(cell_volume) {
   auto &tracker = SpeciesTracker::Instance();
   tracker.Clear();
   gillespie_ = Gillespie();
-  tracker.propensity_signal_.ConnectMember(&gillespie_,
-                                           &Gillespie::UpdatePropensity);
+  tracker.propensity_signal_
+      .ConnectMember<Gillespie, &Gillespie::UpdatePropensity>(&gillespie_);
 }
 
-void Model::seed(int seed) { Random::seed(seed); }
+void Model::seed(int seed) {
+  Random::seed(seed);
+  seed_ = seed;
+  seeded_ = true;
+}
+
+std::string Model::Hash(int time_limit, int time_step) {
+  Fnv1a hash = initialized_ ? definition_hash_ : DefinitionHash();
+  hash.Add(events_hash_.hex())
+      .Add(int(seeded_))
+      .Add(seed_)
+      .Add(time_limit)
+      .Add(time_step);
+  return hash.hex();
+}
+
+void Model::EnableCache(const std::string &directory) {
+  struct stat info;
+  if (stat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+    throw std::invalid_argument("Cache directory '" + directory +
+                                "' does not exist.");
+  }
+  cache_directory_ = directory;
+}
+
+Fnv1a Model::DefinitionHash() {
+  Fnv1a hash;
+  hash.Add(std::string(kEngineVersion))
+      .Add(cell_volume_)
+      .Add(int(pruning_))
+      .Add(slow_scale_ratio_)
+      .Add(fluctuation_)
+      .Add(int(translation_engine_))
+      .Add(int(time_averages_) + int(time_extremes_))
+      .Add(parallel_threads_)
+      .Add(parallel_window_);
+  // Species counts include binding sites exposed on registered polymers
+  const auto &species = SpeciesTracker::Instance().species();
+  hash.Add(int(species.size()));
+  for (const auto &item : species) {
+    hash.Add(item.first).Add(item.second);
+  }
+  hash.Add(int(polymerases_.size()));
+  for (const auto &pol : polymerases_) {
+    hash.Add(pol.name()).Add(pol.footprint()).Add(pol.speed());
+  }
+  hash.Add(int(species_reactions_.size()));
+  for (const auto &reaction : species_reactions_) {
+    hash.Add(reaction->rate_constant())
+        .Add(reaction->reactants())
+        .Add(reaction->products());
+  }
+  hash.Add(int(rate_law_reactions_.size()));
+  for (const auto &reaction : rate_law_reactions_) {
+    hash.Add(reaction->rate_law().expression())
+        .Add(reaction->rate_law().constants())
+        .Add(reaction->reactants())
+        .Add(reaction->products());
+  }
+  hash.Add(int(genomes_.size()));
+  for (const auto &genome : genomes_) {
+    HashGenome(hash, *genome);
+  }
+  hash.Add(int(transcripts_.size()));
+  for (const auto &transcript : transcripts_) {
+    HashPolymer(hash, *transcript);
+  }
+  hash.Add(std::vector<std::string>(mean_field_genes_.begin(),
+                                    mean_field_genes_.end()));
+  hash.Add(int(genome_replication_.size()));
+  for (const auto &replication : genome_replication_) {
+    hash.Add(replication.first)
+        .Add(replication.second.first)
+        .Add(replication.second.second);
+  }
+  return hash;
+}
 
 void Model::Simulate(int time_limit, int time_step,
                      const std::string &output = "counts.tsv") {
   auto &tracker = SpeciesTracker::Instance();
-  Initialize();
+  if (!initialized_) {
+    Initialize();
+  }
+  // Reuse the output of an identical earlier run
+  cache_hit_ = false;
+  std::string cached;
+  if (!cache_directory_.empty() && seeded_ && gillespie_.time() == 0 &&
+      !tracker.observers_.active()) {
+    cached = cache_directory_ + "/" + Hash(time_limit, time_step) + ".tsv";
+    if (CopyFile(cached, output)) {
+      cache_hit_ = true;
+      std::cout << "Simulation successful (cached)." << std::endl;
+      return;
+    }
+  }
+  if (snapshots_) {
+    PublishSnapshot();
+  }
   // Set up file output streams
   std::ofstream countfile(output, std::ios::trunc);
   // Output header
-  countfile << "time\tspecies\tprotein\ttranscript\tribo_density\n";
+  countfile << CountsHeader();
+  WriteSamples(countfile, time_limit, time_step);
+  countfile.close();
+  if (snapshots_) {
+    PublishSnapshot();
+  }
+  if (!cached.empty()) {
+    // Write to a temporary file first, so that concurrent runs never read a
+    // partial result
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    std::string temporary = cached + ".tmp" + std::to_string(now);
+    if (!CopyFile(output, temporary) ||
+        std::rename(temporary.c_str(), cached.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      throw std::runtime_error("Could not write to cache directory '" +
+                               cache_directory_ + "'.");
+    }
+  }
+  std::cout << "Simulation successful. Ignore any warnings that follow." << std::endl;
+}
+
+std::string Model::CountsHeader() const {
+  std::string header = "time\tspecies\tprotein\ttranscript\tribo_density";
+  if (time_extremes_) {
+    header +=
+        "\tprotein_min\tprotein_max\ttranscript_min\ttranscript_max"
+        "\tribo_density_min\tribo_density_max";
+  }
+  return header + "\n";
+}
+
+void Model::WriteSamples(std::ostream &out, int time_limit, int time_step) {
+  auto &tracker = SpeciesTracker::Instance();
   int out_time = 0;
   while (gillespie_.time() < time_limit) {
     if ((out_time - gillespie_.time()) < 0.001) {
-      countfile << tracker.GatherCounts(gillespie_.time());
-      countfile.flush();
+      if (time_averages_) {
+        out << tracker.GatherAverages(gillespie_.time(), time_extremes_);
+      } else {
+        out << tracker.GatherCounts(gillespie_.time());
+      }
+      out.flush();
+      if (tracker.observers_.active()) {
+        tracker.observers_.time = gillespie_.time();
+        tracker.observers_.Sample();
+      }
       out_time += time_step;
     }
-    gillespie_.Iterate();
+    // In parallel mode, end windows within the output tolerance of the next
+    // output time, so that it is written before time_limit is reached
+    Advance(out_time - 0.0005);
+  }
+}
+
+EnsembleReport Model::SimulateEnsemble(const std::vector<int> &seeds,
+                                       int time_limit, int time_step,
+                                       const std::string &output,
+                                       int workers) {
+#ifdef _WIN32
+  throw std::runtime_error(
+      "Ensembles of worker processes are not supported on this platform.");
+#else
+  if (workers < 1) {
+    throw std::invalid_argument("Ensemble: need at least one worker.");
+  }
+  if (!initialized_) {
+    Initialize();
+  }
+  std::ofstream countfile(output, std::ios::trunc);
+  if (!countfile) {
+    throw std::runtime_error("Could not open output file '" + output + "'.");
+  }
+  countfile << "seed\t" << CountsHeader();
+  countfile.flush();
+  // Workers would write out anything still buffered again
+  std::cout.flush();
+  std::cerr.flush();
+
+  struct Worker {
+    pid_t pid = -1;
+    int seed = 0;
+    std::unique_ptr<SharedChannel> channel;
+    std::string pending;
+  };
+  std::vector<Worker> pool(std::min(std::size_t(workers), seeds.size()));
+  for (auto &worker : pool) {
+    worker.channel.reset(new SharedChannel());
+  }
+  // Copy complete rows that a worker has written so far, after its seed
+  auto forward = [&countfile](Worker &worker) {
+    if (worker.channel->Read(&worker.pending) == 0) {
+      return false;
+    }
+    std::string prefix = std::to_string(worker.seed) + "\t";
+    std::size_t start = 0;
+    std::size_t newline;
+    while ((newline = worker.pending.find('\n', start)) != std::string::npos) {
+      countfile << prefix;
+      countfile.write(worker.pending.data() + start, newline - start + 1);
+      start = newline + 1;
+    }
+    worker.pending.erase(0, start);
+    return true;
+  };
+
+  EnsembleReport report;
+  std::size_t next = 0;
+  int running = 0;
+  while (next < seeds.size() || running > 0) {
+    bool progress = false;
+    for (auto &worker : pool) {
+      if (worker.pid < 0 && next < seeds.size()) {
+        worker.seed = seeds[next++];
+        worker.channel->Reset();
+        worker.pending.clear();
+        worker.pid = fork();
+        if (worker.pid == 0) {
+          // Worker: simulate from the inherited state and exit without
+          // returning to the caller
+          int status = 0;
+          try {
+            seed(worker.seed);
+            ChannelStreambuf buffer(*worker.channel);
+            std::ostream out(&buffer);
+            WriteSamples(out, time_limit, time_step);
+          } catch (const std::exception &err) {
+            worker.channel->error(err.what());
+            status = 1;
+          }
+          _exit(status);
+        }
+        if (worker.pid < 0) {
+          report.failed.push_back(worker.seed);
+          report.errors.push_back(std::string("Could not start worker: ") +
+                                  std::strerror(errno));
+          continue;
+        }
+        running++;
+        progress = true;
+      }
+      if (worker.pid < 0) {
+        continue;
+      }
+      progress = forward(worker) || progress;
+      int status;
+      if (waitpid(worker.pid, &status, WNOHANG) != worker.pid) {
+        continue;
+      }
+      // Rows written just before the worker exited
+      forward(worker);
+      if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        report.completed.push_back(worker.seed);
+      } else {
+        report.failed.push_back(worker.seed);
+        if (WIFSIGNALED(status)) {
+          report.errors.push_back("Worker killed by signal " +
+                                  std::to_string(WTERMSIG(status)) + ".");
+        } else if (!worker.channel->error().empty()) {
+          report.errors.push_back(worker.channel->error());
+        } else {
+          report.errors.push_back("Worker exited with status " +
+                                  std::to_string(WEXITSTATUS(status)) + ".");
+        }
+      }
+      worker.pid = -1;
+      running--;
+      progress = true;
+    }
+    if (!progress) {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
   }
   countfile.close();
-  std::cout << "Simulation successful. Ignore any warnings that follow." << std::endl;
+  return report;
+#endif
+}
+
+void Model::Step(int iterations) {
+  if (!initialized_) {
+    Initialize();
+  }
+  if (snapshots_) {
+    PublishSnapshot();
+  }
+  long target = events() + iterations;
+  while (events() < target) {
+    Advance();
+  }
+  if (snapshots_) {
+    PublishSnapshot();
+  }
+}
+
+void Model::StepUntil(double time_limit) {
+  if (!initialized_) {
+    Initialize();
+  }
+  if (snapshots_) {
+    PublishSnapshot();
+  }
+  while (gillespie_.time() < time_limit) {
+    Advance(time_limit);
+  }
+  if (snapshots_) {
+    PublishSnapshot();
+  }
+}
+
+void Model::Advance(double time_limit) {
+  if (parallel_) {
+    AdvanceParallel(time_limit);
+  } else {
+    gillespie_.Iterate();
+  }
+  if (snapshots_ && gillespie_.time() >= next_snapshot_) {
+    PublishSnapshot();
+  }
+}
+
+void Model::EnableSnapshots(double interval) {
+  if (interval < 0) {
+    throw std::invalid_argument("Snapshot interval must not be negative.");
+  }
+  if (!snapshots_) {
+    snapshots_ = std::unique_ptr<SnapshotBuffer>(new SnapshotBuffer());
+  }
+  snapshot_interval_ = interval;
+  next_snapshot_ = gillespie_.time();
+}
+
+Snapshot Model::snapshot() const {
+  if (!snapshots_) {
+    throw std::runtime_error(
+        "Snapshots are not enabled. Call EnableSnapshots() first.");
+  }
+  return snapshots_->Read();
+}
+
+void Model::PublishSnapshot() {
+  snapshots_->Publish(gillespie_.time(), events(),
+                      SpeciesTracker::Instance().species());
+  next_snapshot_ = gillespie_.time() + snapshot_interval_;
+}
+
+void Model::TrackChanges() {
+  auto &tracker = SpeciesTracker::Instance();
+  tracker.journal_.Enable(tracker.species());
+}
+
+ChangeDelta Model::CollectChanges() {
+  auto &tracker = SpeciesTracker::Instance();
+  return tracker.journal_.Collect(gillespie_.time(), tracker.species());
+}
+
+SimulationStats Model::stats() {
+  SimulationStats stats;
+  stats.events = events();
+  stats.transcripts = transcripts_registered_ - removed();
+  stats.peak_transcripts = peak_transcripts_;
+  stats.cached = cache_hit_;
+  stats.propensity_evaluations = gillespie_.propensity_evaluations();
+  return stats;
+}
+
+PolymerStateExport Model::ExportState() {
+  PolymerStateExport state;
+  state.time = gillespie_.time();
+  std::map<std::string, int> indices;
+  auto index = [&state, &indices](const std::string &name) {
+    auto it = indices.emplace(name, int(state.names.size()));
+    if (it.second) {
+      state.names.push_back(name);
+    }
+    return it.first->second;
+  };
+  // In parallel mode, polymers are kept outside of the reaction queue
+  auto reactions = gillespie_.reactions();
+  reactions.insert(reactions.end(), polymers_.begin(), polymers_.end());
+  for (const auto &reaction : reactions) {
+    auto wrapper = std::dynamic_pointer_cast<PolymerWrapper>(reaction);
+    if (!wrapper) {
+      continue;
+    }
+    auto polymer = wrapper->polymer();
+    PolymerRecord record;
+    record.id = polymer->id();
+    record.kind = std::dynamic_pointer_cast<Genome>(polymer)
+                      ? PolymerRecord::kGenome
+                      : std::dynamic_pointer_cast<Transcript>(polymer)
+                            ? PolymerRecord::kTranscript
+                            : PolymerRecord::kOther;
+    record.name = index(polymer->name());
+    record.start = polymer->start();
+    record.stop = polymer->stop();
+    record.mask_start = polymer->GetMask().start();
+    record.mask_stop = polymer->GetMask().stop();
+    state.polymers.push_back(record);
+    auto flat = std::dynamic_pointer_cast<FlatTranscript>(polymer);
+    if (flat) {
+      for (const auto &ribosome : flat->ribosomes()) {
+        MobileElementRecord element;
+        element.id = ribosome.id;
+        element.polymer_id = polymer->id();
+        element.kind = *ribosome.name == "__ribosome"
+                           ? MobileElementRecord::kRibosome
+                           : MobileElementRecord::kPolymerase;
+        element.name = index(*ribosome.name);
+        element.start = ribosome.start;
+        element.stop = ribosome.stop;
+        element.reading_frame = ribosome.reading_frame;
+        state.mobile_elements.push_back(element);
+      }
+    }
+    for (int i = 0; i < polymer->num_attached(); i++) {
+      const auto &pol = polymer->attached_pol(i);
+      MobileElementRecord element;
+      element.id = pol.id();
+      element.polymer_id = polymer->id();
+      element.kind = dynamic_cast<const Rnase *>(&pol)
+                         ? MobileElementRecord::kRnase
+                         : pol.name() == "__ribosome"
+                               ? MobileElementRecord::kRibosome
+                               : MobileElementRecord::kPolymerase;
+      element.name = index(pol.name());
+      element.start = pol.start();
+      element.stop = pol.stop();
+      element.reading_frame = pol.reading_frame();
+      state.mobile_elements.push_back(element);
+    }
+    auto add_site = [&](const FixedElement &site, int8_t kind) {
+      SiteRecord record;
+      record.polymer_id = polymer->id();
+      record.kind = kind;
+      record.name = index(site.name());
+      record.start = site.start();
+      record.stop = site.stop();
+      record.covered = site.covered();
+      record.gene = index(site.gene());
+      state.sites.push_back(record);
+    };
+    for (const auto &interval : polymer->GetBindingIntervals()) {
+      add_site(*interval.value, SiteRecord::kBinding);
+    }
+    for (const auto &interval : polymer->GetReleaseIntervals()) {
+      add_site(*interval.value, SiteRecord::kRelease);
+    }
+  }
+  return state;
 }
 
 void Model::AddReaction(double rate_constant,
@@ -51,6 +668,27 @@ void Model::AddReaction(double rate_constant,
     tracker.Add(product, rxn);
   }
   gillespie_.LinkReaction(rxn);
+  species_reactions_.push_back(rxn);
+}
+
+void Model::AddRateLawReaction(const std::string &rate_law,
+                               const std::map<std::string, double> &parameters,
+                               const std::vector<std::string> &reactants,
+                               const std::vector<std::string> &products) {
+  auto rxn = std::make_shared<RateLawReaction>(RateLaw(rate_law, parameters),
+                                               reactants, products);
+  auto &tracker = SpeciesTracker::Instance();
+  for (const auto &species : rxn->rate_law().species()) {
+    tracker.Add(species, rxn);
+  }
+  for (const auto &reactant : reactants) {
+    tracker.Add(reactant, rxn);
+  }
+  for (const auto &product : products) {
+    tracker.Add(product, rxn);
+  }
+  gillespie_.LinkReaction(rxn);
+  rate_law_reactions_.push_back(rxn);
 }
 
 void Model::AddSpecies(const std::string &name, int copy_number) {
@@ -80,40 +718,162 @@ void Model::AddRibosome(int footprint, double mean_speed, int copy_number) {
 
 void Model::RegisterPolymer(Polymer::Ptr polymer) {
   // Encapsulate polymer in PolymerWrapper reaction and add to reaction list
+  polymer->id(SpeciesTracker::Instance().NextId());
   auto wrapper = std::make_shared<PolymerWrapper>(polymer);
   polymer->wrapper(wrapper);
-  gillespie_.LinkReaction(wrapper);
+  if (parallel_) {
+    polymers_.push_back(wrapper);
+  } else {
+    gillespie_.LinkReaction(wrapper);
+  }
 }
 
 void Model::RegisterGenome(Genome::Ptr genome) {
   RegisterPolymer(genome);
-  genome->termination_signal_.ConnectMember(
-      &SpeciesTracker::Instance(), &SpeciesTracker::TerminateTranscription);
-  genome->transcript_signal_.ConnectMember(this, &Model::RegisterTranscript);
+  genome->termination_signal_
+      .ConnectMember<SpeciesTracker, &SpeciesTracker::TerminateTranscription>(
+          &SpeciesTracker::Instance());
+  genome->transcript_signal_
+      .ConnectMember<Model, &Model::RegisterTranscript>(this);
+  genome->termination_signal_
+      .ConnectMember<Model, &Model::ForwardTermination>(this);
   genomes_.push_back(genome);
 }
 
 void Model::RegisterTranscript(Transcript::Ptr transcript) {
   RegisterPolymer(transcript);
-  transcript->termination_signal_.ConnectMember(
-      &SpeciesTracker::Instance(), &SpeciesTracker::TerminateTranslation);
+  transcripts_registered_++;
+  peak_transcripts_ = std::max(peak_transcripts_,
+                               transcripts_registered_ - removed());
+  auto &tracker = SpeciesTracker::Instance();
+  tracker.journal_.LogTranscriptCreated(transcript->id(), transcript->name(),
+                                        transcript->start(),
+                                        transcript->stop());
+  if (tracker.observers_.active()) {
+    tracker.observers_.TranscriptCreated(transcript->id(), transcript->name(),
+                                         transcript->start(),
+                                         transcript->stop());
+  }
+  transcript->termination_signal_
+      .ConnectMember<SpeciesTracker, &SpeciesTracker::TerminateTranslation>(
+          &SpeciesTracker::Instance());
+  transcript->termination_signal_
+      .ConnectMember<Model, &Model::ForwardTermination>(this);
   if (initialized_ == false) {
     transcripts_.push_back(transcript);
   }
 }
 
 void Model::Initialize() {
-  if (genomes_.size() == 0 && transcripts_.size() == 0) {
+  if (genomes_.size() == 0 && scheduled_genomes_.size() == 0 &&
+      transcripts_.size() == 0) {
     std::cerr << "Warning: There are no Genome objects registered with "
                  "Model. Did you forget to register a Genome?"
               << std::endl;
   }
+  definition_hash_ = DefinitionHash();
+  // Scheduled rate changes must apply to at least one reaction
+  for (const auto &change : scheduled_rate_changes_) {
+    if (std::none_of(species_reactions_.begin(), species_reactions_.end(),
+                     [&change](const SpeciesReaction::Ptr &rxn) {
+                       return rxn->reactants() == change.first &&
+                              rxn->products() == change.second;
+                     })) {
+      throw std::invalid_argument(
+          "Scheduled rate change: no reaction " +
+          DescribeReaction(change.first, change.second) + ".");
+    }
+  }
+  auto genomes = DefinedGenomes();
+  // Genes chosen for mean-field translation must exist
+  std::set<std::string> genes;
+  for (const auto &genome : genomes) {
+    for (const auto &rbs : genome->GetTranscriptRbsIntervals()) {
+      genes.insert(rbs.value->gene());
+    }
+  }
+  for (const auto &transcript : transcripts_) {
+    for (const auto &rbs : transcript->GetBindingIntervals()) {
+      genes.insert(rbs.value->gene());
+    }
+  }
+  for (const auto &gene : mean_field_genes_) {
+    if (genes.count(gene) == 0) {
+      throw std::invalid_argument("Mean-field translation: no gene named " +
+                                  gene + ".");
+    }
+  }
+  std::set<std::string> reachable;
+  if (pruning_) {
+    reachable = ReachableSpecies();
+    PruneSpeciesReactions(reachable);
+  }
+  // A binding reaction is dead if its site can never be exposed or its
+  // polymerase can never be present
+  auto prune_binding = [this, &reachable](const std::string &site,
+                                          const std::string &pol,
+                                          const std::string &polymer) {
+    if (pruning_ && (reachable.count(site) == 0 || reachable.count(pol) == 0)) {
+      prune_report_.reactions.push_back("bind " + pol + " to " + site +
+                                        " on " + polymer);
+      return true;
+    }
+    return false;
+  };
+  // Ribosome binding sites of genes chosen for mean-field translation get a
+  // MeanFieldTranslation reaction instead of a BindPolymerase reaction
+  std::map<std::string, std::shared_ptr<MeanFieldTranslation>>
+      mean_field_sites;
+  auto mean_field =
+      [this, &mean_field_sites](
+          const Polymerase &pol, const std::string &site, double rate_constant,
+          const std::vector<Interval<BindingSite::Ptr>> &rbs_intervals,
+          const std::vector<Interval<ReleaseSite::Ptr>> &stops,
+          const std::vector<double> &weights) {
+        if (pol.name() != "__ribosome") {
+          return false;
+        }
+        for (const auto &interval : rbs_intervals) {
+          const auto &rbs = interval.value;
+          if (rbs->name() != site ||
+              mean_field_genes_.count(rbs->gene()) == 0) {
+            continue;
+          }
+          // Polymers that share a binding site share its reaction, with the
+          // lattice of the first polymer
+          if (mean_field_sites.count(site) != 0) {
+            mean_field_sites[site]->AddRateConstant(rate_constant,
+                                                    cell_volume_);
+            return true;
+          }
+          auto reaction = std::make_shared<MeanFieldTranslation>(
+              rate_constant, cell_volume_, site, rbs->gene(),
+              GeneLattice(rbs, stops, weights, pol));
+          auto &tracker = SpeciesTracker::Instance();
+          tracker.Add(site, reaction);
+          tracker.Add(pol.name(), reaction);
+          gillespie_.LinkReaction(reaction);
+          mean_field_sites[site] = reaction;
+          return true;
+        }
+        return false;
+      };
   // Create Bind reactions for each promoter-polymerase pair
-  for (Genome::Ptr genome : genomes_) {
+  for (Genome::Ptr genome : genomes) {
     for (auto promoter_name : genome->bindings()) {
       for (auto pol : polymerases_) {
         if (promoter_name.second.count(pol.name()) != 0) {
+          if (prune_binding(promoter_name.first, pol.name(),
+                            genome->name())) {
+            continue;
+          }
           double rate_constant = promoter_name.second[pol.name()];
+          if (mean_field(pol, promoter_name.first, rate_constant,
+                         genome->GetTranscriptRbsIntervals(),
+                         genome->GetTranscriptStopSiteIntervals(),
+                         genome->transcript_weights())) {
+            continue;
+          }
           Polymerase pol_template = Polymerase(pol);
           auto reaction = std::make_shared<BindPolymerase>(
               rate_constant, cell_volume_, promoter_name.first, pol_template);
@@ -169,7 +929,16 @@ void Model::Initialize() {
     for (auto rbs_name : transcript->bindings()) {
       for (auto pol : polymerases_) {
         if (rbs_name.second.count(pol.name()) != 0) {
+          if (prune_binding(rbs_name.first, pol.name(), transcript->name())) {
+            continue;
+          }
           double rate_constant = rbs_name.second[pol.name()];
+          if (mean_field(pol, rbs_name.first, rate_constant,
+                         transcript->GetBindingIntervals(),
+                         transcript->GetReleaseIntervals(),
+                         transcript->weights())) {
+            continue;
+          }
           Polymerase pol_template = Polymerase(pol);
           auto reaction = std::make_shared<BindPolymerase>(
               rate_constant, cell_volume_, rbs_name.first, pol_template);
@@ -182,9 +951,702 @@ void Model::Initialize() {
     }
   }
 
+  // Species that never change and are not involved in any remaining
+  // reaction no longer need to be tracked
+  if (pruning_) {
+    auto &tracker = SpeciesTracker::Instance();
+    std::vector<std::string> dead;
+    for (const auto &species : tracker.species()) {
+      if (species.second == 0 && reachable.count(species.first) == 0) {
+        dead.push_back(species.first);
+      }
+    }
+    for (const auto &name : dead) {
+      if (tracker.RemoveSpecies(name)) {
+        prune_report_.species.push_back(name);
+      }
+    }
+  }
+
+  if (slow_scale_ratio_ > 0) {
+    FindFastEquilibria();
+  }
+
+  // Replicating genomes; new copies share the bind reactions created above
+  for (const auto &replication : genome_replication_) {
+    auto genome = std::find_if(genomes_.begin(), genomes_.end(),
+                               [&replication](const Genome::Ptr &genome) {
+                                 return genome->name() == replication.first;
+                               });
+    if (genome == genomes_.end()) {
+      throw std::invalid_argument("Genome replication: no genome named " +
+                                  replication.first + ".");
+    }
+    auto reaction = std::make_shared<ReplicateGenome>(
+        *genome, replication.second.first, genome_copies(replication.first),
+        replication.second.second);
+    reaction->replication_signal_
+        .ConnectMember<Model, &Model::RegisterGenome>(this);
+    gillespie_.LinkReaction(reaction);
+  }
+
+  if (translation_engine_) {
+    UseTranslationEngine();
+  }
+
+  if (time_averages_) {
+    SpeciesTracker::Instance().TrackAverages(gillespie_.clock());
+  }
+
+  if (parallel_threads_ > 0) {
+    // Move polymers out of the reaction queue; they are simulated in
+    // windows by AdvanceParallel()
+    for (const auto &reaction : gillespie_.reactions()) {
+      auto wrapper = std::dynamic_pointer_cast<PolymerWrapper>(reaction);
+      if (wrapper) {
+        polymers_.push_back(wrapper);
+      }
+    }
+    for (const auto &wrapper : polymers_) {
+      gillespie_.UnlinkReaction(wrapper);
+    }
+    gillespie_.ignore_unlinked(true);
+    parallel_ = true;
+  }
+
   initialized_ = true;
 }
 
+void Model::EnablePruning() {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Pruning must be enabled before the model is initialized.");
+  }
+  pruning_ = true;
+}
+
+void Model::EnableSlowScale(double ratio) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "The slow-scale SSA must be enabled before the model is initialized.");
+  }
+  if (ratio <= 0) {
+    throw std::invalid_argument("Slow-scale SSA ratio must be positive.");
+  }
+  slow_scale_ratio_ = ratio;
+}
+
+void Model::EnableRejectionSampling(double fluctuation) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Rejection sampling must be enabled before the model is "
+        "initialized.");
+  }
+  gillespie_.EnableRejectionSampling(fluctuation);
+  fluctuation_ = fluctuation;
+}
+
+void Model::EnableTranslationEngine() {
+  if (initialized_) {
+    throw std::runtime_error(
+        "The translation engine must be enabled before the model is "
+        "initialized.");
+  }
+  translation_engine_ = true;
+}
+
+void Model::EnableTimeAverages(bool extremes) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Time averages must be enabled before the model is initialized.");
+  }
+  time_averages_ = true;
+  time_extremes_ = extremes;
+}
+
+void Model::UseTranslationEngine() {
+  if (!genomes_.empty() || !scheduled_genomes_.empty()) {
+    throw std::invalid_argument(
+        "The translation engine only simulates models without genomes.");
+  }
+  auto &tracker = SpeciesTracker::Instance();
+  for (auto &transcript : transcripts_) {
+    auto flat = std::make_shared<FlatTranscript>(*transcript);
+    flat->id(transcript->id());
+    // Retire the original transcript, along with the sites it exposed; the
+    // new one exposes the same sites
+    gillespie_.UnlinkReaction(transcript->wrapper());
+    std::set<std::string> sites;
+    for (const auto &interval : transcript->GetBindingIntervals()) {
+      sites.insert(interval.value->name());
+    }
+    for (const auto &site : sites) {
+      tracker.Increment(site, -transcript->uncovered(site));
+    }
+    auto wrapper = std::make_shared<PolymerWrapper>(flat);
+    flat->wrapper(wrapper);
+    gillespie_.LinkReaction(wrapper);
+    flat->termination_signal_
+        .ConnectMember<SpeciesTracker, &SpeciesTracker::TerminateTranslation>(
+            &tracker);
+    flat->termination_signal_
+        .ConnectMember<Model, &Model::ForwardTermination>(this);
+    transcript = flat;
+  }
+}
+
+void Model::EnableParallel(int threads, double window) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Parallel mode must be enabled before the model is initialized.");
+  }
+  if (threads < 1) {
+    throw std::invalid_argument("Parallel mode needs at least one thread.");
+  }
+  if (window <= 0) {
+    throw std::invalid_argument("Parallel window must be positive.");
+  }
+  parallel_threads_ = threads;
+  parallel_window_ = window;
+}
+
+void Model::AdvanceParallel(double time_limit) {
+  double start = gillespie_.time();
+  double end = std::min(start + parallel_window_, time_limit);
+  // A genome moves the masks of the nascent transcripts attached to it, so
+  // they are simulated together
+  std::map<Polymer *, PolymerWrapper *> wrappers;
+  for (const auto &wrapper : polymers_) {
+    wrappers[wrapper->polymer().get()] = wrapper.get();
+  }
+  std::vector<std::vector<PolymerWrapper *>> groups;
+  std::set<PolymerWrapper *> grouped;
+  for (const auto &wrapper : polymers_) {
+    auto polymer = wrapper->polymer();
+    for (int i = 0; i < polymer->num_attached(); i++) {
+      auto attached = wrappers.find(polymer->attached_polymer(i).get());
+      if (attached == wrappers.end()) {
+        continue;
+      }
+      if (grouped.insert(wrapper.get()).second) {
+        groups.push_back({wrapper.get()});
+      }
+      if (grouped.insert(attached->second).second) {
+        groups.back().push_back(attached->second);
+      }
+    }
+  }
+  for (const auto &wrapper : polymers_) {
+    if (grouped.count(wrapper.get()) == 0) {
+      groups.push_back({wrapper.get()});
+    }
+  }
+  // Assign groups to partitions, largest propensity first, each to the
+  // partition with the smallest propensity so far
+  std::vector<std::pair<double, int>> order;
+  for (std::size_t i = 0; i < groups.size(); i++) {
+    double propensity = 0;
+    for (auto wrapper : groups[i]) {
+      propensity += wrapper->polymer()->prop_sum();
+    }
+    if (propensity > 0) {
+      order.emplace_back(-propensity, int(i));
+    }
+  }
+  std::sort(order.begin(), order.end());
+  std::vector<Partition> partitions(
+      std::min(std::size_t(parallel_threads_), order.size()));
+  for (auto &partition : partitions) {
+    partition.generator.seed(std::uint32_t(Random::random() * 4294967296.0));
+  }
+  for (const auto &group : order) {
+    auto partition = std::min_element(
+        partitions.begin(), partitions.end(),
+        [](const Partition &a, const Partition &b) {
+          return a.propensity < b.propensity;
+        });
+    partition->wrappers.insert(partition->wrappers.end(),
+                               groups[group.second].begin(),
+                               groups[group.second].end());
+    partition->propensity -= group.first;
+  }
+
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < partitions.size(); i++) {
+    threads.emplace_back(SimulatePartition, std::ref(partitions[i]), start,
+                         end);
+  }
+  if (!partitions.empty()) {
+    SimulatePartition(partitions[0], start, end);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (const auto &partition : partitions) {
+    if (partition.error) {
+      std::rethrow_exception(partition.error);
+    }
+  }
+  // Apply queued updates in a fixed order, as if they happened at the start
+  // of the window
+  auto &observers = SpeciesTracker::Instance().observers_;
+  if (observers.active()) {
+    observers.time = start;
+  }
+  long polymer_events = 0;
+  for (auto &partition : partitions) {
+    for (const auto &update : partition.updates) {
+      update();
+    }
+    polymer_events += partition.events;
+  }
+  parallel_events_ += polymer_events;
+  auto removed = std::remove_if(
+      polymers_.begin(), polymers_.end(),
+      [](const std::shared_ptr<PolymerWrapper> &wrapper) {
+        return wrapper->remove();
+      });
+  parallel_removed_ += std::distance(removed, polymers_.end());
+  polymers_.erase(removed, polymers_.end());
+
+  long species_events = gillespie_.iteration();
+  while (gillespie_.IterateUntil(end)) {
+  }
+  if (polymer_events == 0 && gillespie_.iteration() == species_events &&
+      gillespie_.pending_events() == 0 && gillespie_.propensity() <= 0 &&
+      order.empty()) {
+    throw std::runtime_error(
+        "Propensity of system is 0. No reactions will execute.");
+  }
+}
+
+void Model::AddObserver(std::shared_ptr<Observer> observer) {
+  SpeciesTracker::Instance().observers_.Add(observer);
+}
+
+void Model::LoadObserver(const std::string &path, const std::string &args) {
+  SpeciesTracker::Instance().observers_.Load(path, args);
+}
+
+void Model::EnableMeanFieldTranslation(const std::string &gene) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Mean-field translation must be enabled before the model is "
+        "initialized.");
+  }
+  mean_field_genes_.insert(gene);
+}
+
+void Model::AddGenomeReplication(const std::string &genome,
+                                 double rate_constant, int max_copies) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Genome replication must be added before the model is initialized.");
+  }
+  if (rate_constant <= 0) {
+    throw std::invalid_argument("Replication rate constant of genome " +
+                                genome + " must be positive.");
+  }
+  if (max_copies < 0) {
+    throw std::invalid_argument("Maximum copy number of genome " + genome +
+                                " cannot be negative.");
+  }
+  genome_replication_[genome] = std::make_pair(rate_constant, max_copies);
+}
+
+int Model::genome_copies(const std::string &genome) const {
+  return std::count_if(
+      genomes_.begin(), genomes_.end(),
+      [&genome](const Genome::Ptr &copy) { return copy->name() == genome; });
+}
+
+void Model::CheckScheduleTime(double time) {
+  if (!std::isfinite(time) || time < gillespie_.time()) {
+    throw std::invalid_argument(
+        "Events cannot be scheduled before the current simulated time.");
+  }
+}
+
+void Model::ScheduleSpeciesChange(double time, const std::string &name,
+                                  int change) {
+  CheckScheduleTime(time);
+  if (name.substr(0, 2) == "__") {
+    throw std::invalid_argument(
+        "Names prefixed with '__' (double underscore) are reserved for "
+        "internal use.");
+  }
+  if (change > 0) {
+    scheduled_species_.insert(name);
+  }
+  events_hash_.Add(std::string("species")).Add(time).Add(name).Add(change);
+  gillespie_.ScheduleEvent(time, [this, name, change]() {
+    auto &tracker = SpeciesTracker::Instance();
+    const auto &species = tracker.species();
+    auto count = species.find(name);
+    if ((count == species.end() ? 0 : count->second) + change < 0) {
+      throw std::runtime_error("Scheduled event: copy number of " + name +
+                               " cannot become negative.");
+    }
+    tracker.Increment(name, change);
+    for (const auto &equilibrium : equilibria_) {
+      if (equilibrium->Contains(name)) {
+        equilibrium->Relax();
+      }
+    }
+  });
+}
+
+void Model::ScheduleRateChange(double time,
+                               const std::vector<std::string> &reactants,
+                               const std::vector<std::string> &products,
+                               double rate_constant) {
+  CheckScheduleTime(time);
+  if (rate_constant < 0) {
+    throw std::invalid_argument("Reaction rate constant cannot be negative.");
+  }
+  // Reactions may still be added until the model is initialized
+  if (!initialized_) {
+    scheduled_rate_changes_.emplace_back(reactants, products);
+  } else if (std::none_of(species_reactions_.begin(), species_reactions_.end(),
+                          [&](const SpeciesReaction::Ptr &rxn) {
+                            return rxn->reactants() == reactants &&
+                                   rxn->products() == products;
+                          })) {
+    throw std::invalid_argument("Scheduled rate change: no reaction " +
+                                DescribeReaction(reactants, products) + ".");
+  }
+  events_hash_.Add(std::string("rate"))
+      .Add(time)
+      .Add(reactants)
+      .Add(products)
+      .Add(rate_constant);
+  gillespie_.ScheduleEvent(time, [this, reactants, products,
+                                  rate_constant]() {
+    for (const auto &rxn : species_reactions_) {
+      if (rxn->reactants() == reactants && rxn->products() == products) {
+        rxn->SetRateConstant(rate_constant);
+        gillespie_.UpdatePropensity(rxn);
+      }
+    }
+  });
+}
+
+void Model::ScheduleGenome(double time, Genome::Ptr genome) {
+  if (initialized_) {
+    throw std::runtime_error(
+        "Genomes must be scheduled before the model is initialized.");
+  }
+  CheckScheduleTime(time);
+  if (!genome) {
+    throw std::invalid_argument("Scheduled genome cannot be null.");
+  }
+  events_hash_.Add(std::string("genome")).Add(time);
+  HashGenome(events_hash_, *genome);
+  scheduled_genomes_.push_back(genome);
+  gillespie_.ScheduleEvent(time, [this, genome]() { RegisterGenome(genome); });
+}
+
+Genome::VecPtr Model::DefinedGenomes() {
+  Genome::VecPtr genomes = genomes_;
+  std::set<std::string> names;
+  for (const auto &genome : genomes_) {
+    names.insert(genome->name());
+  }
+  for (const auto &genome : scheduled_genomes_) {
+    if (names.insert(genome->name()).second) {
+      genomes.push_back(genome);
+    }
+  }
+  return genomes;
+}
+
+std::set<std::string> Model::ReachableSpecies() {
+  std::set<std::string> reachable = scheduled_species_;
+  for (const auto &species : SpeciesTracker::Instance().species()) {
+    if (species.second > 0) {
+      reachable.insert(species.first);
+    }
+  }
+  auto genomes = DefinedGenomes();
+  // Promoters may be masked or covered at first, but any of them can become
+  // free; so can the binding sites of predefined transcripts
+  for (const auto &genome : genomes) {
+    for (const auto &promoter : genome->GetBindingIntervals()) {
+      reachable.insert(promoter.value->name());
+    }
+  }
+  for (const auto &transcript : transcripts_) {
+    for (const auto &rbs : transcript->GetBindingIntervals()) {
+      reachable.insert(rbs.value->name());
+    }
+  }
+  // Can any present polymerase bind to this site?
+  auto bound = [this, &reachable](const BindingSite::Ptr &site) {
+    for (const auto &pol : polymerases_) {
+      if (site->CheckInteraction(pol.name()) &&
+          reachable.count(pol.name()) != 0) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    auto add = [&reachable, &changed](const std::string &name) {
+      if (reachable.insert(name).second) {
+        changed = true;
+      }
+    };
+    for (const auto &rxn : species_reactions_) {
+      bool possible = true;
+      for (const auto &reactant : rxn->reactants()) {
+        possible = possible && reachable.count(reactant) != 0;
+      }
+      if (possible) {
+        for (const auto &product : rxn->products()) {
+          add(product);
+        }
+      }
+    }
+    // Rate laws are not analyzed; their reactions are never pruned
+    for (const auto &rxn : rate_law_reactions_) {
+      bool possible = true;
+      for (const auto &reactant : rxn->reactants()) {
+        possible = possible && reachable.count(reactant) != 0;
+      }
+      if (possible) {
+        for (const auto &product : rxn->products()) {
+          add(product);
+        }
+      }
+    }
+    for (const auto &genome : genomes) {
+      const auto &rbs_intervals = genome->GetTranscriptRbsIntervals();
+      for (const auto &promoter : genome->GetBindingIntervals()) {
+        for (const auto &pol : polymerases_) {
+          if (!promoter.value->CheckInteraction(pol.name()) ||
+              reachable.count(pol.name()) == 0) {
+            continue;
+          }
+          // Transcription stops for certain at the first terminator with an
+          // efficiency of 1.0 (or at the end of the genome)
+          int end = genome->stop();
+          for (const auto &term : genome->GetReleaseIntervals()) {
+            if (term.value->start() > promoter.value->stop() &&
+                term.value->start() < end &&
+                term.value->CheckInteraction(pol.name(),
+                                             term.value->reading_frame()) &&
+                term.value->efficiency(pol.name()) >= 1.0) {
+              end = term.value->start();
+            }
+          }
+          for (const auto &rbs : rbs_intervals) {
+            if (rbs.value->stop() > promoter.value->start() &&
+                rbs.value->start() < end) {
+              add(rbs.value->name());
+            }
+          }
+        }
+      }
+      for (const auto &rbs : rbs_intervals) {
+        if (reachable.count(rbs.value->name()) != 0 &&
+            !rbs.value->gene().empty() && bound(rbs.value)) {
+          add(rbs.value->gene());
+        }
+      }
+    }
+    for (const auto &transcript : transcripts_) {
+      for (const auto &rbs : transcript->GetBindingIntervals()) {
+        if (!rbs.value->gene().empty() && bound(rbs.value)) {
+          add(rbs.value->gene());
+        }
+      }
+    }
+  }
+  return reachable;
+}
+
+void Model::PruneSpeciesReactions(const std::set<std::string> &reachable) {
+  auto &tracker = SpeciesTracker::Instance();
+  std::vector<std::shared_ptr<SpeciesReaction>> remaining;
+  for (const auto &rxn : species_reactions_) {
+    bool possible = true;
+    for (const auto &reactant : rxn->reactants()) {
+      possible = possible && reachable.count(reactant) != 0;
+    }
+    if (possible) {
+      remaining.push_back(rxn);
+      continue;
+    }
+    gillespie_.UnlinkReaction(rxn);
+    for (const auto &name : rxn->reactants()) {
+      tracker.Remove(name, rxn);
+    }
+    for (const auto &name : rxn->products()) {
+      tracker.Remove(name, rxn);
+    }
+    prune_report_.reactions.push_back(
+        DescribeReaction(rxn->reactants(), rxn->products()));
+  }
+  // Pruned reactions are no longer part of the model
+  species_reactions_ = remaining;
+}
+
+void Model::FindFastEquilibria() {
+  auto &tracker = SpeciesTracker::Instance();
+  // Species changed by anything but species reactions (polymerases, proteins
+  // and, through non-species reactions, binding sites) are not eligible
+  std::set<std::string> excluded;
+  for (const auto &pol : polymerases_) {
+    excluded.insert(pol.name());
+  }
+  for (const auto &genome : DefinedGenomes()) {
+    for (const auto &rbs : genome->GetTranscriptRbsIntervals()) {
+      excluded.insert(rbs.value->gene());
+    }
+  }
+  for (const auto &transcript : transcripts_) {
+    for (const auto &rbs : transcript->GetBindingIntervals()) {
+      excluded.insert(rbs.value->gene());
+    }
+  }
+  auto eligible = [&tracker, &excluded](const std::string &name) {
+    if (name.substr(0, 2) == "__" || excluded.count(name) != 0) {
+      return false;
+    }
+    for (const auto &reaction : tracker.FindReactions(name)) {
+      if (!std::dynamic_pointer_cast<SpeciesReaction>(reaction)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  auto sorted = [](std::vector<std::string> names) {
+    std::sort(names.begin(), names.end());
+    return names;
+  };
+  auto involves = [](const SpeciesReaction::Ptr &rxn,
+                     const FastEquilibrium &equilibrium) {
+    for (const auto &name : rxn->reactants()) {
+      if (equilibrium.Contains(name)) {
+        return true;
+      }
+    }
+    for (const auto &name : rxn->products()) {
+      if (equilibrium.Contains(name)) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::set<SpeciesReaction::Ptr> fast;
+  std::set<std::string> taken;
+  for (std::size_t i = 0; i < species_reactions_.size(); i++) {
+    for (std::size_t j = i + 1; j < species_reactions_.size(); j++) {
+      auto forward = species_reactions_[i];
+      auto reverse = species_reactions_[j];
+      if (fast.count(forward) != 0 || fast.count(reverse) != 0 ||
+          forward->reactants().empty() || forward->products().empty() ||
+          sorted(forward->reactants()) != sorted(reverse->products()) ||
+          sorted(forward->products()) != sorted(reverse->reactants())) {
+        continue;
+      }
+      // Both sides must be different species, none of them in use by
+      // another pair
+      std::set<std::string> species(forward->reactants().begin(),
+                                    forward->reactants().end());
+      bool possible = true;
+      for (const auto &product : forward->products()) {
+        possible = possible && species.count(product) == 0;
+      }
+      species.insert(forward->products().begin(), forward->products().end());
+      for (const auto &name : species) {
+        possible = possible && eligible(name) && taken.count(name) == 0;
+      }
+      // Rate changes are scheduled for reactions that are simulated
+      for (const auto &change : scheduled_rate_changes_) {
+        for (const auto &rxn : {forward, reverse}) {
+          possible = possible && !(rxn->reactants() == change.first &&
+                                   rxn->products() == change.second);
+        }
+      }
+      if (!possible) {
+        continue;
+      }
+      auto equilibrium = std::make_shared<FastEquilibrium>(forward, reverse);
+      equilibrium->Update();
+      double slow = 0;
+      for (const auto &rxn : species_reactions_) {
+        if (rxn == forward || rxn == reverse || fast.count(rxn) != 0 ||
+            !involves(rxn, *equilibrium)) {
+          continue;
+        }
+        double propensity = rxn->rate_constant() *
+                            equilibrium->ExpectedProduct(rxn->reactants());
+        for (const auto &reactant : rxn->reactants()) {
+          if (!equilibrium->Contains(reactant)) {
+            propensity *= tracker.species(reactant);
+          }
+        }
+        slow += propensity;
+      }
+      if (equilibrium->Flux() <= 0 ||
+          equilibrium->Flux() < slow_scale_ratio_ * slow) {
+        continue;
+      }
+      for (const auto &rxn : {forward, reverse}) {
+        fast.insert(rxn);
+        gillespie_.UnlinkReaction(rxn);
+        for (const auto &name : rxn->reactants()) {
+          tracker.Remove(name, rxn);
+        }
+        for (const auto &name : rxn->products()) {
+          tracker.Remove(name, rxn);
+        }
+      }
+      taken.insert(species.begin(), species.end());
+      equilibria_.push_back(equilibrium);
+      fast_equilibria_.push_back(DescribeReaction(
+          forward->reactants(), forward->products(), "<->"));
+    }
+  }
+  // Fast reactions are no longer simulated; slow reactions use the
+  // equilibria of their species
+  std::vector<std::shared_ptr<SpeciesReaction>> slow;
+  for (const auto &rxn : species_reactions_) {
+    if (fast.count(rxn) != 0) {
+      continue;
+    }
+    for (const auto &equilibrium : equilibria_) {
+      if (involves(rxn, *equilibrium)) {
+        rxn->AddEquilibrium(equilibrium);
+      }
+    }
+    slow.push_back(rxn);
+  }
+  species_reactions_ = slow;
+  for (const auto &equilibrium : equilibria_) {
+    equilibrium->Relax();
+  }
+}
+
+void Model::ForwardTermination(std::shared_ptr<PolymerWrapper> wrapper,
+                               const std::string &pol_name,
+                               const std::string &gene_name) {
+  if (Defer(&Model::ForwardTermination, this, wrapper, pol_name,
+            gene_name)) {
+    return;
+  }
+  termination_signal_.Emit(pol_name, gene_name);
+  auto &observers = SpeciesTracker::Instance().observers_;
+  if (observers.active()) {
+    observers.Terminate(pol_name, gene_name);
+  }
+}
+
 void Model::CountTermination(const std::string &name) {
   auto new_name = name + "_total";
   if (terminations_.count(name) == 0) {
@@ -3,11 +3,80 @@
 #ifndef SRC_SIMULATION_HPP  // header guard
 #define SRC_SIMULATION_HPP
 
+#include <iosfwd>
+#include <limits>
 #include <memory>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "gillespie.hpp"
+#include "flat_transcript.hpp"
+#include "hash.hpp"
+#include "journal.hpp"
+#include "observer.hpp"
 #include "polymer.hpp"
+#include "polymer_state.hpp"
 #include "reaction.hpp"
+#include "snapshot.hpp"
+
+/**
+ * Counters describing the work done by a simulation, used for benchmarking.
+ */
+struct SimulationStats {
+  /**
+   * Number of reactions executed.
+   */
+  long events = 0;
+  /**
+   * Number of transcripts currently being tracked.
+   */
+  long transcripts = 0;
+  /**
+   * Largest number of transcripts tracked at any one time.
+   */
+  long peak_transcripts = 0;
+  /**
+   * True if the output of the last Simulate() was copied from the cache.
+   */
+  bool cached = false;
+  /**
+   * Number of times the propensity of a reaction was calculated.
+   */
+  long propensity_evaluations = 0;
+};
+
+/**
+ * Reactions and species removed by Model::EnablePruning() because they can
+ * never take part in the simulation.
+ */
+struct PruneReport {
+  /**
+   * Descriptions of removed reactions, e.g. "X + Y -> Z" or
+   * "bind rnapol to p1 on phage".
+   */
+  std::vector<std::string> reactions;
+  /**
+   * Names of species that are no longer tracked.
+   */
+  std::vector<std::string> species;
+};
+
+/**
+ * Outcome of Model::SimulateEnsemble(), with seeds in the order their
+ * replicates finished.
+ */
+struct EnsembleReport {
+  /**
+   * Seeds of replicates that ran to the time limit.
+   */
+  std::vector<int> completed;
+  /**
+   * Seeds of replicates whose worker failed or crashed, and why.
+   */
+  std::vector<int> failed;
+  std::vector<std::string> errors;
+};
 
 /**
  * Coordinate polymers and species-level reactions.
@@ -24,10 +93,277 @@ class Model : public std::enable_shared_from_this<Model> {
    * @param prefix for output files
    */
   void Simulate(int time_limit, int time_step, const std::string &output);
+  /**
+   * Run one replicate per seed on a pool of worker processes. The model is
+   * initialized once; each worker is forked from it, so it starts from the
+   * current state without rebuilding the model and shares its memory
+   * copy-on-write. Workers stream their counts back through shared memory,
+   * and they are written to one file with the columns of Simulate() after a
+   * leading seed column. Rows of different replicates are interleaved. A
+   * replicate that fails or crashes is reported and does not stop the
+   * others; rows it wrote before failing are kept. Observers run in the
+   * workers. POSIX only; throws std::runtime_error on Windows.
+   *
+   * @param seeds one seed per replicate
+   * @param time_limit simulation time limit
+   * @param time_step output time step
+   * @param output output file
+   * @param workers number of replicates that run at the same time
+   */
+  EnsembleReport SimulateEnsemble(const std::vector<int> &seeds,
+                                  int time_limit, int time_step,
+                                  const std::string &output, int workers);
+  /**
+   * Execute a fixed number of reactions. Initializes the model on first use.
+   *
+   * @param iterations number of reactions to execute
+   */
+  void Step(int iterations);
+  /**
+   * Execute reactions until simulated time reaches (or just passes) a given
+   * time point. Initializes the model on first use.
+   *
+   * @param time_limit simulated time at which to stop
+   */
+  void StepUntil(double time_limit);
+  /**
+   * Current simulated time.
+   */
+  double time() { return gillespie_.time(); }
+  /**
+   * Start recording changes for CollectChanges(). The first delta contains
+   * the counts of all species.
+   */
+  void TrackChanges();
+  /**
+   * Get all changes since the previous call (or since TrackChanges()).
+   *
+   * @return changed species counts, moved polymerases and created or
+   *  destroyed transcripts
+   */
+  ChangeDelta CollectChanges();
+  /**
+   * Counters for the simulation so far.
+   */
+  SimulationStats stats();
+  /**
+   * Export the state of every genome and transcript in one call: polymers
+   * with their masks, every bound polymerase, ribosome and RNase, and the
+   * coverage of every binding and release site.
+   */
+  PolymerStateExport ExportState();
+  /**
+   * Analyze the model when it is initialized and drop reactions that can
+   * never fire, along with species whose count can never change: species
+   * reactions with a reactant that is absent and never produced, binding
+   * reactions for polymerases that are absent and never produced, and
+   * ribosome binding reactions for genes that no available polymerase can
+   * transcribe. Pruning does not change simulation results, except that
+   * pruned species are left out of the output.
+   */
+  void EnablePruning();
+  /**
+   * Reactions and species removed at initialization (empty unless
+   * EnablePruning() was called).
+   */
+  const PruneReport &pruned() const { return prune_report_; }
+  /**
+   * Register an observer whose hooks are called while the simulation runs.
+   * Observers stay registered until another Model is created.
+   */
+  void AddObserver(std::shared_ptr<Observer> observer);
+  /**
+   * Load an observer from a shared library that exports
+   * pinetree_create_observer() (see Observer) and register it.
+   *
+   * @param path path to shared library
+   * @param args passed to the library's factory function
+   */
+  void LoadObserver(const std::string &path, const std::string &args = "");
+  /**
+   * Simulate fast reversible pairs of species reactions (e.g. repressor
+   * binding and unbinding) with the slow-scale SSA: each pair is held in
+   * quasi-equilibrium (see FastEquilibrium) instead of simulating every
+   * reaction. A pair A + B <-> C is fast if, when the model is initialized,
+   * its expected propensity at equilibrium is at least `ratio` times the
+   * total expected propensity of the other reactions that involve its
+   * species. Only species that take part in species reactions alone
+   * (not polymerases, binding sites, proteins or rate laws) are eligible, and
+   * pairs must not share species.
+   *
+   * @param ratio how much faster a pair must be than the reactions around it
+   */
+  void EnableSlowScale(double ratio = 100);
+  /**
+   * Fast reversible pairs found at initialization, e.g. "R + O <-> RO"
+   * (empty unless EnableSlowScale() was called).
+   */
+  const std::vector<std::string> &fast_equilibria() const {
+    return fast_equilibria_;
+  }
+  /**
+   * Publish snapshots of species counts and progress while the simulation
+   * runs, for monitoring threads to read with snapshot(). Snapshots are
+   * published when Simulate(), Step() or StepUntil() starts and returns,
+   * and whenever `interval` of simulated time has passed since the last one
+   * (after every reaction if `interval` is 0). Publishing never blocks the
+   * simulation.
+   *
+   * @param interval simulated time between snapshots
+   */
+  void EnableSnapshots(double interval);
+  /**
+   * The last published snapshot. Unlike every other method, this one may be
+   * called from any thread while the simulation runs.
+   */
+  Snapshot snapshot() const;
+  /**
+   * Select reactions with the rejection-based SSA (see
+   * Gillespie::EnableRejectionSampling()), which only recomputes the
+   * propensity of a species reaction when one of its reactant counts moves
+   * outside a fluctuation interval around its count, or when the reaction is
+   * a candidate whose bounds are not precise enough to decide. Results are
+   * exact. Faster for models dominated by species reactions with large
+   * counts.
+   *
+   * @param fluctuation width of the fluctuation interval, as a fraction of
+   *  each count
+   */
+  void EnableRejectionSampling(double fluctuation = 0.1);
+  /**
+   * Simulate polymers on several threads. Time advances in windows of
+   * `window` seconds. In each window, the polymerases, ribosomes and RNases
+   * on every polymer first move for the whole window, with polymers split
+   * across threads (a genome stays on one thread with the nascent
+   * transcripts attached to it); then binding, species reactions and
+   * scheduled events are simulated for the same window on the calling
+   * thread. Polymers therefore see species counts up to one window old, and
+   * the polymerases, ribosomes and proteins they release reach the rest of
+   * the model at the end of the window. Results approach exact dynamics as
+   * `window` shrinks, and are reproducible for a given seed and number of
+   * threads. Observers are not notified of reactions on polymers. Must be
+   * called before the model is initialized.
+   *
+   * @param threads number of threads, including the calling thread
+   * @param window simulated time per window (seconds)
+   */
+  void EnableParallel(int threads, double window = 0.1);
+  /**
+   * Simulate translation-only models, whose transcripts are all registered
+   * with RegisterTranscript() and no genomes, with a specialized engine: when
+   * the model is initialized, each transcript is replaced by a FlatTranscript
+   * with the same layout, which keeps ribosomes in flat arrays and finds
+   * binding sites and stop codons by position instead of with interval trees.
+   * Results are statistically equivalent, though not identical for a seed.
+   * Transcript objects registered earlier no longer change once the
+   * simulation starts. Must be called before the model is initialized.
+   */
+  void EnableTranslationEngine();
+  /**
+   * Write the time-weighted average of each count over each output interval
+   * instead of its value at the output time, so that counts that fluctuate
+   * faster than the time step are not aliased. Averages are updated
+   * whenever a count changes. The first row is the initial state. A
+   * ribosome density counts as 0 while there are no transcripts. In
+   * parallel mode, changes made by polymers count from the start of their
+   * window. Must be called before the model is initialized.
+   *
+   * @param extremes also write the minimum and maximum of each count in the
+   *  interval, in the columns protein_min, protein_max, transcript_min,
+   *  transcript_max, ribo_density_min and ribo_density_max
+   */
+  void EnableTimeAverages(bool extremes = false);
+  /**
+   * Translate a gene with a mean-field approximation (see MeanFieldTasep)
+   * instead of simulating each ribosome on it. Proteins are produced from
+   * every exposed ribosome binding site of the gene at the steady-state rate
+   * of ribosomes moving along it. This is much faster for heavily translated
+   * genes, but ignores the time ribosomes take to reach the stop codon and
+   * does not hold ribosomes on the gene, so it is only accurate when free
+   * ribosomes are abundant. Translation of the gene is not reported in
+   * ribosome densities or termination signals.
+   *
+   * @param gene name of gene
+   */
+  void EnableMeanFieldTranslation(const std::string &gene);
+  /**
+   * Replicate a registered genome during the simulation. Every copy of the
+   * genome replicates at `rate_constant`; each replication registers a new
+   * copy made with Genome::Replicate(), which is fully exposed and shares its
+   * structure with the original. Must be called before the simulation
+   * starts.
+   *
+   * @param genome name of genome
+   * @param rate_constant replication rate of each copy (per second)
+   * @param max_copies stop replicating at this many copies (0 for no limit)
+   */
+  void AddGenomeReplication(const std::string &genome, double rate_constant,
+                            int max_copies = 0);
+  /**
+   * Number of copies of a genome currently registered.
+   */
+  int genome_copies(const std::string &genome) const;
+  /**
+   * Change the copy number of a species at a fixed simulated time. The change
+   * is applied exactly at that time, without stopping the simulation.
+   *
+   * @param time simulated time of the change
+   * @param name species name
+   * @param change number of copies to add (negative to remove copies)
+   */
+  void ScheduleSpeciesChange(double time, const std::string &name,
+                             int change);
+  /**
+   * Change the rate constant of species reactions at a fixed simulated time.
+   * Applies to every reaction added with AddReaction() with exactly these
+   * reactants and products.
+   *
+   * @param time simulated time of the change
+   * @param reactants vector of reactant names
+   * @param products vector of product names
+   * @param rate_constant new macroscopic rate constant (0 switches the
+   *  reactions off)
+   */
+  void ScheduleRateChange(double time,
+                          const std::vector<std::string> &reactants,
+                          const std::vector<std::string> &products,
+                          double rate_constant);
+  /**
+   * Register a genome at a fixed simulated time, e.g. to simulate infection.
+   * The genome must be complete and must not be registered otherwise. A
+   * genome that has the same name as a registered genome (or another
+   * scheduled genome) shares its binding reactions, like a replica. Must be
+   * called before the simulation starts.
+   *
+   * @param time simulated time at which the genome enters
+   * @param genome pointer to Genome object
+   */
+  void ScheduleGenome(double time, Genome::Ptr genome);
   /**
    * Set a seed for random number generator.
    */
   void seed(int seed);
+  /**
+   * Hash of everything that determines the output of Simulate(): the model
+   * definition, the seed, the simulation parameters and the pinetree
+   * version, as 16 hexadecimal digits. Identical definitions hash equally
+   * however they were built. The definition is hashed as it was when the
+   * model was initialized.
+   *
+   * @param time_limit simulation time limit
+   * @param time_step output time step
+   */
+  std::string Hash(int time_limit, int time_step);
+  /**
+   * Cache simulation output in an existing directory, in files named by
+   * Hash(). Simulate() then copies the output of an earlier run with the same
+   * hash instead of simulating, and stores the output of new runs. Only
+   * seeded models simulated from the start without observers are cached;
+   * after a cached run the model itself has not advanced.
+   *
+   * @param directory cache directory
+   */
+  void EnableCache(const std::string &directory);
   /**
    * Add species to simulation.
    *
@@ -63,6 +399,23 @@ class Model : public std::enable_shared_from_this<Model> {
   void AddReaction(double rate_constant,
                    const std::vector<std::string> &reactants,
                    const std::vector<std::string> &products);
+  /**
+   * Add a species reaction with a non-mass-action rate law, such as a Hill
+   * function. The rate law is an expression over species counts and named
+   * parameters (see RateLaw) that gives the propensity in reactions per
+   * second directly, without conversion from a macroscopic rate constant.
+   * Only the species in the rate law and the reactants and products of the
+   * reaction trigger updates of its propensity.
+   *
+   * @param rate_law propensity of the reaction, e.g. "k * A^n / (K^n + A^n)"
+   * @param parameters values of named constants in the rate law
+   * @param reactants vector of reactant names
+   * @param products vector of product names
+   */
+  void AddRateLawReaction(const std::string &rate_law,
+                          const std::map<std::string, double> &parameters,
+                          const std::vector<std::string> &reactants,
+                          const std::vector<std::string> &products);
   /**
    * Add a genome to the list of reactions.
    *
@@ -83,6 +436,12 @@ class Model : public std::enable_shared_from_this<Model> {
    * TODO: Move to species tracker.
    */
   void CountTermination(const std::string &name);
+  /**
+   * Signal to fire when a polymerase or ribosome terminates on any registered
+   * genome or transcript. Arguments are the name of the polymerase and the
+   * name of the gene (or "NA" if it ran off the end of the polymer).
+   */
+  Signal<const std::string &, const std::string &> termination_signal_;
 
  private:
   /**
@@ -109,16 +468,169 @@ class Model : public std::enable_shared_from_this<Model> {
    * Has this model been initialized?
    */
   bool initialized_ = false;
+  /**
+   * Total number of transcripts registered, including degraded transcripts.
+   */
+  long transcripts_registered_ = 0;
+  /**
+   * Largest number of transcripts tracked at any one time.
+   */
+  long peak_transcripts_ = 0;
+  /**
+   * Vector of all species reactions in simulation
+   */
+  std::vector<std::shared_ptr<SpeciesReaction>> species_reactions_;
+  std::vector<std::shared_ptr<RateLawReaction>> rate_law_reactions_;
+  /**
+   * Should dead reactions and species be pruned at initialization?
+   */
+  bool pruning_ = false;
+  PruneReport prune_report_;
+  /**
+   * Speed-up a reversible pair needs to be held in quasi-equilibrium (0 if
+   * the slow-scale SSA is disabled), and the pairs that are.
+   */
+  double slow_scale_ratio_ = 0;
+  std::vector<std::shared_ptr<FastEquilibrium>> equilibria_;
+  std::vector<std::string> fast_equilibria_;
+  /**
+   * Fluctuation interval of rejection-based sampling (0 if disabled).
+   */
+  double fluctuation_ = 0;
+  /**
+   * Should fixed transcripts be replaced with FlatTranscript objects?
+   */
+  bool translation_engine_ = false;
+  void UseTranslationEngine();
+  /**
+   * Should output rows be averaged over each output interval (with their
+   * extremes)?
+   */
+  bool time_averages_ = false;
+  bool time_extremes_ = false;
+  /**
+   * Threads and window length of the parallel mode (0 threads if disabled),
+   * whether it is running, and the polymers it simulates outside of
+   * gillespie_, with the reactions they executed and how many were removed.
+   */
+  int parallel_threads_ = 0;
+  double parallel_window_ = 0;
+  bool parallel_ = false;
+  std::vector<std::shared_ptr<PolymerWrapper>> polymers_;
+  long parallel_events_ = 0;
+  long parallel_removed_ = 0;
+  /**
+   * Simulate one window of the parallel mode, ending no later than
+   * `time_limit`.
+   */
+  void AdvanceParallel(double time_limit);
+  /**
+   * Reactions executed, and polymers removed, in both modes.
+   */
+  long events() const { return gillespie_.iteration() + parallel_events_; }
+  long removed() const { return gillespie_.removed() + parallel_removed_; }
+  /**
+   * Published snapshots (null unless EnableSnapshots() was called), how
+   * often to publish them, and when the next one is due.
+   */
+  std::unique_ptr<SnapshotBuffer> snapshots_;
+  double snapshot_interval_ = 0;
+  double next_snapshot_ = 0;
+  /**
+   * Execute one reaction (one window in parallel mode, ending no later than
+   * `time_limit`) and publish a snapshot if one is due.
+   */
+  void Advance(
+      double time_limit = std::numeric_limits<double>::infinity());
+  /**
+   * Write counts every `time_step` until `time_limit`, as in Simulate().
+   */
+  void WriteSamples(std::ostream &out, int time_limit, int time_step);
+  /**
+   * Header of the output file, after any leading columns.
+   */
+  std::string CountsHeader() const;
+  void PublishSnapshot();
+  /**
+   * Genes translated with the mean-field approximation.
+   */
+  std::set<std::string> mean_field_genes_;
+  /**
+   * Replication rate constant and copy limit of replicating genomes.
+   */
+  std::map<std::string, std::pair<double, int>> genome_replication_;
   /**
    * Map of terminations.
    */
   std::map<std::string, int> terminations_;
+  /**
+   * Random seed, if one was set.
+   */
+  int seed_ = 0;
+  bool seeded_ = false;
+  /**
+   * Result cache directory (empty if caching is disabled).
+   */
+  std::string cache_directory_;
+  bool cache_hit_ = false;
+  /**
+   * Hash of the model definition, taken when the model is initialized.
+   */
+  Fnv1a definition_hash_;
+  Fnv1a DefinitionHash();
+  /**
+   * Species whose count is increased by a scheduled event.
+   */
+  std::set<std::string> scheduled_species_;
+  /**
+   * Genomes that are registered by a scheduled event.
+   */
+  Genome::VecPtr scheduled_genomes_;
+  /**
+   * Reactant and product names of scheduled rate changes, checked when the
+   * model is initialized.
+   */
+  std::vector<std::pair<std::vector<std::string>, std::vector<std::string>>>
+      scheduled_rate_changes_;
+  /**
+   * Hash of all scheduled events, in the order they were scheduled.
+   */
+  Fnv1a events_hash_;
+  void CheckScheduleTime(double time);
+  /**
+   * Registered genomes, followed by scheduled genomes that do not share a
+   * name with an earlier genome.
+   */
+  Genome::VecPtr DefinedGenomes();
   /**
    * Add a generic polymer to the list of reactions.
    *
    * @param polymer pointer to Polymer object
    */
   void RegisterPolymer(Polymer::Ptr polymer);
+  /**
+   * Find all species that are present or can be produced: species with a
+   * non-zero count, products of reactions whose reactants can all be
+   * present, and (treating any promoter as potentially free) ribosome
+   * binding sites that can be transcribed and proteins that can be
+   * translated.
+   */
+  std::set<std::string> ReachableSpecies();
+  /**
+   * Unlink species reactions with a reactant that is not reachable.
+   */
+  void PruneSpeciesReactions(const std::set<std::string> &reachable);
+  /**
+   * Find fast reversible pairs of species reactions and replace them with
+   * FastEquilibrium objects.
+   */
+  void FindFastEquilibria();
+  /**
+   * Forward polymer termination events to termination_signal_.
+   */
+  void ForwardTermination(std::shared_ptr<PolymerWrapper> wrapper,
+                          const std::string &pol_name,
+                          const std::string &gene_name);
 };
 
 #endif  // header guard
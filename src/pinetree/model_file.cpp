@@ -0,0 +1,512 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "model_file.hpp"
+
+namespace {
+
+/**
+ * A single non-blank, comment-stripped line of a model file.
+ */
+struct Line {
+  int indent;
+  std::string content;
+  int number;
+};
+
+std::string Trim(const std::string &text) {
+  auto first = text.find_first_not_of(" \t\r");
+  if (first == std::string::npos) {
+    return "";
+  }
+  auto last = text.find_last_not_of(" \t\r");
+  return text.substr(first, last - first + 1);
+}
+
+// Remove a trailing comment, ignoring '#' characters inside quotes or in the
+// middle of a plain scalar (e.g. "gene#2").
+std::string StripComment(const std::string &text) {
+  char quote = 0;
+  for (std::size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    if (quote != 0) {
+      if (c == quote) {
+        quote = 0;
+      }
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '#' && (i == 0 || text[i - 1] == ' ' ||
+                            text[i - 1] == '\t')) {
+      return text.substr(0, i);
+    }
+  }
+  return text;
+}
+
+int BracketDepth(const std::string &text) {
+  int depth = 0;
+  for (char c : text) {
+    if (c == '[') {
+      depth++;
+    } else if (c == ']') {
+      depth--;
+    }
+  }
+  return depth;
+}
+
+std::string Unquote(const std::string &text) {
+  if (text.size() >= 2 && (text.front() == '"' || text.front() == '\'') &&
+      text.back() == text.front()) {
+    return text.substr(1, text.size() - 2);
+  }
+  return text;
+}
+
+// Find the ':' separating a mapping key from its value, or npos if this
+// line is not a key-value pair.
+std::size_t FindKeySeparator(const std::string &text) {
+  char quote = 0;
+  for (std::size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    if (quote != 0) {
+      if (c == quote) {
+        quote = 0;
+      }
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '[') {
+      return std::string::npos;
+    } else if (c == ':' && (i + 1 == text.size() || text[i + 1] == ' ')) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+bool IsSequenceItem(const std::string &content) {
+  return content == "-" || content.compare(0, 2, "- ") == 0;
+}
+
+class Parser {
+ public:
+  explicit Parser(std::istream &in) {
+    std::string raw;
+    int number = 0;
+    while (std::getline(in, raw)) {
+      number++;
+      std::string text = StripComment(raw);
+      std::string content = Trim(text);
+      if (content.empty() || content == "---") {
+        continue;
+      }
+      int indent = text.find_first_not_of(" ");
+      // Join multi-line flow sequences into a single line
+      if (!lines_.empty() && BracketDepth(pending_) > 0) {
+        lines_.back().content += " " + content;
+        pending_ += content;
+        continue;
+      }
+      lines_.push_back(Line{indent, content, number});
+      pending_ = content;
+    }
+  }
+
+  ModelFileNode Parse() {
+    if (lines_.empty()) {
+      return ModelFileNode();
+    }
+    auto root = ParseBlock(lines_[0].indent);
+    if (pos_ < lines_.size()) {
+      Error("unexpected indentation");
+    }
+    return root;
+  }
+
+ private:
+  std::vector<Line> lines_;
+  std::size_t pos_ = 0;
+  std::string pending_;
+
+  void Error(const std::string &message) {
+    int number = pos_ < lines_.size() ? lines_[pos_].number : -1;
+    throw std::invalid_argument("Model file: " + message + " (line " +
+                                std::to_string(number) + ").");
+  }
+
+  ModelFileNode ParseBlock(int indent) {
+    if (lines_[pos_].content.front() == '[') {
+      // Flow sequence on its own line(s) below its key
+      return ParseScalar(lines_[pos_++].content);
+    }
+    if (IsSequenceItem(lines_[pos_].content)) {
+      return ParseSequence(indent);
+    }
+    return ParseMapping(indent);
+  }
+
+  ModelFileNode ParseSequence(int indent) {
+    ModelFileNode node;
+    node.kind = ModelFileNode::kSequence;
+    while (pos_ < lines_.size() && lines_[pos_].indent == indent &&
+           IsSequenceItem(lines_[pos_].content)) {
+      Line &line = lines_[pos_];
+      std::string rest = Trim(line.content.substr(1));
+      if (rest.empty()) {
+        pos_++;
+        if (pos_ < lines_.size() && lines_[pos_].indent > indent) {
+          node.items.push_back(ParseBlock(lines_[pos_].indent));
+        } else {
+          node.items.push_back(ModelFileNode());
+        }
+      } else if (FindKeySeparator(rest) != std::string::npos ||
+                 IsSequenceItem(rest)) {
+        // Inline mapping (or nested sequence) starting on the item line;
+        // re-indent the line to the column of its first key.
+        int offset = line.content.size() - rest.size();
+        line.indent = indent + offset;
+        line.content = rest;
+        node.items.push_back(ParseBlock(line.indent));
+      } else {
+        node.items.push_back(ParseScalar(rest));
+        pos_++;
+      }
+    }
+    return node;
+  }
+
+  ModelFileNode ParseMapping(int indent) {
+    ModelFileNode node;
+    node.kind = ModelFileNode::kMapping;
+    while (pos_ < lines_.size() && lines_[pos_].indent == indent &&
+           !IsSequenceItem(lines_[pos_].content)) {
+      const std::string content = lines_[pos_].content;
+      auto sep = FindKeySeparator(content);
+      if (sep == std::string::npos) {
+        Error("expected 'key: value'");
+      }
+      std::string key = Unquote(Trim(content.substr(0, sep)));
+      std::string value = Trim(content.substr(sep + 1));
+      if (node.Find(key) != nullptr) {
+        Error("duplicate key '" + key + "'");
+      }
+      pos_++;
+      if (!value.empty()) {
+        node.fields.emplace_back(key, ParseScalar(value));
+      } else if (pos_ < lines_.size() && lines_[pos_].indent > indent) {
+        node.fields.emplace_back(key, ParseBlock(lines_[pos_].indent));
+      } else if (pos_ < lines_.size() && lines_[pos_].indent == indent &&
+                 IsSequenceItem(lines_[pos_].content)) {
+        // Sequences may be written at the same indentation as their key
+        node.fields.emplace_back(key, ParseSequence(indent));
+      } else {
+        node.fields.emplace_back(key, ModelFileNode());
+      }
+    }
+    return node;
+  }
+
+  ModelFileNode ParseScalar(const std::string &value) {
+    ModelFileNode node;
+    if (value.front() == '[') {
+      if (value.back() != ']') {
+        Error("unterminated flow sequence");
+      }
+      node.kind = ModelFileNode::kSequence;
+      std::stringstream items(value.substr(1, value.size() - 2));
+      std::string item;
+      while (std::getline(items, item, ',')) {
+        item = Trim(item);
+        if (!item.empty()) {
+          ModelFileNode child;
+          child.kind = ModelFileNode::kScalar;
+          child.scalar = Unquote(item);
+          node.items.push_back(child);
+        }
+      }
+      return node;
+    }
+    node.kind = ModelFileNode::kScalar;
+    node.scalar = Unquote(value);
+    return node;
+  }
+};
+
+std::vector<std::string> StringList(const ModelFileNode *node) {
+  std::vector<std::string> out;
+  if (node == nullptr || node->kind == ModelFileNode::kNull) {
+    return out;
+  }
+  if (node->kind != ModelFileNode::kSequence) {
+    throw std::invalid_argument("Model file: expected a list of names.");
+  }
+  for (const auto &item : node->items) {
+    out.push_back(item.AsString());
+  }
+  return out;
+}
+
+// Read an interaction map of the form {pol_name: {field: value}}.
+std::map<std::string, double> Interactions(const ModelFileNode &element,
+                                           const std::string &field) {
+  std::map<std::string, double> out;
+  const auto *interactions = element.Find("interactions");
+  if (interactions == nullptr) {
+    return out;
+  }
+  for (const auto &pol : interactions->fields) {
+    out[pol.first] = pol.second.Require(field, pol.first).AsDouble();
+  }
+  return out;
+}
+
+}  // namespace
+
+const ModelFileNode *ModelFileNode::Find(const std::string &key) const {
+  for (const auto &field : fields) {
+    if (field.first == key) {
+      return &field.second;
+    }
+  }
+  return nullptr;
+}
+
+const ModelFileNode &ModelFileNode::Require(const std::string &key,
+                                            const std::string &context) const {
+  const auto *node = Find(key);
+  if (node == nullptr) {
+    throw std::invalid_argument("Model file: '" + context +
+                                "' is missing required field '" + key + "'.");
+  }
+  return *node;
+}
+
+const std::string &ModelFileNode::AsString() const {
+  if (kind != kScalar) {
+    throw std::invalid_argument("Model file: expected a scalar value.");
+  }
+  return scalar;
+}
+
+double ModelFileNode::AsDouble() const {
+  const auto &text = AsString();
+  std::size_t used = 0;
+  double value = 0;
+  try {
+    value = std::stod(text, &used);
+  } catch (const std::exception &) {
+    used = 0;
+  }
+  if (used != text.size()) {
+    throw std::invalid_argument("Model file: '" + text +
+                                "' is not a number.");
+  }
+  return value;
+}
+
+int ModelFileNode::AsInt() const {
+  double value = AsDouble();
+  if (value != static_cast<int>(value)) {
+    throw std::invalid_argument("Model file: '" + scalar +
+                                "' is not an integer.");
+  }
+  return static_cast<int>(value);
+}
+
+bool ModelFileNode::AsBool() const {
+  std::string text = AsString();
+  std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+  if (text == "true" || text == "yes" || text == "1") {
+    return true;
+  }
+  if (text == "false" || text == "no" || text == "0") {
+    return false;
+  }
+  throw std::invalid_argument("Model file: '" + scalar +
+                              "' is not a boolean.");
+}
+
+ModelFile::ModelFile(std::istream &in) {
+  root_ = Parser(in).Parse();
+  if (root_.kind != ModelFileNode::kMapping) {
+    throw std::invalid_argument("Model file: top level must be a mapping.");
+  }
+  const auto &sim = root_.Require("simulation", "model");
+  if (sim.Find("seed") != nullptr) {
+    simulation_.seed = sim.Find("seed")->AsInt();
+  }
+  simulation_.runtime = int(sim.Require("runtime", "simulation").AsDouble());
+  if (sim.Find("time_step") != nullptr) {
+    simulation_.time_step = sim.Find("time_step")->AsInt();
+  }
+  if (sim.Find("cell_volume") != nullptr) {
+    simulation_.cell_volume = sim.Find("cell_volume")->AsDouble();
+  }
+}
+
+ModelFile ModelFile::FromFile(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Could not open model file '" + path + "'.");
+  }
+  return ModelFile(in);
+}
+
+std::shared_ptr<Model> ModelFile::Build() const {
+  auto model = std::make_shared<Model>(simulation_.cell_volume);
+  if (simulation_.seed != -1) {
+    model->seed(simulation_.seed);
+  }
+
+  if (const auto *polymerases = root_.Find("polymerases")) {
+    for (const auto &pol : polymerases->items) {
+      model->AddPolymerase(pol.Require("name", "polymerases").AsString(),
+                           pol.Require("footprint", "polymerases").AsInt(),
+                           pol.Require("speed", "polymerases").AsDouble(),
+                           pol.Require("copy_number", "polymerases").AsInt());
+    }
+  }
+
+  double rbs_strength = 0.0;
+  if (const auto *ribosomes = root_.Find("ribosomes")) {
+    if (ribosomes->items.size() > 1) {
+      throw std::invalid_argument(
+          "Model file: only a single type of ribosome is supported.");
+    }
+    for (const auto &ribo : ribosomes->items) {
+      model->AddRibosome(ribo.Require("footprint", "ribosomes").AsInt(),
+                         ribo.Require("speed", "ribosomes").AsDouble(),
+                         ribo.Require("copy_number", "ribosomes").AsInt());
+      rbs_strength = ribo.Require("binding_constant", "ribosomes").AsDouble();
+    }
+  }
+
+  if (const auto *species = root_.Find("species")) {
+    for (const auto &item : species->items) {
+      model->AddSpecies(item.Require("name", "species").AsString(),
+                        item.Require("copy_number", "species").AsInt());
+    }
+  }
+
+  if (const auto *reactions = root_.Find("reactions")) {
+    for (const auto &rxn : reactions->items) {
+      if (const auto *rate_law = rxn.Find("rate_law")) {
+        std::map<std::string, double> parameters;
+        if (const auto *params = rxn.Find("parameters")) {
+          for (const auto &param : params->fields) {
+            parameters[param.first] = param.second.AsDouble();
+          }
+        }
+        model->AddRateLawReaction(rate_law->AsString(), parameters,
+                                  StringList(rxn.Find("reactants")),
+                                  StringList(rxn.Find("products")));
+        continue;
+      }
+      model->AddReaction(rxn.Require("propensity", "reactions").AsDouble(),
+                         StringList(rxn.Find("reactants")),
+                         StringList(rxn.Find("products")));
+    }
+  }
+
+  if (root_.Find("genome") != nullptr) {
+    int copy_number = 1;
+    const auto &genome = root_.Require("genome", "model");
+    if (genome.Find("copy_number") != nullptr) {
+      copy_number = genome.Find("copy_number")->AsInt();
+    }
+    for (int i = 0; i < copy_number; i++) {
+      model->RegisterGenome(BuildGenome(rbs_strength));
+    }
+    if (const auto *rate = genome.Find("replication_rate")) {
+      int max_copies = 0;
+      if (genome.Find("max_copies") != nullptr) {
+        max_copies = genome.Find("max_copies")->AsInt();
+      }
+      model->AddGenomeReplication(genome.Require("name", "genome").AsString(),
+                                  rate->AsDouble(), max_copies);
+    }
+  }
+
+  if (const auto *events = root_.Find("events")) {
+    for (const auto &event : events->items) {
+      double time = event.Require("time", "events").AsDouble();
+      if (const auto *species = event.Find("species")) {
+        model->ScheduleSpeciesChange(time, species->AsString(),
+                                     event.Require("change", "events").AsInt());
+      } else if (const auto *rate = event.Find("propensity")) {
+        model->ScheduleRateChange(time, StringList(event.Find("reactants")),
+                                  StringList(event.Find("products")),
+                                  rate->AsDouble());
+      } else if (const auto *copies = event.Find("genome_copies")) {
+        for (int i = 0; i < copies->AsInt(); i++) {
+          model->ScheduleGenome(time, BuildGenome(rbs_strength));
+        }
+      } else {
+        throw std::invalid_argument(
+            "Model file: events must define 'species', 'propensity' or "
+            "'genome_copies'.");
+      }
+    }
+  }
+  return model;
+}
+
+Genome::Ptr ModelFile::BuildGenome(double rbs_strength) const {
+  const auto &genome = root_.Require("genome", "model");
+  const ModelFileNode empty;
+  const auto *elements = root_.Find("elements");
+  if (elements == nullptr) {
+    elements = &empty;
+  }
+
+  // Genome length defaults to the furthest downstream element
+  int length = 0;
+  if (genome.Find("length") != nullptr) {
+    length = genome.Find("length")->AsInt();
+  } else {
+    for (const auto &element : elements->items) {
+      length = std::max(length, element.Require("stop", "elements").AsInt());
+    }
+  }
+
+  auto plasmid = std::make_shared<Genome>(
+      genome.Require("name", "genome").AsString(), length);
+
+  if (genome.Find("entered") != nullptr) {
+    plasmid->AddMask(genome.Find("entered")->AsInt(),
+                     StringList(genome.Find("mask_interactions")));
+  }
+
+  for (const auto &element : elements->items) {
+    const auto &type = element.Require("type", "elements").AsString();
+    const auto &name = element.Require("name", "elements").AsString();
+    int start = element.Require("start", name).AsInt();
+    int stop = element.Require("stop", name).AsInt();
+    if (type == "promoter") {
+      plasmid->AddPromoter(name, start, stop,
+                           Interactions(element, "binding_constant"));
+    } else if (type == "terminator") {
+      plasmid->AddTerminator(name, start, stop,
+                             Interactions(element, "efficiency"));
+    } else if (type == "transcript") {
+      int rbs = element.Require("rbs", name).AsInt();
+      plasmid->AddGene(name, start, stop, start + rbs, start, rbs_strength);
+    } else {
+      throw std::invalid_argument("Model file: unknown element type '" + type +
+                                  "'.");
+    }
+  }
+
+  if (const auto *weights = genome.Find("translation_weights")) {
+    std::vector<double> values;
+    for (const auto &item : weights->items) {
+      values.push_back(item.AsDouble());
+    }
+    plasmid->AddWeights(values);
+  }
+  return plasmid;
+}
@@ -0,0 +1,131 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_MODEL_FILE_HPP  // header guard
+#define SRC_MODEL_FILE_HPP
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.hpp"
+
+/**
+ * A node in the parsed tree of a model file. Model files use a small subset
+ * of YAML: block mappings, block sequences, flow sequences of scalars, plain
+ * or quoted scalars and '#' comments.
+ */
+struct ModelFileNode {
+  enum Kind { kNull, kScalar, kSequence, kMapping };
+  Kind kind = kNull;
+  /**
+   * Value of a scalar node.
+   */
+  std::string scalar;
+  /**
+   * Items of a sequence node.
+   */
+  std::vector<ModelFileNode> items;
+  /**
+   * Key-value pairs of a mapping node, in the order they appear in the file.
+   */
+  std::vector<std::pair<std::string, ModelFileNode>> fields;
+  /**
+   * Look up a key in a mapping node.
+   *
+   * @return pointer to value, or nullptr if the key is not present
+   */
+  const ModelFileNode *Find(const std::string &key) const;
+  /**
+   * Look up a key in a mapping node and throw if it is missing.
+   *
+   * @param key key to look up
+   * @param context name of enclosing section, used in error messages
+   */
+  const ModelFileNode &Require(const std::string &key,
+                               const std::string &context) const;
+  /**
+   * Scalar conversions. These throw std::invalid_argument if the node is not
+   * a scalar or cannot be converted.
+   */
+  const std::string &AsString() const;
+  double AsDouble() const;
+  int AsInt() const;
+  bool AsBool() const;
+};
+
+/**
+ * Parameters read from the `simulation` section of a model file.
+ */
+struct SimulationParameters {
+  /**
+   * Random seed. A value of -1 means no seed was given.
+   */
+  int seed = -1;
+  /**
+   * Simulated time at which to stop the simulation.
+   */
+  int runtime = 0;
+  /**
+   * Interval at which counts are written to the output file.
+   */
+  int time_step = 1;
+  /**
+   * Cell volume in liters.
+   */
+  double cell_volume = 8e-16;
+};
+
+/**
+ * Reads a model file (see the .yml files in tests/models for examples) and
+ * builds the corresponding Model. The schema has the sections `simulation`,
+ * `genome`, `polymerases`, `ribosomes`, `species`, `reactions` and
+ * `elements`.
+ */
+class ModelFile {
+ public:
+  /**
+   * Parse a model file from a stream.
+   *
+   * @param in stream containing the model definition
+   */
+  explicit ModelFile(std::istream &in);
+  /**
+   * Parse a model file from disk.
+   *
+   * @param path path to model file
+   */
+  static ModelFile FromFile(const std::string &path);
+  /**
+   * Construct a new Model from this definition. Note that constructing a
+   * Model resets the global SpeciesTracker, so only one model built from a
+   * ModelFile may be simulated at a time.
+   *
+   * @return pointer to a fully-populated, uninitialized Model
+   */
+  std::shared_ptr<Model> Build() const;
+  /**
+   * Getters and setters.
+   */
+  const SimulationParameters &simulation() const { return simulation_; }
+  const ModelFileNode &root() const { return root_; }
+
+ private:
+  /**
+   * Root node of the parsed file.
+   */
+  ModelFileNode root_;
+  /**
+   * Parameters from the `simulation` section.
+   */
+  SimulationParameters simulation_;
+  /**
+   * Construct a genome from the `genome` and `elements` sections.
+   *
+   * @param rbs_strength binding constant for ribosome binding sites
+   */
+  Genome::Ptr BuildGenome(double rbs_strength) const;
+};
+
+#endif  // header guard
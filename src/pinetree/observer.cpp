@@ -0,0 +1,54 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include "observer.hpp"
+
+void ObserverList::Add(std::shared_ptr<Observer> observer) {
+  if (!observer) {
+    throw std::invalid_argument("Observer must not be null.");
+  }
+  observers_.push_back(observer);
+}
+
+void ObserverList::Load(const std::string &path, const std::string &args) {
+#ifdef _WIN32
+  throw std::runtime_error(
+      "Loading observers from shared libraries is not supported on this "
+      "platform.");
+#else
+  void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    throw std::runtime_error("Could not load observer " + path + ": " +
+                             dlerror());
+  }
+  typedef Observer *(*Factory)(const char *);
+  auto factory =
+      reinterpret_cast<Factory>(dlsym(handle, "pinetree_create_observer"));
+  if (factory == nullptr) {
+    dlclose(handle);
+    throw std::runtime_error("Observer " + path +
+                             " does not export pinetree_create_observer.");
+  }
+  Observer *observer = factory(args.c_str());
+  if (observer == nullptr) {
+    dlclose(handle);
+    throw std::runtime_error("Observer " + path + " could not be created.");
+  }
+  // The library must stay loaded until its observer is destroyed
+  observers_.push_back(
+      std::shared_ptr<Observer>(observer, [handle](Observer *observer) {
+        delete observer;
+        dlclose(handle);
+      }));
+#endif
+}
+
+void ObserverList::Clear() {
+  observers_.clear();
+  time = 0;
+}
@@ -0,0 +1,130 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_OBSERVER_HPP  // header guard
+#define SRC_OBSERVER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Reaction;
+
+/**
+ * Interface for native code that measures a simulation while it runs.
+ * Override any of the hooks; the defaults do nothing. Hooks are called
+ * synchronously from inside the simulation loop, so they should be fast and
+ * must not modify the model. Current copy numbers can be read from
+ * SpeciesTracker::Instance().
+ *
+ * Observers are registered with Model::AddObserver(), or compiled into a
+ * shared library and loaded with Model::LoadObserver(). A shared library
+ * must export a factory function
+ *
+ *     extern "C" Observer *pinetree_create_observer(const char *args);
+ *
+ * that returns a new observer (see examples/observer_example.cpp).
+ */
+class Observer {
+ public:
+  virtual ~Observer() {}
+  /**
+   * A reaction fired. Called after the reaction and the hooks it triggered.
+   *
+   * @param time simulated time
+   * @param reaction reaction that fired (e.g. a SpeciesReaction,
+   *  BindPolymerase or PolymerWrapper)
+   */
+  virtual void OnReaction(double time, const Reaction &reaction) {}
+  /**
+   * A polymerase, ribosome or RNase bound to a polymer.
+   *
+   * @param pol_name name of polymerase ("__ribosome" or "__rnase" for
+   *  ribosomes and RNases)
+   * @param site name of promoter or binding site
+   * @param polymer_id id of genome or transcript
+   */
+  virtual void OnBind(double time, const std::string &pol_name,
+                      const std::string &site, int polymer_id) {}
+  /**
+   * A polymerase or ribosome terminated.
+   *
+   * @param gene name of gene (or "NA" if it ran off the end of the polymer)
+   */
+  virtual void OnTerminate(double time, const std::string &pol_name,
+                           const std::string &gene) {}
+  /**
+   * A transcript was created. Coordinates are genomic coordinates.
+   */
+  virtual void OnTranscriptCreated(double time, int id,
+                                   const std::string &name, int start,
+                                   int stop) {}
+  /**
+   * A transcript was completely degraded.
+   */
+  virtual void OnTranscriptDestroyed(double time, int id) {}
+  /**
+   * Counts were sampled for output by Model::Simulate().
+   */
+  virtual void OnSample(double time) {}
+};
+
+/**
+ * Observers registered with the model. Each hook site checks active() first,
+ * so a simulation without observers only pays for a branch on a flag.
+ */
+class ObserverList {
+ public:
+  bool active() const { return !observers_.empty(); }
+  /**
+   * Simulated time passed to hooks; kept current by Gillespie while active.
+   */
+  double time = 0;
+  void Add(std::shared_ptr<Observer> observer);
+  /**
+   * Load an observer from a shared library. Throws std::runtime_error if the
+   * library or its factory function cannot be loaded.
+   *
+   * @param path path to shared library
+   * @param args passed to the library's factory function
+   */
+  void Load(const std::string &path, const std::string &args);
+  void Clear();
+
+  void Reaction(const ::Reaction &reaction) const {
+    for (const auto &observer : observers_) {
+      observer->OnReaction(time, reaction);
+    }
+  }
+  void Bind(const std::string &pol_name, const std::string &site,
+            int polymer_id) const {
+    for (const auto &observer : observers_) {
+      observer->OnBind(time, pol_name, site, polymer_id);
+    }
+  }
+  void Terminate(const std::string &pol_name, const std::string &gene) const {
+    for (const auto &observer : observers_) {
+      observer->OnTerminate(time, pol_name, gene);
+    }
+  }
+  void TranscriptCreated(int id, const std::string &name, int start,
+                         int stop) const {
+    for (const auto &observer : observers_) {
+      observer->OnTranscriptCreated(time, id, name, start, stop);
+    }
+  }
+  void TranscriptDestroyed(int id) const {
+    for (const auto &observer : observers_) {
+      observer->OnTranscriptDestroyed(time, id);
+    }
+  }
+  void Sample() const {
+    for (const auto &observer : observers_) {
+      observer->OnSample(time);
+    }
+  }
+
+ private:
+  std::vector<std::shared_ptr<Observer>> observers_;
+};
+
+#endif  // header guard
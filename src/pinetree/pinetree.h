@@ -0,0 +1,151 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+/**
+ * C interface to the pinetree simulator, for embedding pinetree in programs
+ * that do not use Python. All objects are opaque handles owned by the caller
+ * and released with the matching *_free function.
+ *
+ * Functions that can fail return 0 on success and -1 on error (or NULL for
+ * functions that return a handle); pt_last_error() then describes the error.
+ *
+ * Only one model may exist at a time, because all models share a single
+ * species tracker. Creating a model invalidates any species handles obtained
+ * from a previous model.
+ */
+
+#ifndef SRC_PINETREE_H  // header guard
+#define SRC_PINETREE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Version of this interface. Incremented whenever an existing function
+ * changes in an incompatible way.
+ */
+#define PINETREE_C_API_VERSION 1
+
+typedef struct pt_model pt_model;
+typedef struct pt_genome pt_genome;
+
+/**
+ * Called whenever a polymerase or ribosome terminates.
+ *
+ * @param user_data pointer given when the callback was registered
+ * @param polymerase name of the terminating polymerase or "__ribosome"
+ * @param gene name of the gene (or "NA" if the polymerase ran off the end of
+ *  the polymer)
+ */
+typedef void (*pt_termination_callback)(void *user_data,
+                                        const char *polymerase,
+                                        const char *gene);
+
+int pt_api_version(void);
+
+/**
+ * Description of the last error on the calling thread, or an empty string.
+ */
+const char *pt_last_error(void);
+
+/**
+ * Model construction.
+ */
+pt_model *pt_model_new(double cell_volume);
+/**
+ * Build a model from a model file (see the pinetree command line runner).
+ * If runtime and time_step are not NULL, they receive the values from the
+ * simulation section of the file.
+ */
+pt_model *pt_model_load(const char *path, int *runtime, int *time_step);
+void pt_model_free(pt_model *model);
+int pt_model_seed(pt_model *model, int seed);
+int pt_model_add_species(pt_model *model, const char *name, int copy_number);
+int pt_model_add_polymerase(pt_model *model, const char *name, int footprint,
+                            double mean_speed, int copy_number);
+int pt_model_add_ribosome(pt_model *model, int footprint, double mean_speed,
+                          int copy_number);
+int pt_model_add_reaction(pt_model *model, double rate_constant,
+                          const char *const *reactants, int num_reactants,
+                          const char *const *products, int num_products);
+int pt_model_register_genome(pt_model *model, pt_genome *genome);
+
+/**
+ * Genome construction. Interactions are given as parallel arrays of
+ * polymerase names and binding constants (or termination efficiencies).
+ */
+pt_genome *pt_genome_new(const char *name, int length);
+void pt_genome_free(pt_genome *genome);
+int pt_genome_add_mask(pt_genome *genome, int start,
+                       const char *const *polymerases, int num_polymerases);
+int pt_genome_add_promoter(pt_genome *genome, const char *name, int start,
+                           int stop, const char *const *polymerases,
+                           const double *binding_constants,
+                           int num_polymerases);
+int pt_genome_add_terminator(pt_genome *genome, const char *name, int start,
+                             int stop, const char *const *polymerases,
+                             const double *efficiencies, int num_polymerases);
+int pt_genome_add_gene(pt_genome *genome, const char *name, int start, int stop,
+                       int rbs_start, int rbs_stop, double rbs_strength);
+int pt_genome_add_weights(pt_genome *genome, const double *weights,
+                          int num_weights);
+
+/**
+ * Simulation. The model is initialized on the first step. Stepping does not
+ * allocate memory on the heap beyond what the simulation itself requires.
+ */
+int pt_model_step(pt_model *model, int iterations);
+int pt_model_step_until(pt_model *model, double time_limit);
+double pt_model_time(pt_model *model);
+
+/**
+ * Counts. A species handle points directly at the copy number of a species
+ * and can be dereferenced after every step without a name lookup. Species
+ * that do not exist yet (e.g. proteins not yet synthesized) are added with a
+ * count of 0, so asking for a handle to a misspelled name adds a row that
+ * stays at 0 to every later output file and to pt_model_num_species().
+ * Handles stay valid until another model is created: species with a handle
+ * are never removed when unused species are pruned at initialization.
+ *
+ * @return pointer to copy number, or NULL on error
+ */
+const int *pt_model_species_handle(pt_model *model, const char *name);
+/**
+ * @return copy number of species (0 if it is not tracked), or -1 on error
+ */
+int pt_model_species_count(pt_model *model, const char *name);
+/**
+ * @return number of transcripts of a gene
+ */
+int pt_model_transcript_count(pt_model *model, const char *name);
+/**
+ * Number of species, including polymerases, ribosomes and binding sites.
+ */
+int pt_model_num_species(pt_model *model);
+/**
+ * Copy up to max_counts species copy numbers into counts, in the order of
+ * pt_model_species_name().
+ *
+ * @return number of counts written
+ */
+int pt_model_counts(pt_model *model, int *counts, int max_counts);
+/**
+ * Name of the species at a given index (in alphabetical order), or NULL if
+ * the index is out of range. The string is owned by the model.
+ */
+const char *pt_model_species_name(pt_model *model, int index);
+
+/**
+ * Register a callback for termination events. Returns an id that can be
+ * passed to pt_model_remove_callback(), or -1 on error (including a NULL
+ * callback).
+ */
+int pt_model_on_termination(pt_model *model, pt_termination_callback callback,
+                            void *user_data);
+int pt_model_remove_callback(pt_model *model, int callback_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // header guard
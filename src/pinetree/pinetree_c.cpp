@@ -0,0 +1,301 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.hpp"
+#include "model_file.hpp"
+#include "pinetree.h"
+#include "tracker.hpp"
+
+struct pt_model {
+  std::shared_ptr<Model> model;
+  /**
+   * Species names in the order of pt_model_species_name(), and the
+   * SpeciesTracker::species_version() they were listed at.
+   */
+  std::vector<const char *> species_names;
+  long species_version;
+};
+
+struct pt_genome {
+  Genome::Ptr genome;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+void SetError(const std::string &message) { last_error = message; }
+
+// Run a function, converting exceptions to an error code.
+template <typename F>
+int Guard(F func) {
+  try {
+    func();
+    return 0;
+  } catch (const std::exception &err) {
+    SetError(err.what());
+  } catch (...) {
+    SetError("unknown error");
+  }
+  return -1;
+}
+
+bool CheckHandle(const void *handle, const char *function) {
+  if (handle == nullptr) {
+    SetError(std::string(function) + ": NULL handle");
+    return false;
+  }
+  return true;
+}
+
+std::vector<std::string> Names(const char *const *names, int count) {
+  return std::vector<std::string>(names, names + count);
+}
+
+std::map<std::string, double> Interactions(const char *const *names,
+                                           const double *values, int count) {
+  std::map<std::string, double> interactions;
+  for (int i = 0; i < count; i++) {
+    interactions[names[i]] = values[i];
+  }
+  return interactions;
+}
+
+}  // namespace
+
+extern "C" {
+
+int pt_api_version(void) { return PINETREE_C_API_VERSION; }
+
+const char *pt_last_error(void) { return last_error.c_str(); }
+
+pt_model *pt_model_new(double cell_volume) {
+  pt_model *handle = nullptr;
+  Guard([&] { handle = new pt_model{std::make_shared<Model>(cell_volume)}; });
+  return handle;
+}
+
+pt_model *pt_model_load(const char *path, int *runtime, int *time_step) {
+  pt_model *handle = nullptr;
+  Guard([&] {
+    auto model_file = ModelFile::FromFile(path);
+    handle = new pt_model{model_file.Build()};
+    if (runtime != nullptr) {
+      *runtime = model_file.simulation().runtime;
+    }
+    if (time_step != nullptr) {
+      *time_step = model_file.simulation().time_step;
+    }
+  });
+  return handle;
+}
+
+void pt_model_free(pt_model *model) { delete model; }
+
+int pt_model_seed(pt_model *model, int seed) {
+  if (!CheckHandle(model, "pt_model_seed")) return -1;
+  return Guard([&] { model->model->seed(seed); });
+}
+
+int pt_model_add_species(pt_model *model, const char *name, int copy_number) {
+  if (!CheckHandle(model, "pt_model_add_species")) return -1;
+  return Guard([&] { model->model->AddSpecies(name, copy_number); });
+}
+
+int pt_model_add_polymerase(pt_model *model, const char *name, int footprint,
+                            double mean_speed, int copy_number) {
+  if (!CheckHandle(model, "pt_model_add_polymerase")) return -1;
+  return Guard([&] {
+    model->model->AddPolymerase(name, footprint, mean_speed, copy_number);
+  });
+}
+
+int pt_model_add_ribosome(pt_model *model, int footprint, double mean_speed,
+                          int copy_number) {
+  if (!CheckHandle(model, "pt_model_add_ribosome")) return -1;
+  return Guard(
+      [&] { model->model->AddRibosome(footprint, mean_speed, copy_number); });
+}
+
+int pt_model_add_reaction(pt_model *model, double rate_constant,
+                          const char *const *reactants, int num_reactants,
+                          const char *const *products, int num_products) {
+  if (!CheckHandle(model, "pt_model_add_reaction")) return -1;
+  return Guard([&] {
+    model->model->AddReaction(rate_constant, Names(reactants, num_reactants),
+                              Names(products, num_products));
+  });
+}
+
+int pt_model_register_genome(pt_model *model, pt_genome *genome) {
+  if (!CheckHandle(model, "pt_model_register_genome") ||
+      !CheckHandle(genome, "pt_model_register_genome")) {
+    return -1;
+  }
+  return Guard([&] { model->model->RegisterGenome(genome->genome); });
+}
+
+pt_genome *pt_genome_new(const char *name, int length) {
+  pt_genome *handle = nullptr;
+  Guard([&] {
+    handle = new pt_genome{std::make_shared<Genome>(name, length)};
+  });
+  return handle;
+}
+
+void pt_genome_free(pt_genome *genome) { delete genome; }
+
+int pt_genome_add_mask(pt_genome *genome, int start,
+                       const char *const *polymerases, int num_polymerases) {
+  if (!CheckHandle(genome, "pt_genome_add_mask")) return -1;
+  return Guard([&] {
+    genome->genome->AddMask(start, Names(polymerases, num_polymerases));
+  });
+}
+
+int pt_genome_add_promoter(pt_genome *genome, const char *name, int start,
+                           int stop, const char *const *polymerases,
+                           const double *binding_constants,
+                           int num_polymerases) {
+  if (!CheckHandle(genome, "pt_genome_add_promoter")) return -1;
+  return Guard([&] {
+    genome->genome->AddPromoter(
+        name, start, stop,
+        Interactions(polymerases, binding_constants, num_polymerases));
+  });
+}
+
+int pt_genome_add_terminator(pt_genome *genome, const char *name, int start,
+                             int stop, const char *const *polymerases,
+                             const double *efficiencies, int num_polymerases) {
+  if (!CheckHandle(genome, "pt_genome_add_terminator")) return -1;
+  return Guard([&] {
+    genome->genome->AddTerminator(
+        name, start, stop,
+        Interactions(polymerases, efficiencies, num_polymerases));
+  });
+}
+
+int pt_genome_add_gene(pt_genome *genome, const char *name, int start, int stop,
+                       int rbs_start, int rbs_stop, double rbs_strength) {
+  if (!CheckHandle(genome, "pt_genome_add_gene")) return -1;
+  return Guard([&] {
+    genome->genome->AddGene(name, start, stop, rbs_start, rbs_stop,
+                            rbs_strength);
+  });
+}
+
+int pt_genome_add_weights(pt_genome *genome, const double *weights,
+                          int num_weights) {
+  if (!CheckHandle(genome, "pt_genome_add_weights")) return -1;
+  return Guard([&] {
+    genome->genome->AddWeights(
+        std::vector<double>(weights, weights + num_weights));
+  });
+}
+
+int pt_model_step(pt_model *model, int iterations) {
+  if (!CheckHandle(model, "pt_model_step")) return -1;
+  return Guard([&] { model->model->Step(iterations); });
+}
+
+int pt_model_step_until(pt_model *model, double time_limit) {
+  if (!CheckHandle(model, "pt_model_step_until")) return -1;
+  return Guard([&] { model->model->StepUntil(time_limit); });
+}
+
+double pt_model_time(pt_model *model) {
+  if (!CheckHandle(model, "pt_model_time")) return -1;
+  return model->model->time();
+}
+
+const int *pt_model_species_handle(pt_model *model, const char *name) {
+  if (!CheckHandle(model, "pt_model_species_handle")) return nullptr;
+  const int *handle = nullptr;
+  Guard([&] {
+    auto &tracker = SpeciesTracker::Instance();
+    handle = tracker.FindSpecies(name);
+    // Pruning would leave the handle dangling
+    tracker.Pin(name);
+  });
+  return handle;
+}
+
+int pt_model_species_count(pt_model *model, const char *name) {
+  if (!CheckHandle(model, "pt_model_species_count")) return -1;
+  const auto &species = SpeciesTracker::Instance().species();
+  auto it = species.find(name);
+  return (it == species.end()) ? 0 : it->second;
+}
+
+int pt_model_transcript_count(pt_model *model, const char *name) {
+  if (!CheckHandle(model, "pt_model_transcript_count")) return -1;
+  const auto &transcripts = SpeciesTracker::Instance().transcripts();
+  auto it = transcripts.find(name);
+  return (it == transcripts.end()) ? 0 : it->second;
+}
+
+int pt_model_num_species(pt_model *model) {
+  if (!CheckHandle(model, "pt_model_num_species")) return -1;
+  return SpeciesTracker::Instance().species().size();
+}
+
+int pt_model_counts(pt_model *model, int *counts, int max_counts) {
+  if (!CheckHandle(model, "pt_model_counts")) return -1;
+  int written = 0;
+  for (const auto &species : SpeciesTracker::Instance().species()) {
+    if (written == max_counts) {
+      break;
+    }
+    counts[written++] = species.second;
+  }
+  return written;
+}
+
+const char *pt_model_species_name(pt_model *model, int index) {
+  if (!CheckHandle(model, "pt_model_species_name")) return nullptr;
+  auto &tracker = SpeciesTracker::Instance();
+  if (model->species_version != tracker.species_version()) {
+    model->species_names.clear();
+    for (const auto &species : tracker.species()) {
+      model->species_names.push_back(species.first.c_str());
+    }
+    model->species_version = tracker.species_version();
+  }
+  if (index < 0 || index >= static_cast<int>(model->species_names.size())) {
+    SetError("pt_model_species_name: index out of range");
+    return nullptr;
+  }
+  return model->species_names[index];
+}
+
+int pt_model_on_termination(pt_model *model, pt_termination_callback callback,
+                            void *user_data) {
+  if (!CheckHandle(model, "pt_model_on_termination")) return -1;
+  if (callback == nullptr) {
+    SetError("pt_model_on_termination: NULL callback");
+    return -1;
+  }
+  int id = -1;
+  Guard([&] {
+    id = model->model->termination_signal_.Connect(
+        [callback, user_data](const std::string &pol_name,
+                              const std::string &gene_name) {
+          callback(user_data, pol_name.c_str(), gene_name.c_str());
+        });
+  });
+  return id;
+}
+
+int pt_model_remove_callback(pt_model *model, int callback_id) {
+  if (!CheckHandle(model, "pt_model_remove_callback")) return -1;
+  return Guard(
+      [&] { model->model->termination_signal_.Disconnect(callback_id); });
+}
+
+}  // extern "C"
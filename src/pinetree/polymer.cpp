@@ -6,6 +6,10 @@
 #include <iostream>
 
 MobileElementManager::MobileElementManager(const std::vector<double> &weights)
+    : weights_(std::make_shared<std::vector<double>>(weights)) {}
+
+MobileElementManager::MobileElementManager(
+    std::shared_ptr<const std::vector<double>> weights)
     : weights_(weights) {}
 
 void MobileElementManager::Insert(MobileElement::Ptr pol,
@@ -30,7 +34,7 @@ void MobileElementManager::Insert(MobileElement::Ptr pol,
   //Currently, this should only be weighted if pol is a ribosome
   if (pol->name() == "__ribosome") {
     // Cache polymerase speed, weighted
-    double weight = weights_[pol->stop() - 1];
+    double weight = (*weights_)[pol->stop() - 1];
     // Update total move propensity of this polymer
     prop_sum_ += weight * pol->speed();
     prop_list_.insert(prop_it, weight * pol->speed());
@@ -65,10 +69,11 @@ void MobileElementManager::Delete(int index) {
 void MobileElementManager::UpdatePropensity(int index) {
   auto pol = GetPol(index);
   int weight_index = pol->stop() - 1;
-  if (weight_index >= weights_.size() || weight_index < 0) {
+  const auto &weights = *weights_;
+  if (weight_index >= weights.size() || weight_index < 0) {
     throw std::runtime_error("Weight is missing for this position.");
   }
-  double weight = weights_[weight_index];
+  double weight = weights[weight_index];
   double new_speed = weight * pol->speed();
   double diff = new_speed - prop_list_[index];
   prop_sum_ += diff;
@@ -111,12 +116,16 @@ int MobileElementManager::Choose() {
 }
 
 Polymer::Polymer(const std::string &name, int start, int stop)
+    : Polymer(name, start, stop,
+              std::make_shared<std::vector<double>>(stop - start + 1, 1.0)) {}
+
+Polymer::Polymer(const std::string &name, int start, int stop,
+                 std::shared_ptr<const std::vector<double>> weights)
     : name_(name),
       start_(start),
       stop_(stop),
-      polymerases_(MobileElementManager(std::vector<double>())) {
-  weights_ = std::vector<double>(stop - start + 1, 1.0);
-  polymerases_ = MobileElementManager(weights_);
+      polymerases_(MobileElementManager(weights)),
+      weights_(weights) {
   std::map<std::string, double> interaction_map;
   mask_ = Mask(stop_ + 1, stop_, interaction_map);
 }
@@ -289,6 +298,9 @@ void Polymer::Bind(MobileElement::Ptr pol, const std::string &promoter_name) {
   }
   // Add polymerase to this polymer
   Attach(pol);
+  auto &tracker = SpeciesTracker::Instance();
+  pol->id(tracker.NextId());
+  tracker.journal_.LogPolymerase(id_, *pol);
 }
 
 void Polymer::Attach(MobileElement::Ptr pol) {
@@ -372,6 +384,7 @@ void Polymer::Move(int pol_index) {
   
   // Check if polymerase has run into a terminator
   bool terminating = CheckTermination(pol_index);
+  SpeciesTracker::Instance().journal_.LogPolymerase(id_, *pol, terminating);
   if (terminating && pol->name() != "__rnase") {
     std::vector<Interval<BindingSite::Ptr>> results;
     binding_sites_.findOverlapping(old_start, pol->stop(), results);
@@ -598,11 +611,9 @@ Transcript::Transcript(
     const std::string &name, int start, int stop,
     const std::vector<Interval<BindingSite::Ptr>> &rbs_intervals,
     const std::vector<Interval<ReleaseSite::Ptr>> &stop_site_intervals,
-    const Mask &mask, const std::vector<double> &weights)
-    : Polymer(name, start, stop) {
+    const Mask &mask, std::shared_ptr<const std::vector<double>> weights)
+    : Polymer(name, start, stop, weights) {
   mask_ = mask;
-  weights_ = weights;
-  polymerases_ = MobileElementManager(weights_);
   binding_intervals_ = rbs_intervals;
   release_intervals_ = stop_site_intervals;
   attached_ = true;
@@ -610,7 +621,6 @@ Transcript::Transcript(
 
 Transcript::Transcript(const std::string &name, int length)
     : Polymer(name, 1, length) {
-  weights_ = std::vector<double>(length, 1.0);
   attached_ = false;
   mask_ = Mask(stop_ + 1, stop_, std::map<std::string, double>());
 }
@@ -644,7 +654,7 @@ void Transcript::AddWeights(const std::vector<double> &transcript_weights) {
                             std::to_string(transcript_weights.size()) + " " +
                             std::to_string(stop_ - start_ + 1));
   }
-  weights_ = transcript_weights;
+  weights_ = std::make_shared<std::vector<double>>(transcript_weights);
 }
 
 void Transcript::Bind(MobileElement::Ptr pol,
@@ -654,7 +664,7 @@ void Transcript::Bind(MobileElement::Ptr pol,
 }
 
 const std::map<std::string, std::map<std::string, double>>
-    &Transcript::bindings() {
+    &Transcript::bindings() const {
   return bindings_;
 }
 
@@ -663,11 +673,13 @@ Genome::Genome(const std::string &name, int length,
                double rnase_speed, double rnase_footprint,
                double transcript_degradation_rate)
     : Polymer(name, 1, length),
+      layout_(std::make_shared<Layout>()),
       transcript_degradation_rate_(transcript_degradation_rate),
       transcript_degradation_rate_ext_(transcript_degradation_rate_ext),
       rnase_speed_(rnase_speed),
       rnase_footprint_(rnase_footprint) {
-  transcript_weights_ = std::vector<double>(length, 1.0);
+  layout_->transcript_weights =
+      std::make_shared<std::vector<double>>(length, 1.0);
   if (transcript_degradation_rate_ext != 0 || transcript_degradation_rate != 0) {
     if (!(rnase_speed_ != 0 && rnase_footprint_ != 0)) {
       throw std::runtime_error(
@@ -676,11 +688,61 @@ Genome::Genome(const std::string &name, int length,
   }
 }
 
+Genome::Genome(const Genome &parent, ReplicaTag)
+    : Polymer(parent.name_, parent.start_, parent.stop_, parent.weights_),
+      layout_(parent.layout_),
+      transcript_degradation_rate_(parent.transcript_degradation_rate_),
+      transcript_degradation_rate_ext_(parent.transcript_degradation_rate_ext_),
+      rnase_speed_(parent.rnase_speed_),
+      rnase_footprint_(parent.rnase_footprint_) {
+  // Copy promoters and terminators in their initial state
+  const auto &promoters = layout_->initialized ? layout_->promoters
+                                               : parent.binding_intervals_;
+  const auto &terminators = layout_->initialized ? layout_->terminators
+                                                 : parent.release_intervals_;
+  binding_intervals_.reserve(promoters.size());
+  for (const auto &interval : promoters) {
+    binding_intervals_.emplace_back(interval.start, interval.stop,
+                                    interval.value->Clone());
+  }
+  release_intervals_.reserve(terminators.size());
+  for (const auto &interval : terminators) {
+    release_intervals_.emplace_back(interval.start, interval.stop,
+                                    interval.value->Clone());
+  }
+}
+
+Genome::Ptr Genome::Replicate() const {
+  return Genome::Ptr(new Genome(*this, ReplicaTag()));
+}
+
+Genome::Layout &Genome::MutableLayout() {
+  if (layout_.use_count() > 1) {
+    layout_ = std::make_shared<Layout>(*layout_);
+  }
+  return *layout_;
+}
+
 void Genome::Initialize() {
+  if (!layout_->initialized) {
+    // Keep a copy of each promoter and terminator before anything covers
+    // them, for replicas
+    auto &layout = MutableLayout();
+    for (const auto &interval : binding_intervals_) {
+      layout.promoters.emplace_back(interval.start, interval.stop,
+                                    interval.value->Clone());
+    }
+    for (const auto &interval : release_intervals_) {
+      layout.terminators.emplace_back(interval.start, interval.stop,
+                                      interval.value->Clone());
+    }
+    layout.transcript_rbs =
+        IntervalTree<BindingSite::Ptr>(layout.transcript_rbs_intervals);
+    layout.transcript_stop_sites =
+        IntervalTree<ReleaseSite::Ptr>(layout.transcript_stop_site_intervals);
+    layout.initialized = true;
+  }
   Polymer::Initialize();
-  transcript_rbs_ = IntervalTree<BindingSite::Ptr>(transcript_rbs_intervals_);
-  transcript_stop_sites_ =
-      IntervalTree<ReleaseSite::Ptr>(transcript_stop_site_intervals_);
 }
 
 void Genome::AddMask(int start, const std::vector<std::string> &interactions) {
@@ -696,11 +758,11 @@ void Genome::AddPromoter(const std::string &name, int start, int stop,
   BindingSite::Ptr promoter =
       std::make_shared<BindingSite>(name, start, stop, interactions);
   binding_intervals_.emplace_back(start, stop, promoter);
-  bindings_[name] = interactions;
+  MutableLayout().bindings[name] = interactions;
 }
 
 const std::map<std::string, std::map<std::string, double>> &Genome::bindings() {
-  return bindings_;
+  return layout_->bindings;
 }
 
 void Genome::AddTerminator(const std::string &name, int start, int stop,
@@ -720,14 +782,15 @@ void Genome::AddGene(const std::string &name, int start, int stop,
                                            rbs_stop, binding);
   rbs->gene(name);
   rbs->reading_frame(start % 3);
-  transcript_rbs_intervals_.emplace_back(rbs->start(), rbs->stop(), rbs);
-  bindings_["__" + name + "_rbs"] = binding;
+  auto &layout = MutableLayout();
+  layout.transcript_rbs_intervals.emplace_back(rbs->start(), rbs->stop(), rbs);
+  layout.bindings["__" + name + "_rbs"] = binding;
   auto stop_codon =
       std::make_shared<ReleaseSite>("stop_codon", stop - 1, stop, term);
   stop_codon->reading_frame(start % 3);
   stop_codon->gene(name);
-  transcript_stop_site_intervals_.emplace_back(stop_codon->start(),
-                                               stop_codon->stop(), stop_codon);
+  layout.transcript_stop_site_intervals.emplace_back(
+      stop_codon->start(), stop_codon->stop(), stop_codon);
 }
 
 void Genome::AddRnaseSite(int start, int stop) {
@@ -735,8 +798,8 @@ void Genome::AddRnaseSite(int start, int stop) {
       std::map<std::string, double>{{"__rnase", transcript_degradation_rate_}};
   auto rnase_site =
       std::make_shared<BindingSite>("__rnase_site", start, stop, binding);
-  transcript_rbs_intervals_.emplace_back(rnase_site->start(),
-                                         rnase_site->stop(), rnase_site);
+  MutableLayout().transcript_rbs_intervals.emplace_back(
+      rnase_site->start(), rnase_site->stop(), rnase_site);
 }
 
 //Overloading allows for user to specify a rnase rate constant unique to this site
@@ -757,16 +820,17 @@ void Genome::AddRnaseSite(const std::string &name, int start,
       std::map<std::string, double>{{"__rnase", transcript_degradation_rate}};
   auto rnase_site =
       std::make_shared<BindingSite>(name, start, stop, binding);
-  transcript_rbs_intervals_.emplace_back(rnase_site->start(),
-                                         rnase_site->stop(), rnase_site);
+  auto &layout = MutableLayout();
+  layout.transcript_rbs_intervals.emplace_back(rnase_site->start(),
+                                               rnase_site->stop(), rnase_site);
 
   //rnase sites need to have unique names
   //Otherwise propensity calculations will be incorrect                                      
-  if (rnase_bindings_.count(name) != 0) {
+  if (layout.rnase_bindings.count(name) != 0) {
     throw std::runtime_error(
         "Rnase site name '" + name + "' already in use.");
   } else {
-    rnase_bindings_[name] = transcript_degradation_rate;
+    layout.rnase_bindings[name] = transcript_degradation_rate;
   }
 }
 
@@ -776,7 +840,8 @@ void Genome::AddWeights(const std::vector<double> &transcript_weights) {
                             std::to_string(transcript_weights.size()) + " " +
                             std::to_string(stop_ - start_ + 1));
   }
-  transcript_weights_ = transcript_weights;
+  MutableLayout().transcript_weights =
+      std::make_shared<std::vector<double>>(transcript_weights);
 }
 
 void Genome::Attach(MobileElement::Ptr pol) {
@@ -788,7 +853,7 @@ void Genome::Attach(MobileElement::Ptr pol) {
 Transcript::Ptr Genome::BuildTranscript(int start, int stop) {
   std::vector<Interval<BindingSite::Ptr>> prom_results;
   std::vector<Interval<BindingSite::Ptr>> rbs_intervals;
-  transcript_rbs_.findContained(start, stop, prom_results);
+  layout_->transcript_rbs.findContained(start, stop, prom_results);
   for (auto &interval : prom_results) {
     int istart = interval.start;
     int istop = interval.stop;
@@ -809,7 +874,7 @@ Transcript::Ptr Genome::BuildTranscript(int start, int stop) {
 
   std::vector<Interval<ReleaseSite::Ptr>> term_results;
   std::vector<Interval<ReleaseSite::Ptr>> stop_site_intervals;
-  transcript_stop_sites_.findContained(start, stop, term_results);
+  layout_->transcript_stop_sites.findContained(start, stop, term_results);
   for (auto &interval : term_results) {
     int istart = interval.start;
     int istop = interval.stop;
@@ -824,6 +889,6 @@ Transcript::Ptr Genome::BuildTranscript(int start, int stop) {
   // signals appropriately.
   transcript = std::make_shared<Transcript>("__rna", start, stop_,
                                             rbs_intervals, stop_site_intervals,
-                                            mask, transcript_weights_);
+                                            mask, layout_->transcript_weights);
   return transcript;
 }
\ No newline at end of file
@@ -31,6 +31,12 @@ class MobileElementManager {
    * @param weights Base-pair specific movement weights.
    */
   MobileElementManager(const std::vector<double> &weights);
+  /**
+   * Construct with weights shared with other polymers.
+   *
+   * @param weights Base-pair specific movement weights.
+   */
+  MobileElementManager(std::shared_ptr<const std::vector<double>> weights);
   /**
    * Insert an MobileElement-Polymer pair while maintaining order of
    * MobileElements
@@ -86,6 +92,12 @@ class MobileElementManager {
   int pol_count() { return pol_count_; }
   int pair_count() const { return polymerases_.size(); }
   int pol_start(int index) const { return polymerases_[index].first->start(); }
+  const MobileElement &pol(int index) const {
+    return *polymerases_[index].first;
+  }
+  const std::shared_ptr<Polymer> &attached(int index) const {
+    return polymerases_[index].second;
+  }
 
  private:
   /**
@@ -111,7 +123,7 @@ class MobileElementManager {
   /**
    * Base-pair specific movement weights.
    */
-  std::vector<double> weights_;
+  std::shared_ptr<const std::vector<double>> weights_;
 };
 
 /**
@@ -151,11 +163,11 @@ class Polymer : public std::enable_shared_from_this<Polymer> {
    * polymer is no longer linked to a polymerase. Make sure there are no
    * polymerases on here.
    */
-  ~Polymer();
+  virtual ~Polymer();
   /**
    * De-register polymer from promoter-polymer map in SpeciesTracker.
    */
-  void Unlink();
+  virtual void Unlink();
   /**
    * Some convenience typedefs.
    */
@@ -178,7 +190,7 @@ class Polymer : public std::enable_shared_from_this<Polymer> {
   /**
    * Select a polymerase to move next and deal with terminations.
    */
-  void Execute();
+  virtual void Execute();
   /**
    * Move polymerase and deal with collisions and covering/uncovering of
    * elements.
@@ -205,7 +217,10 @@ class Polymer : public std::enable_shared_from_this<Polymer> {
    */
   void index(int index) { index_ = index; }
   int index() { return index_; }
-  double prop_sum() { return polymerases_.prop_sum(); }
+  void id(int id) { id_ = id; }
+  int id() const { return id_; }
+  const std::string &name() const { return name_; }
+  virtual double prop_sum() { return polymerases_.prop_sum(); }
   int uncovered(const std::string &name) { return uncovered_[name]; }
   int start() const { return start_; }
   int stop() const { return stop_; }
@@ -214,11 +229,22 @@ class Polymer : public std::enable_shared_from_this<Polymer> {
   void attached(bool attached) { attached_ = attached; }
   void wrapper(std::shared_ptr<PolymerWrapper> wrapper) { wrapper_ = wrapper; }
   std::shared_ptr<PolymerWrapper> wrapper() { return wrapper_.lock(); }
-  const std::vector<Interval<BindingSite::Ptr>>& GetBindingIntervals() { return binding_intervals_; }
-  const std::vector<Interval<ReleaseSite::Ptr>>& GetReleaseIntervals() { return release_intervals_; }
-  const Mask& GetMask() { return mask_; }
+  const std::vector<Interval<BindingSite::Ptr>>& GetBindingIntervals() const { return binding_intervals_; }
+  const std::vector<Interval<ReleaseSite::Ptr>>& GetReleaseIntervals() const { return release_intervals_; }
+  const Mask& GetMask() const { return mask_; }
+  const std::vector<double> &weights() const { return *weights_; }
   int num_attached() const { return polymerases_.pair_count(); }
   int attached_pol_start(int index) const { return polymerases_.pol_start(index); }
+  const MobileElement &attached_pol(int index) const {
+    return polymerases_.pol(index);
+  }
+  /**
+   * Polymer attached to the element at `index` (e.g. the nascent transcript
+   * of a polymerase on a genome), or null.
+   */
+  const Ptr &attached_polymer(int index) const {
+    return polymerases_.attached(index);
+  }
 
   /**
    * Signal to fire when a polymerase terminates.
@@ -230,6 +256,10 @@ class Polymer : public std::enable_shared_from_this<Polymer> {
  protected:
   std::weak_ptr<PolymerWrapper> wrapper_;
   int index_;
+  /**
+   * Unique id, assigned when this polymer is registered with a Model.
+   */
+  int id_ = 0;
   /**
    * Name of polymer
    */
@@ -292,9 +322,15 @@ class Polymer : public std::enable_shared_from_this<Polymer> {
    * Vector of the same length as this polymer, containing weights for different
    * positions along the polymer. When a polymerase passes over a given position
    * in the genome, the weight * speed of polymerase will determine the
-   * propensity for the next movement of that polymerase.
+   * propensity for the next movement of that polymerase. Shared between
+   * polymers with the same weights (e.g. transcripts of the same genome).
+   */
+  std::shared_ptr<const std::vector<double>> weights_;
+  /**
+   * Constructor for polymers that share their weights with other polymers.
    */
-  std::vector<double> weights_;
+  Polymer(const std::string &name, int start, int stop,
+          std::shared_ptr<const std::vector<double>> weights);
   /**
    * Finding which binding site (promoter) that the polymerase should bind to.
    *
@@ -393,7 +429,8 @@ class Transcript : public Polymer {
   Transcript(const std::string &name, int start, int stop,
              const std::vector<Interval<BindingSite::Ptr>> &rbs_intervals,
              const std::vector<Interval<ReleaseSite::Ptr>> &stop_site_intervals,
-             const Mask &mask, const std::vector<double> &weights);
+             const Mask &mask,
+             std::shared_ptr<const std::vector<double>> weights);
   /**
    * Constructor of transcript used for specifying transcripts without Genome
    *
@@ -406,7 +443,7 @@ class Transcript : public Polymer {
    */
   typedef std::shared_ptr<Transcript> Ptr;
   typedef std::vector<std::shared_ptr<Transcript>> VecPtr;
-  const std::map<std::string, std::map<std::string, double>> &bindings();
+  const std::map<std::string, std::map<std::string, double>> &bindings() const;
   /**
    * Bind ribosome to this transcript.
    *
@@ -434,7 +471,7 @@ class Transcript : public Polymer {
    */
   void AddWeights(const std::vector<double> &transcript_weights);
 
- private:
+ protected:
   std::map<std::string, std::map<std::string, double>> bindings_;
 };
 
@@ -460,7 +497,23 @@ class Genome : public Polymer {
   Genome(const std::string &name, int length,
          double transcript_degradation_rate_ext = 0.0, double rnase_speed = 0.0,
          double rnase_footprint = 0.0, double transcript_degradation_rate = 0.0);
+  /**
+   * Convenience typedefs
+   */
+  typedef std::shared_ptr<Genome> Ptr;
+  typedef std::vector<std::shared_ptr<Genome>> VecPtr;
   void Initialize();
+  /**
+   * Make a new copy of this genome, as if it had just been replicated: the
+   * whole genome is exposed and nothing is bound to it. The copy shares the
+   * transcript templates, weights and binding constants of this genome
+   * instead of copying them; only the promoters and terminators, which track
+   * whether they are covered, are duplicated. Register the copy with
+   * Model::RegisterGenome().
+   *
+   * @return new genome with the same name
+   */
+  Genome::Ptr Replicate() const;
   void AddMask(int start, const std::vector<std::string> &interactions);
   void AddPromoter(const std::string &name, int start, int stop,
                    const std::map<std::string, double> &interactions);
@@ -472,7 +525,9 @@ class Genome : public Polymer {
   void AddRnaseSite(const std::string &name, int start, int stop, double rnase_degradation_rate);
   void AddWeights(const std::vector<double> &transcript_weights);
   const std::map<std::string, std::map<std::string, double>> &bindings();
-  const std::map<std::string, double> &rnase_bindings() { return rnase_bindings_; }
+  const std::map<std::string, double> &rnase_bindings() {
+    return layout_->rnase_bindings;
+  }
   const double &transcript_degradation_rate() {
     return transcript_degradation_rate_;
   }
@@ -481,11 +536,16 @@ class Genome : public Polymer {
   }
   const double &rnase_speed() { return rnase_speed_; }
   int rnase_footprint() { return rnase_footprint_; }
-  /**
-   * Convenience typedefs
-   */
-  typedef std::shared_ptr<Genome> Ptr;
-  typedef std::vector<std::shared_ptr<Genome>> VecPtr;
+  const std::vector<Interval<BindingSite::Ptr>> &GetTranscriptRbsIntervals() {
+    return layout_->transcript_rbs_intervals;
+  }
+  const std::vector<Interval<ReleaseSite::Ptr>> &
+  GetTranscriptStopSiteIntervals() {
+    return layout_->transcript_stop_site_intervals;
+  }
+  const std::vector<double> &transcript_weights() const {
+    return *layout_->transcript_weights;
+  }
   /**
    * Bind a polymerase to genome and construct new transcript.
    *
@@ -496,13 +556,37 @@ class Genome : public Polymer {
   Signal<Transcript::Ptr> transcript_signal_;
 
  private:
-  std::vector<Interval<BindingSite::Ptr>> transcript_rbs_intervals_;
-  std::vector<Interval<ReleaseSite::Ptr>> transcript_stop_site_intervals_;
-  IntervalTree<BindingSite::Ptr> transcript_rbs_;
-  IntervalTree<ReleaseSite::Ptr> transcript_stop_sites_;
-  std::vector<double> transcript_weights_;
-  std::map<std::string, std::map<std::string, double>> bindings_;
-  std::map<std::string, double> rnase_bindings_;
+  /**
+   * Structure of a genome that does not change during a simulation, shared
+   * by the genome and its replicas. A genome that shares it copies it before
+   * modifying it.
+   */
+  struct Layout {
+    std::vector<Interval<BindingSite::Ptr>> transcript_rbs_intervals;
+    std::vector<Interval<ReleaseSite::Ptr>> transcript_stop_site_intervals;
+    IntervalTree<BindingSite::Ptr> transcript_rbs;
+    IntervalTree<ReleaseSite::Ptr> transcript_stop_sites;
+    std::shared_ptr<const std::vector<double>> transcript_weights;
+    std::map<std::string, std::map<std::string, double>> bindings;
+    std::map<std::string, double> rnase_bindings;
+    /**
+     * Promoters and terminators as they were before the genome was
+     * initialized, from which replicas copy theirs.
+     */
+    std::vector<Interval<BindingSite::Ptr>> promoters;
+    std::vector<Interval<ReleaseSite::Ptr>> terminators;
+    bool initialized = false;
+  };
+  std::shared_ptr<Layout> layout_;
+  /**
+   * Layout of this genome, copied first if it is shared.
+   */
+  Layout &MutableLayout();
+  /**
+   * Constructor used by Replicate().
+   */
+  struct ReplicaTag {};
+  Genome(const Genome &parent, ReplicaTag);
   double transcript_degradation_rate_ = 0.0;
   double transcript_degradation_rate_ext_ = 0.0;
   double rnase_speed_ = 0.0;
@@ -0,0 +1,83 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_POLYMER_STATE_HPP  // header guard
+#define SRC_POLYMER_STATE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Plain records of the state of every polymer, exported in bulk by
+ * Model::ExportState(). Records only hold numbers so that they map directly
+ * onto structured numpy arrays; names are indices into
+ * PolymerStateExport::names.
+ */
+
+/**
+ * A genome or transcript, with the region still hidden by its mask.
+ */
+struct PolymerRecord {
+  enum Kind : int8_t { kGenome = 0, kTranscript = 1, kOther = 2 };
+  int32_t id;
+  int8_t kind;
+  int32_t name;
+  int32_t start;
+  int32_t stop;
+  /**
+   * Covered region of the mask (mask_start > mask_stop once the mask has
+   * been shifted off the polymer).
+   */
+  int32_t mask_start;
+  int32_t mask_stop;
+};
+
+/**
+ * A polymerase, ribosome or RNase bound to a polymer.
+ */
+struct MobileElementRecord {
+  enum Kind : int8_t { kPolymerase = 0, kRibosome = 1, kRnase = 2 };
+  int32_t id;
+  int32_t polymer_id;
+  int8_t kind;
+  int32_t name;
+  int32_t start;
+  int32_t stop;
+  int8_t reading_frame;
+};
+
+/**
+ * A binding site (promoter, RBS) or release site (terminator, stop codon).
+ */
+struct SiteRecord {
+  enum Kind : int8_t { kBinding = 0, kRelease = 1 };
+  int32_t polymer_id;
+  int8_t kind;
+  int32_t name;
+  int32_t start;
+  int32_t stop;
+  /**
+   * Number of mobile elements or masks covering the site.
+   */
+  int32_t covered;
+  /**
+   * Index into PolymerStateExport::names of the gene the site belongs to.
+   */
+  int32_t gene;
+};
+
+/**
+ * Everything bound to every polymer at one point in simulated time.
+ */
+struct PolymerStateExport {
+  double time = 0;
+  /**
+   * Names referred to by the records, each listed once.
+   */
+  std::vector<std::string> names;
+  std::vector<PolymerRecord> polymers;
+  std::vector<MobileElementRecord> mobile_elements;
+  std::vector<SiteRecord> sites;
+};
+
+#endif  // SRC_POLYMER_STATE_HPP
@@ -1,7 +1,10 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include "choices.hpp"
 #include "feature.hpp"
+#include "genbank.hpp"
+#include "generator.hpp"
 #include "model.hpp"
 #include "polymer.hpp"
 #include "reaction.hpp"
@@ -10,6 +13,31 @@
 namespace py = pybind11;
 using namespace pybind11::literals;
 
+namespace {
+
+// numpy is only imported (and the record dtypes registered) on first use,
+// so that it stays optional
+void RegisterRecordDtypes() {
+  static bool registered = []() {
+    PYBIND11_NUMPY_DTYPE(PolymerRecord, id, kind, name, start, stop,
+                         mask_start, mask_stop);
+    PYBIND11_NUMPY_DTYPE(MobileElementRecord, id, polymer_id, kind, name,
+                         start, stop, reading_frame);
+    PYBIND11_NUMPY_DTYPE(SiteRecord, polymer_id, kind, name, start, stop,
+                         covered, gene);
+    return true;
+  }();
+  (void)registered;
+}
+
+// Copy records into a structured numpy array
+template <typename T>
+py::array_t<T> ToArray(const std::vector<T> &records) {
+  return py::array_t<T>(records.size(), records.data());
+}
+
+}  // namespace
+
 PYBIND11_MODULE(core, m) {
   m.doc() = (R"doc(
     Python module
@@ -216,6 +244,44 @@ PYBIND11_MODULE(core, m) {
 
                 >>> coming soon
              
+           )doc")
+      .def("add_rate_law_reaction",
+           [](Model &model, const std::string &rate_law,
+              const std::vector<std::string> &reactants,
+              const std::vector<std::string> &products,
+              const std::map<std::string, double> &parameters) {
+             model.AddRateLawReaction(rate_law, parameters, reactants,
+                                      products);
+           },
+           "rate_law"_a, "reactants"_a, "products"_a,
+           "parameters"_a = std::map<std::string, double>(), R"doc(
+
+            Define a reaction between species whose propensity is given by 
+            an expression, e.g. a Hill function, instead of mass action.
+
+            Args:
+                rate_law (str): Propensity of the reaction, in reactions per 
+                    second, as an expression over species copy numbers and 
+                    parameters. Supports numbers, ``+ - * / ^``, parentheses 
+                    and the functions ``exp``, ``log``, ``sqrt``, ``abs``, 
+                    ``pow``, ``min`` and ``max``. Names that are not 
+                    parameters are species.
+                reactants (list): List of reactants, consumed when the 
+                    reaction fires. The reaction cannot fire while a reactant 
+                    is depleted.
+                products (list): List of products
+                parameters (dict): Values of named constants in the rate law
+
+            Note:
+                Unlike ``add_reaction()``, the rate law is not converted from 
+                a macroscopic rate; it is the stochastic propensity itself.
+
+            Example:
+
+                >>> model.add_rate_law_reaction(
+                ...     "vmax / (1 + (repressor / K)^n)", [], ["protein"],
+                ...     {"vmax": 10, "K": 50, "n": 2})
+
            )doc")
       .def("add_species", &Model::AddSpecies, "name"_a, "copy_number"_a,
            R"doc(
@@ -286,7 +352,7 @@ PYBIND11_MODULE(core, m) {
         )doc")
       .def("simulate", &Model::Simulate, "time_limit"_a, "time_step"_a,
            "output"_a = "counts.tsv",
-           R"doc(
+           py::call_guard<py::gil_scoped_release>(), R"doc(
             
             Run a gene expression simulation. Produces a tab separated file of 
             protein and transcript counts at user-specified time intervals.
@@ -302,8 +368,467 @@ PYBIND11_MODULE(core, m) {
                     are reported.
                 output (str): Name of output file (default: counts.tsv).
 
+            Other Python threads keep running while the simulation runs, 
+            but must not use the model except to call ``snapshot()``.
+
+          )doc")
+      .def("simulate_ensemble", &Model::SimulateEnsemble, "seeds"_a,
+           "time_limit"_a, "time_step"_a, "output"_a = "ensemble.tsv",
+           "workers"_a = 1, py::call_guard<py::gil_scoped_release>(), R"doc(
+
+            Run one replicate per seed on a pool of worker processes. The 
+            model is initialized once and each worker is forked from it, so 
+            replicates do not rebuild the model. Workers stream their counts 
+            back through shared memory into one tab separated file with the 
+            columns of ``simulate()`` after a leading ``seed`` column; rows of 
+            different replicates are interleaved. A replicate that fails or 
+            crashes does not stop the others. Python observers are not 
+            supported. Not available on Windows.
+
+            Args:
+                seeds (list): one seed per replicate.
+                time_limit (int): Simulated time at which each replicate 
+                    stops.
+                time_step (int): Time interval, in seconds, that species 
+                    counts are reported.
+                output (str): Name of output file (default: ensemble.tsv).
+                workers (int): Number of replicates that run at the same time.
+
+            Returns:
+                EnsembleReport: seeds of replicates that completed 
+                (``completed``), and seeds of replicates that failed 
+                (``failed``) with the reason for each (``errors``).
+
+          )doc")
+      .def("step",
+           [](Model &model, int n_events) {
+             model.TrackChanges();
+             {
+               py::gil_scoped_release release;
+               model.Step(n_events);
+             }
+             return model.CollectChanges();
+           },
+           "n_events"_a = 1, R"doc(
+
+            Execute a fixed number of reactions and report what changed.
+
+            Args:
+                n_events (int): Number of reactions to execute (default: 1).
+
+            Returns:
+                Delta: Changes since the previous call to ``step()`` or
+                ``step_until()``. The first delta contains all species counts.
+
+          )doc")
+      .def("step_until",
+           [](Model &model, double time) {
+             model.TrackChanges();
+             {
+               py::gil_scoped_release release;
+               model.StepUntil(time);
+             }
+             return model.CollectChanges();
+           },
+           "time"_a, R"doc(
+
+            Execute reactions until the given simulated time and report what
+            changed.
+
+            Args:
+                time (float): Simulated time, in seconds, at which to stop.
+
+            Returns:
+                Delta: Changes since the previous call to ``step()`` or
+                ``step_until()``.
+
+          )doc")
+      .def_property_readonly("time", &Model::time,
+                             "Current simulated time, in seconds.")
+      .def("stats", &Model::stats, R"doc(
+
+            Counters for the simulation so far.
+
+            Returns:
+                SimulationStats: number of reactions executed (``events``),
+                number of transcripts currently tracked (``transcripts``), 
+                the largest number tracked at once (``peak_transcripts``) and 
+                whether the last ``simulate()`` was answered from the cache 
+                (``cached``), and the number of propensity calculations 
+                (``propensity_evaluations``).
+
+          )doc")
+      .def("export_state",
+           [](Model &model) {
+             RegisterRecordDtypes();
+             auto state = model.ExportState();
+             py::dict out;
+             out["time"] = state.time;
+             out["names"] = state.names;
+             out["polymers"] = ToArray(state.polymers);
+             out["mobile_elements"] = ToArray(state.mobile_elements);
+             out["sites"] = ToArray(state.sites);
+             return out;
+           },
+           R"doc(
+
+            Export everything bound to every genome and transcript in one 
+            call, as structured numpy arrays (requires numpy). Names are 
+            stored as indices into ``names``.
+
+            Returns:
+                dict: ``time`` (float), ``names`` (list of str), and the 
+                arrays ``polymers`` (fields ``id``, ``kind``: 0 genome, 
+                1 transcript; ``name``, ``start``, ``stop``, and the region 
+                still covered by the mask, ``mask_start`` and 
+                ``mask_stop``), ``mobile_elements`` (``id``, ``polymer_id``, 
+                ``kind``: 0 polymerase, 1 ribosome, 2 RNase; ``name``, 
+                ``start``, ``stop``, ``reading_frame``) and ``sites`` 
+                (``polymer_id``, ``kind``: 0 promoter or ribosome binding 
+                site, 1 terminator or stop codon; ``name``, ``start``, 
+                ``stop``, ``gene``, and the number of elements covering the 
+                site, ``covered``).
+
+          )doc")
+      .def("enable_snapshots", &Model::EnableSnapshots, "interval"_a, R"doc(
+
+            Publish snapshots of species counts and progress while the 
+            simulation runs, for a monitoring thread (e.g. a dashboard) to 
+            read with ``snapshot()``. Snapshots are published when 
+            ``simulate()``, ``step()`` or ``step_until()`` starts and 
+            returns, and whenever ``interval`` seconds of simulated time 
+            have passed since the last one. Publishing never blocks or slows 
+            down the simulation thread beyond copying the counts.
+
+            Args:
+                interval (float): Simulated time between snapshots, or 0 to 
+                    publish after every reaction.
+
+          )doc")
+      .def("snapshot", &Model::snapshot, R"doc(
+
+            The last published snapshot. May be called from any thread while 
+            ``simulate()``, ``step()`` or ``step_until()`` runs in another; 
+            the counts in a snapshot are always from the same point in time.
+
+            Returns:
+                Snapshot: Simulated ``time``, number of reactions executed 
+                (``events``), number of snapshots published so far 
+                (``version``, 0 if none has been) and the counts of all 
+                ``species``.
+
+          )doc")
+      .def("hash", &Model::Hash, "time_limit"_a, "time_step"_a, R"doc(
+
+            Hash of everything that determines the output of ``simulate()``: 
+            the model definition, the seed, the simulation parameters and 
+            the pinetree version. Models defined the same way hash the same 
+            way, whether they were built in Python or from a model file.
+
+            Args:
+                time_limit (int): Simulation time limit.
+                time_step (int): Output time step.
+
+            Returns:
+                str: 16 hexadecimal digits.
+
+          )doc")
+      .def("enable_cache", &Model::EnableCache, "directory"_a, R"doc(
+
+            Cache simulation output in an existing directory. ``simulate()`` 
+            then copies the output of an earlier run with the same ``hash()`` 
+            instead of simulating, and stores the output of new runs. Only 
+            seeded models simulated from the start without observers are 
+            cached, and after a cached run the model itself has not advanced.
+
+            Args:
+                directory (str): Cache directory.
+
+          )doc")
+      .def("enable_pruning", &Model::EnablePruning, R"doc(
+
+            Remove reactions that can never fire and species whose counts 
+            can never change when the simulation starts, e.g. binding of a 
+            polymerase that is absent and never produced, or translation of 
+            genes that no available polymerase can transcribe. Results are 
+            unchanged, except that pruned species are not reported. Must be 
+            called before the simulation starts.
+
+          )doc")
+      .def("pruned", &Model::pruned, R"doc(
+
+            Reactions and species removed by ``enable_pruning()``.
+
+            Returns:
+                PruneReport: descriptions of removed reactions 
+                (``reactions``) and names of removed species (``species``).
+
+          )doc")
+      .def("enable_slow_scale", &Model::EnableSlowScale, "ratio"_a = 100,
+           R"doc(
+
+            Simulate fast reversible pairs of species reactions, such as 
+            repressor binding and unbinding, with the slow-scale SSA. Each 
+            pair is held in quasi-equilibrium instead of simulating every 
+            binding and unbinding event: other reactions use the expected 
+            copy numbers of its species, which are drawn from the 
+            equilibrium distribution whenever another reaction changes them. 
+            A pair is fast if, when the simulation starts, it fires at least 
+            ``ratio`` times as often as all other reactions involving its 
+            species. Polymerases, binding sites, proteins and species used in 
+            rate laws are not eligible. Must be called before the simulation 
+            starts.
+
+            Args:
+                ratio (float): How much faster a pair must be than the 
+                    reactions around it.
+
+          )doc")
+      .def("fast_equilibria", &Model::fast_equilibria, R"doc(
+
+            Reversible pairs held in quasi-equilibrium by 
+            ``enable_slow_scale()``, e.g. ``"R + O <-> RO"``.
+
+          )doc")
+      .def("enable_rejection_sampling", &Model::EnableRejectionSampling,
+           "fluctuation"_a = 0.1, R"doc(
+
+            Select reactions with the rejection-based SSA. Species reactions 
+            keep lower and upper bounds on their propensity that hold while 
+            each reactant count stays within a fluctuation interval around 
+            its count. Candidates are drawn from the upper bounds and 
+            accepted against the lower bound, so an exact propensity is only 
+            calculated when that is not enough to decide, and bounds are only 
+            recalculated when a count leaves its interval. Results are exact. 
+            Faster for models dominated by species reactions with large 
+            counts. Must be called before the simulation starts.
+
+            Args:
+                fluctuation (float): Width of the fluctuation interval, as a 
+                    fraction of each count.
+
+          )doc")
+      .def("enable_parallel", &Model::EnableParallel, "threads"_a,
+           "window"_a = 0.1, R"doc(
+
+            Simulate polymers on several threads. Time advances in windows: 
+            in each window, polymerases, ribosomes and RNases first move on 
+            every polymer for the whole window, with polymers split across 
+            threads, and then binding, species reactions and scheduled events 
+            are simulated for the same window. Polymers see species counts up 
+            to one window old, so results approach exact dynamics as the 
+            window shrinks. Results are reproducible for a given seed and 
+            number of threads. Must be called before the simulation starts.
+
+            Args:
+                threads (int): Number of threads, including the calling 
+                    thread.
+                window (float): Simulated time per window (seconds).
+
+          )doc")
+      .def("enable_translation_engine", &Model::EnableTranslationEngine,
+           R"doc(
+
+            Simulate a translation-only model, with transcripts registered by 
+            register_transcript() and no genomes, with a specialized engine. 
+            Ribosomes are kept in flat arrays, and binding sites and stop 
+            codons are found by position. Results are statistically 
+            equivalent, though not identical for a seed. Registered 
+            Transcript objects no longer change once the simulation starts. 
+            Must be called before the simulation starts.
+
+          )doc")
+      .def("enable_time_averages", &Model::EnableTimeAverages,
+           "extremes"_a = false, R"doc(
+
+            Write the time-weighted average of each count over each output 
+            interval of ``simulate()`` instead of its value at the output 
+            time, so that counts that fluctuate faster than the time step are 
+            not aliased. The first row is the initial state. Must be called 
+            before the simulation starts.
+
+            Args:
+                extremes (bool): also write the minimum and maximum of each 
+                    count in the interval (columns ``protein_min``, 
+                    ``protein_max``, ``transcript_min``, ``transcript_max``, 
+                    ``ribo_density_min`` and ``ribo_density_max``).
+
+          )doc")
+      .def("enable_mean_field_translation",
+           &Model::EnableMeanFieldTranslation, "gene"_a, R"doc(
+
+            Translate a gene with a mean-field approximation instead of 
+            simulating each ribosome on it. Every exposed ribosome binding 
+            site of the gene produces protein at the steady-state rate of 
+            ribosomes moving along the gene, given its ribosome binding 
+            strength and position-specific weights. Much faster for heavily 
+            translated genes, but ribosomes are not held on the gene and the 
+            time they take to reach the stop codon is ignored, so it is only 
+            accurate when free ribosomes are abundant. The gene is not 
+            included in ribosome densities. Must be called before the 
+            simulation starts.
+
+            Args:
+                gene (str): Name of gene.
+
+          )doc")
+      .def("add_genome_replication", &Model::AddGenomeReplication,
+           "genome"_a, "rate_constant"_a, "max_copies"_a = 0, R"doc(
+
+            Replicate a registered genome during the simulation. Every copy 
+            of the genome replicates at ``rate_constant``. New copies have 
+            fully entered the cell, start with nothing bound, and share 
+            their elements, weights and binding constants with the original 
+            genome, so even hundreds of copies are cheap. Must be called 
+            before the simulation starts.
+
+            Args:
+                genome (str): Name of genome.
+                rate_constant (float): Replications per second of each copy.
+                max_copies (int): Stop replicating at this many copies 
+                    (0 for no limit).
+
+          )doc")
+      .def("genome_copies", &Model::genome_copies, "genome"_a, R"doc(
+
+            Number of copies of a genome currently in the simulation.
+
+            Args:
+                genome (str): Name of genome.
+
+          )doc")
+      .def("schedule_species_change", &Model::ScheduleSpeciesChange,
+           "time"_a, "name"_a, "change"_a, R"doc(
+
+            Change the copy number of a species at a fixed simulated time. 
+            The change is applied exactly at that time, without stopping the 
+            simulation.
+
+            Args:
+                time (float): Simulated time of the change.
+                name (str): Name of species.
+                change (int): Number of copies to add (negative to remove 
+                    copies).
+
+          )doc")
+      .def("schedule_rate_change", &Model::ScheduleRateChange, "time"_a,
+           "reactants"_a, "products"_a, "rate_constant"_a, R"doc(
+
+            Change the rate constant of species reactions at a fixed 
+            simulated time. Applies to every reaction added with 
+            ``add_reaction()`` with exactly these reactants and products.
+
+            Args:
+                time (float): Simulated time of the change.
+                reactants (list): List of reactant names.
+                products (list): List of product names.
+                rate_constant (float): New macroscopic rate constant (0 
+                    switches the reactions off).
+
+          )doc")
+      .def("schedule_genome", &Model::ScheduleGenome, "time"_a, "genome"_a,
+           R"doc(
+
+            Add a genome to the simulation at a fixed simulated time, e.g. 
+            to simulate infection. Use instead of ``register_genome()``; the 
+            genome must be complete when it is scheduled. A genome with the 
+            same name as a registered genome shares its binding reactions. 
+            Must be called before the simulation starts.
+
+            Args:
+                time (float): Simulated time at which the genome enters.
+                genome (Genome): Genome object.
+
+          )doc")
+      .def("load_observer", &Model::LoadObserver, "path"_a, "args"_a = "",
+           R"doc(
+
+            Load a native observer from a shared library. Its hooks are 
+            called from inside the simulation loop on every reaction, 
+            binding, termination, transcript creation and degradation, and 
+            output sample, so custom metrics can be measured without 
+            writing or parsing per-event output. The library must export 
+            ``pinetree_create_observer`` (see ``observer.hpp`` and 
+            ``examples/observer_example.cpp``).
+
+            Args:
+                path (str): Path to shared library.
+                args (str): Argument passed to the library's factory 
+                    function.
+
           )doc");
 
+  py::class_<PruneReport>(m, "PruneReport")
+      .def_readonly("reactions", &PruneReport::reactions)
+      .def_readonly("species", &PruneReport::species);
+
+  py::class_<EnsembleReport>(m, "EnsembleReport")
+      .def_readonly("completed", &EnsembleReport::completed)
+      .def_readonly("failed", &EnsembleReport::failed)
+      .def_readonly("errors", &EnsembleReport::errors);
+
+  py::class_<SimulationStats>(m, "SimulationStats")
+      .def_readonly("events", &SimulationStats::events)
+      .def_readonly("transcripts", &SimulationStats::transcripts)
+      .def_readonly("peak_transcripts", &SimulationStats::peak_transcripts)
+      .def_readonly("cached", &SimulationStats::cached)
+      .def_readonly("propensity_evaluations",
+                    &SimulationStats::propensity_evaluations);
+
+  py::class_<Snapshot>(m, "Snapshot", R"doc(
+            Species counts and progress of a running simulation, published 
+            by ``Model.enable_snapshots()``.
+
+            Attributes:
+                time (float): Simulated time of the snapshot.
+                events (int): Number of reactions executed.
+                version (int): Number of snapshots published so far.
+                species (dict): Counts of all species.
+            )doc")
+      .def_readonly("time", &Snapshot::time)
+      .def_readonly("events", &Snapshot::events)
+      .def_readonly("version", &Snapshot::version)
+      .def_readonly("species", &Snapshot::species);
+
+  py::class_<PolymeraseState>(m, "PolymeraseState", R"doc(
+            Final position of a polymerase, ribosome or RNase in a Delta.
+            ``polymer_id`` refers to the genome or transcript it is bound to.
+            If ``released`` is true, it has left the polymer.
+            )doc")
+      .def_readonly("id", &PolymeraseState::id)
+      .def_readonly("polymer_id", &PolymeraseState::polymer_id)
+      .def_readonly("name", &PolymeraseState::name)
+      .def_readonly("start", &PolymeraseState::start)
+      .def_readonly("stop", &PolymeraseState::stop)
+      .def_readonly("released", &PolymeraseState::released);
+
+  py::class_<TranscriptState>(m, "TranscriptState", R"doc(
+            A newly-created transcript, in genomic coordinates.
+            )doc")
+      .def_readonly("id", &TranscriptState::id)
+      .def_readonly("name", &TranscriptState::name)
+      .def_readonly("start", &TranscriptState::start)
+      .def_readonly("stop", &TranscriptState::stop);
+
+  py::class_<ChangeDelta>(m, "Delta", R"doc(
+            Changes produced by ``Model.step()`` and ``Model.step_until()``.
+
+            Attributes:
+                time (float): Simulated time at the end of the step.
+                species (dict): New counts of species whose count changed.
+                polymerases (list): ``PolymeraseState`` of each polymerase
+                    that bound, moved or was released.
+                transcripts_created (list): ``TranscriptState`` of each new
+                    transcript.
+                transcripts_destroyed (list): Ids of degraded transcripts.
+            )doc")
+      .def_readonly("time", &ChangeDelta::time)
+      .def_readonly("species", &ChangeDelta::species)
+      .def_readonly("polymerases", &ChangeDelta::polymerases)
+      .def_readonly("transcripts_created", &ChangeDelta::transcripts_created)
+      .def_readonly("transcripts_destroyed",
+                    &ChangeDelta::transcripts_destroyed);
+
   // Polymers, genomes, and transcripts
   py::class_<Polymer, Polymer::Ptr>(m, "Polymer");
   py::class_<Genome, Polymer, Genome::Ptr>(m, "Genome")
@@ -472,4 +997,164 @@ PYBIND11_MODULE(core, m) {
                 weights (list): List of weights of same length as Transcript. These weights are multiplied by the ribosome speed to calculate a final translation rate at every position in the genome.
 
             )doc");
-}
\ No newline at end of file
+
+  py::class_<GenbankRules>(m, "GenbankRules",
+                           R"doc(
+            
+            Rules that control how ``read_genbank()`` converts GenBank 
+            features into promoters, terminators and genes. Features are 
+            identified by the value of their ``label_qualifier`` qualifier.
+
+            Attributes:
+                label_qualifier (str): Qualifier used to name features 
+                    (default: "note").
+                gene_feature (str): Feature type that defines genes 
+                    (default: "gene").
+                ignore (set): Labels of features to skip.
+                rename (dict): Map of original labels to names used in the 
+                    Genome.
+                classes (dict): Map of labels to parameter classes, e.g. 
+                    promoter strength classes.
+                promoter_interactions (dict): Map of class (or label) to a 
+                    dictionary of polymerase binding constants.
+                terminator_interactions (dict): Map of class (or label) to a 
+                    dictionary of termination efficiencies.
+                default_terminator_interactions (dict): Efficiencies for 
+                    terminators not listed in ``terminator_interactions``.
+                min_promoter_length (int): Promoters shorter than this 
+                    start this many positions further upstream (default: 35).
+                rbs_length (int): Length of ribosome binding site upstream of 
+                    each gene (default: 30).
+                rbs_strength (float): Ribosome binding constant (default: 1e7).
+                optimal_codons (dict): Map of one-letter amino acid codes to 
+                    lists of preferred codons. If given, translation weights 
+                    are computed from CDS features.
+                optimal_codon_weight (float): Weight of preferred codons 
+                    relative to other codons (default: 1.0).
+
+            )doc")
+      .def(py::init<>())
+      .def_readwrite("label_qualifier", &GenbankRules::label_qualifier)
+      .def_readwrite("gene_feature", &GenbankRules::gene_feature)
+      .def_readwrite("ignore", &GenbankRules::ignore)
+      .def_readwrite("rename", &GenbankRules::rename)
+      .def_readwrite("classes", &GenbankRules::classes)
+      .def_readwrite("promoter_interactions",
+                     &GenbankRules::promoter_interactions)
+      .def_readwrite("terminator_interactions",
+                     &GenbankRules::terminator_interactions)
+      .def_readwrite("default_terminator_interactions",
+                     &GenbankRules::default_terminator_interactions)
+      .def_readwrite("min_promoter_length", &GenbankRules::min_promoter_length)
+      .def_readwrite("rbs_length", &GenbankRules::rbs_length)
+      .def_readwrite("rbs_strength", &GenbankRules::rbs_strength)
+      .def_readwrite("optimal_codons", &GenbankRules::optimal_codons)
+      .def_readwrite("optimal_codon_weight",
+                     &GenbankRules::optimal_codon_weight);
+
+  m.def("read_genbank", &ReadGenbank, "path"_a, "rules"_a, "name"_a = "",
+        R"doc(
+            
+            Construct a ``Genome`` directly from the features of a GenBank 
+            file. Promoters and terminators are read from ``regulatory`` 
+            features, genes from ``gene`` features and translation weights 
+            from ``CDS`` features. Features on the reverse strand are skipped.
+
+            Args:
+                path (str): Path to GenBank file.
+                rules (GenbankRules): Filters, renames and parameter maps.
+                name (str): Name of genome (default: LOCUS name).
+
+            Returns:
+                Genome: a genome ready to be registered with a ``Model``.
+
+          )doc");
+
+  py::class_<GeneratorConfig>(m, "GeneratorConfig",
+                              R"doc(
+            
+            Parameters of a synthetic model built by ``generate_model()``. 
+            Each genome is divided into ``num_genes`` equal segments, each 
+            holding room for a promoter and an RNase site, a ribosome binding 
+            site and a gene. The first segment always has a promoter, the 
+            other promoters and the RNase sites are placed in randomly chosen 
+            segments, and every operon ends with a terminator.
+
+            Attributes:
+                seed (int): Seed for the layout and for the simulation 
+                    (default: 1).
+                cell_volume (float): Cell volume (default: 8e-16).
+                num_genomes (int): Number of genomes (default: 1).
+                genome_length (int): Length of each genome (default: 10000).
+                num_genes (int): Genes per genome (default: 10).
+                num_promoters (int): Promoters per genome (default: 3).
+                promoter_strength (float): Median promoter binding constant 
+                    (default: 2e8).
+                promoter_strength_sigma (float): Standard deviation of the 
+                    log of promoter binding constants (default: 0.0).
+                terminator_efficiency (float): Efficiency of terminators 
+                    between operons (default: 0.8).
+                polymerase_name (str): Name of polymerase (default: "rnapol").
+                polymerase_copies (int): Polymerase copy number (default: 10).
+                polymerase_speed (float): Polymerase speed (default: 40).
+                polymerase_footprint (int): Polymerase footprint (default: 10).
+                ribosome_copies (int): Ribosome copy number (default: 100).
+                ribosome_speed (float): Ribosome speed (default: 30).
+                ribosome_footprint (int): Ribosome footprint (default: 10).
+                rbs_strength (float): Ribosome binding constant (default: 1e7).
+                num_rnase_sites (int): RNase sites per genome (default: 0).
+                rnase_rate (float): RNase binding constant of each site 
+                    (default: 1e-2).
+                rnase_speed (float): RNase speed (default: 20).
+                rnase_footprint (int): RNase footprint (default: 10).
+                num_transcripts (int): Transcripts registered independently of 
+                    any genome (default: 0).
+                transcript_length (int): Length of each transcript 
+                    (default: 1000).
+                transcript_genes (int): Genes per transcript (default: 3).
+
+            )doc")
+      .def(py::init<>())
+      .def_readwrite("seed", &GeneratorConfig::seed)
+      .def_readwrite("cell_volume", &GeneratorConfig::cell_volume)
+      .def_readwrite("num_genomes", &GeneratorConfig::num_genomes)
+      .def_readwrite("genome_length", &GeneratorConfig::genome_length)
+      .def_readwrite("num_genes", &GeneratorConfig::num_genes)
+      .def_readwrite("num_promoters", &GeneratorConfig::num_promoters)
+      .def_readwrite("promoter_strength", &GeneratorConfig::promoter_strength)
+      .def_readwrite("promoter_strength_sigma",
+                     &GeneratorConfig::promoter_strength_sigma)
+      .def_readwrite("terminator_efficiency",
+                     &GeneratorConfig::terminator_efficiency)
+      .def_readwrite("polymerase_name", &GeneratorConfig::polymerase_name)
+      .def_readwrite("polymerase_copies", &GeneratorConfig::polymerase_copies)
+      .def_readwrite("polymerase_speed", &GeneratorConfig::polymerase_speed)
+      .def_readwrite("polymerase_footprint",
+                     &GeneratorConfig::polymerase_footprint)
+      .def_readwrite("ribosome_copies", &GeneratorConfig::ribosome_copies)
+      .def_readwrite("ribosome_speed", &GeneratorConfig::ribosome_speed)
+      .def_readwrite("ribosome_footprint",
+                     &GeneratorConfig::ribosome_footprint)
+      .def_readwrite("rbs_strength", &GeneratorConfig::rbs_strength)
+      .def_readwrite("num_rnase_sites", &GeneratorConfig::num_rnase_sites)
+      .def_readwrite("rnase_rate", &GeneratorConfig::rnase_rate)
+      .def_readwrite("rnase_speed", &GeneratorConfig::rnase_speed)
+      .def_readwrite("rnase_footprint", &GeneratorConfig::rnase_footprint)
+      .def_readwrite("num_transcripts", &GeneratorConfig::num_transcripts)
+      .def_readwrite("transcript_length", &GeneratorConfig::transcript_length)
+      .def_readwrite("transcript_genes", &GeneratorConfig::transcript_genes);
+
+  m.def("generate_model", &GenerateModel, "config"_a,
+        R"doc(
+            
+            Build a synthetic model for scaling studies. The layout is 
+            random but reproducible for a given ``config.seed``.
+
+            Args:
+                config (GeneratorConfig): Model size and parameters.
+
+            Returns:
+                Model: a seeded model, ready to simulate.
+
+          )doc");
+}
@@ -0,0 +1,280 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "rate_law.hpp"
+
+struct RateLaw::Parser {
+  Parser(RateLaw &law, const std::map<std::string, double> &parameters)
+      : law(law), parameters(parameters), text(law.expression_) {}
+
+  RateLaw &law;
+  const std::map<std::string, double> &parameters;
+  const std::string &text;
+  size_t pos = 0;
+
+  void Fail(const std::string &message) const {
+    throw std::invalid_argument("Rate law '" + text + "': " + message +
+                                " at position " + std::to_string(pos + 1) +
+                                ".");
+  }
+
+  void SkipSpace() {
+    while (pos < text.size() && std::isspace((unsigned char)text[pos])) {
+      pos++;
+    }
+  }
+
+  bool Accept(char c) {
+    SkipSpace();
+    if (pos < text.size() && text[pos] == c) {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+
+  void Expect(char c) {
+    if (!Accept(c)) {
+      Fail(std::string("expected '") + c + "'");
+    }
+  }
+
+  // expression := term (('+' | '-') term)*
+  void Expression() {
+    Term();
+    while (true) {
+      if (Accept('+')) {
+        Term();
+        law.Emit(kAdd);
+      } else if (Accept('-')) {
+        Term();
+        law.Emit(kSubtract);
+      } else {
+        return;
+      }
+    }
+  }
+
+  // term := unary (('*' | '/') unary)*
+  void Term() {
+    Unary();
+    while (true) {
+      if (Accept('*')) {
+        Unary();
+        law.Emit(kMultiply);
+      } else if (Accept('/')) {
+        Unary();
+        law.Emit(kDivide);
+      } else {
+        return;
+      }
+    }
+  }
+
+  // unary := '-' unary | '+' unary | power
+  void Unary() {
+    if (Accept('-')) {
+      Unary();
+      law.Emit(kNegate);
+    } else if (Accept('+')) {
+      Unary();
+    } else {
+      Power();
+    }
+  }
+
+  // power := primary ('^' unary)?, so that a^b^c is a^(b^c)
+  void Power() {
+    Primary();
+    if (Accept('^')) {
+      Unary();
+      law.Emit(kPower);
+    }
+  }
+
+  // primary := number | name | function '(' arguments ')' | '(' expression ')'
+  void Primary() {
+    SkipSpace();
+    if (pos >= text.size()) {
+      Fail("unexpected end of expression");
+    }
+    char c = text[pos];
+    if (Accept('(')) {
+      Expression();
+      Expect(')');
+    } else if (std::isdigit((unsigned char)c) || c == '.') {
+      const char *start = text.c_str() + pos;
+      char *end = nullptr;
+      double value = std::strtod(start, &end);
+      if (end == start) {
+        Fail("malformed number");
+      }
+      pos += end - start;
+      law.constants_.push_back(value);
+      law.Emit(kConstant, law.constants_.size() - 1);
+    } else if (std::isalpha((unsigned char)c) || c == '_') {
+      size_t start = pos;
+      while (pos < text.size() &&
+             (std::isalnum((unsigned char)text[pos]) || text[pos] == '_' ||
+              text[pos] == '.')) {
+        pos++;
+      }
+      std::string name = text.substr(start, pos - start);
+      if (Accept('(')) {
+        Function(name);
+      } else {
+        Name(name);
+      }
+    } else {
+      Fail(std::string("unexpected '") + c + "'");
+    }
+  }
+
+  void Function(const std::string &name) {
+    static const std::map<std::string, std::pair<Op, int>> functions = {
+        {"exp", {kExp, 1}},   {"log", {kLog, 1}}, {"sqrt", {kSqrt, 1}},
+        {"abs", {kAbs, 1}},   {"pow", {kPower, 2}}, {"min", {kMin, 2}},
+        {"max", {kMax, 2}}};
+    auto it = functions.find(name);
+    if (it == functions.end()) {
+      Fail("unknown function '" + name + "'");
+    }
+    Expression();
+    for (int i = 1; i < it->second.second; i++) {
+      Expect(',');
+      Expression();
+    }
+    Expect(')');
+    law.Emit(it->second.first);
+  }
+
+  void Name(const std::string &name) {
+    auto param = parameters.find(name);
+    if (param != parameters.end()) {
+      law.constants_.push_back(param->second);
+      law.Emit(kConstant, law.constants_.size() - 1);
+      return;
+    }
+    auto &species = law.species_;
+    auto it = std::find(species.begin(), species.end(), name);
+    if (it == species.end()) {
+      species.push_back(name);
+      it = species.end() - 1;
+    }
+    law.Emit(kSpecies, it - species.begin());
+  }
+};
+
+RateLaw::RateLaw(const std::string &expression,
+                 const std::map<std::string, double> &parameters)
+    : expression_(expression) {
+  Parser parser(*this, parameters);
+  parser.Expression();
+  parser.SkipSpace();
+  if (parser.pos != expression_.size()) {
+    parser.Fail(std::string("unexpected '") + expression_[parser.pos] + "'");
+  }
+  // Size the stack for the deepest point of the program
+  int depth = 0;
+  int max_depth = 0;
+  for (const auto &instruction : program_) {
+    switch (instruction.op) {
+      case kConstant:
+      case kSpecies:
+        depth++;
+        break;
+      case kNegate:
+      case kExp:
+      case kLog:
+      case kSqrt:
+      case kAbs:
+        break;
+      default:
+        depth--;
+    }
+    max_depth = std::max(max_depth, depth);
+  }
+  stack_.resize(max_depth);
+}
+
+double RateLaw::Apply(Op op, double a, double b) {
+  switch (op) {
+    case kAdd:
+      return a + b;
+    case kSubtract:
+      return a - b;
+    case kMultiply:
+      return a * b;
+    case kDivide:
+      return a / b;
+    case kPower:
+      return std::pow(a, b);
+    case kNegate:
+      return -a;
+    case kExp:
+      return std::exp(a);
+    case kLog:
+      return std::log(a);
+    case kSqrt:
+      return std::sqrt(a);
+    case kAbs:
+      return std::abs(a);
+    case kMin:
+      return std::min(a, b);
+    case kMax:
+      return std::max(a, b);
+    default:
+      throw std::logic_error("Rate law: not an operator.");
+  }
+}
+
+void RateLaw::Emit(Op op, int operand) {
+  int n = program_.size();
+  bool unary = (op == kNegate || op == kExp || op == kLog || op == kSqrt ||
+                op == kAbs);
+  // Fold operations on constants into a single constant
+  if (unary && n >= 1 && program_[n - 1].op == kConstant) {
+    double &a = constants_[program_[n - 1].operand];
+    a = Apply(op, a, 0.0);
+    return;
+  }
+  if (!unary && op != kConstant && op != kSpecies && n >= 2 &&
+      program_[n - 2].op == kConstant && program_[n - 1].op == kConstant) {
+    double &a = constants_[program_[n - 2].operand];
+    a = Apply(op, a, constants_[program_[n - 1].operand]);
+    program_.pop_back();
+    return;
+  }
+  program_.push_back(Instruction{op, operand});
+}
+
+double RateLaw::Evaluate(const double *counts) const {
+  double *stack = stack_.data();
+  int top = -1;
+  for (const auto &instruction : program_) {
+    switch (instruction.op) {
+      case kConstant:
+        stack[++top] = constants_[instruction.operand];
+        break;
+      case kSpecies:
+        stack[++top] = counts[instruction.operand];
+        break;
+      case kNegate:
+      case kExp:
+      case kLog:
+      case kSqrt:
+      case kAbs:
+        stack[top] = Apply(instruction.op, stack[top], 0.0);
+        break;
+      default:
+        top--;
+        stack[top] = Apply(instruction.op, stack[top], stack[top + 1]);
+    }
+  }
+  return stack[0];
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_RATE_LAW_HPP  // header guard
+#define SRC_RATE_LAW_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * A rate law given as an arithmetic expression over species counts and named
+ * parameters, e.g. "vmax * A^n / (K^n + A^n)". The expression is parsed once
+ * and compiled to a postfix program, with parameters and constant
+ * subexpressions folded. Evaluation runs the program on a preallocated stack
+ * and does not allocate.
+ *
+ * Expressions may use numbers, the operators + - * / ^ (power) and
+ * parentheses, and the functions exp, log, sqrt, abs, pow, min and max.
+ * Any name that is not a parameter is a species; names start with a letter or
+ * underscore and contain letters, digits, underscores and periods.
+ */
+class RateLaw {
+ public:
+  /**
+   * Parse and compile a rate law. Throws std::invalid_argument if the
+   * expression is malformed.
+   *
+   * @param expression rate law
+   * @param parameters values of named constants in the expression
+   */
+  RateLaw(const std::string &expression,
+          const std::map<std::string, double> &parameters = {});
+  /**
+   * Evaluate the rate law.
+   *
+   * @param counts count of each species, in the order of species()
+   */
+  double Evaluate(const double *counts) const;
+  /**
+   * Species the rate law depends on, in order of first appearance.
+   */
+  const std::vector<std::string> &species() const { return species_; }
+  const std::string &expression() const { return expression_; }
+  /**
+   * Constants of the compiled program, including parameter values.
+   */
+  const std::vector<double> &constants() const { return constants_; }
+
+ private:
+  enum Op {
+    kConstant,
+    kSpecies,
+    kAdd,
+    kSubtract,
+    kMultiply,
+    kDivide,
+    kPower,
+    kNegate,
+    kExp,
+    kLog,
+    kSqrt,
+    kAbs,
+    kMin,
+    kMax
+  };
+  struct Instruction {
+    Op op;
+    /**
+     * Index into constants_ (kConstant) or species_ (kSpecies).
+     */
+    int operand;
+  };
+  std::string expression_;
+  std::vector<Instruction> program_;
+  std::vector<double> constants_;
+  std::vector<std::string> species_;
+  /**
+   * Evaluation stack, sized for the deepest point of the program.
+   */
+  mutable std::vector<double> stack_;
+
+  /**
+   * Recursive descent parser state; only used while compiling.
+   */
+  struct Parser;
+  void Emit(Op op, int operand = 0);
+  static double Apply(Op op, double a, double b);
+};
+
+#endif  // header guard
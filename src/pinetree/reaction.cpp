@@ -1,5 +1,12 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <numeric>
+
 #include "reaction.hpp"
 #include "choices.hpp"
+#include "deferred.hpp"
 #include "tracker.hpp"
 
 const static double AVAGADRO = double(6.0221409e+23);
@@ -8,6 +15,7 @@ SpeciesReaction::SpeciesReaction(double rate_constant, double volume,
                                  const std::vector<std::string> &reactants,
                                  const std::vector<std::string> &products)
     : rate_constant_(rate_constant),
+      volume_(volume),
       reactants_(reactants),
       products_(products) {
   // Error checking
@@ -34,13 +42,66 @@ SpeciesReaction::SpeciesReaction(double rate_constant, double volume,
   }
 }
 
+void SpeciesReaction::SetRateConstant(double rate_constant) {
+  if (rate_constant < 0) {
+    throw std::invalid_argument("Reaction rate constant cannot be negative.");
+  }
+  rate_constant_ = rate_constant;
+  if (reactants_.size() == 2) {
+    rate_constant_ = rate_constant_ / (AVAGADRO * volume_);
+  }
+  bounds_valid_ = false;
+}
+
+void SpeciesReaction::ComputeBounds(double fluctuation) {
+  auto &tracker = SpeciesTracker::Instance();
+  if (counts_.size() != reactants_.size()) {
+    for (const auto &reactant : reactants_) {
+      counts_.push_back(tracker.FindSpecies(reactant));
+    }
+  }
+  lower_counts_.clear();
+  upper_counts_.clear();
+  lower_bound_ = rate_constant_;
+  upper_bound_ = rate_constant_;
+  for (const int *count : counts_) {
+    int width = std::max(1, int(fluctuation * *count));
+    lower_counts_.push_back(std::max(0, *count - width));
+    upper_counts_.push_back(*count + width);
+    lower_bound_ *= lower_counts_.back();
+    upper_bound_ *= upper_counts_.back();
+  }
+  bounds_valid_ = true;
+}
+
+bool SpeciesReaction::InBounds() const {
+  if (!bounds_valid_) {
+    return false;
+  }
+  for (std::size_t i = 0; i < counts_.size(); i++) {
+    if (*counts_[i] < lower_counts_[i] || *counts_[i] > upper_counts_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
 double SpeciesReaction::CalculatePropensity() {
   if (remove_ == true) {
     old_prop_ = 0;
   }
   double new_prop = rate_constant_;
+  // Species in a fast equilibrium contribute their expected copy numbers
+  for (const auto &equilibrium : equilibria_) {
+    new_prop *= equilibrium->ExpectedProduct(reactants_);
+  }
   for (const auto &reactant : reactants_) {
-    new_prop *= SpeciesTracker::Instance().species(reactant);
+    if (std::none_of(equilibria_.begin(), equilibria_.end(),
+                     [&reactant](const FastEquilibrium::Ptr &equilibrium) {
+                       return equilibrium->Contains(reactant);
+                     })) {
+      new_prop *= SpeciesTracker::Instance().species(reactant);
+    }
   }
   double prop_diff = new_prop - old_prop_;
   old_prop_ = new_prop;
@@ -48,6 +109,266 @@ double SpeciesReaction::CalculatePropensity() {
 }
 
 void SpeciesReaction::Execute() {
+  // Fast equilibria are in a state in which this reaction can fire
+  for (const auto &equilibrium : equilibria_) {
+    equilibrium->Relax(reactants_);
+  }
+  for (const auto &reactant : reactants_) {
+    SpeciesTracker::Instance().Increment(reactant, -1);
+  }
+  for (const auto &product : products_) {
+    SpeciesTracker::Instance().Increment(product, 1);
+  }
+  for (const auto &equilibrium : relaxed_) {
+    equilibrium->Relax();
+  }
+}
+
+void SpeciesReaction::AddEquilibrium(FastEquilibrium::Ptr equilibrium) {
+  std::map<std::string, int> change;
+  for (const auto &reactant : reactants_) {
+    change[reactant]--;
+  }
+  for (const auto &product : products_) {
+    change[product]++;
+  }
+  bool involved = false;
+  bool changed = false;
+  for (const auto &species : change) {
+    if (equilibrium->Contains(species.first)) {
+      involved = involved || std::count(reactants_.begin(), reactants_.end(),
+                                        species.first) > 0;
+      changed = changed || species.second != 0;
+    }
+  }
+  if (involved) {
+    equilibria_.push_back(equilibrium);
+  }
+  if (changed) {
+    relaxed_.push_back(equilibrium);
+  }
+}
+
+FastEquilibrium::FastEquilibrium(SpeciesReaction::Ptr forward,
+                                 SpeciesReaction::Ptr reverse)
+    : forward_(forward), reverse_(reverse) {
+  std::map<std::string, int> change;
+  for (const auto &reactant : forward_->reactants()) {
+    change[reactant]--;
+  }
+  for (const auto &product : forward_->products()) {
+    change[product]++;
+  }
+  bool consumes = false;
+  bool produces = false;
+  for (const auto &species : change) {
+    if (species.second == 0 ||
+        std::count(forward_->reactants().begin(), forward_->reactants().end(),
+                   species.first) *
+                std::count(forward_->products().begin(),
+                           forward_->products().end(), species.first) !=
+            0) {
+      throw std::invalid_argument(
+          "Fast equilibrium: reactants and products must be different "
+          "species.");
+    }
+    consumes = consumes || species.second < 0;
+    produces = produces || species.second > 0;
+    species_.push_back(species.first);
+    change_.push_back(species.second);
+  }
+  auto sorted = [](std::vector<std::string> names) {
+    std::sort(names.begin(), names.end());
+    return names;
+  };
+  if (!consumes || !produces ||
+      sorted(forward_->reactants()) != sorted(reverse_->products()) ||
+      sorted(forward_->products()) != sorted(reverse_->reactants())) {
+    throw std::invalid_argument(
+        "Fast equilibrium: reactions must be the reverse of each other.");
+  }
+}
+
+double FastEquilibrium::Propensity(const SpeciesReaction &reaction,
+                                   const std::vector<int> &counts) const {
+  double propensity = reaction.rate_constant();
+  for (const auto &reactant : reaction.reactants()) {
+    auto index = std::find(species_.begin(), species_.end(), reactant) -
+                 species_.begin();
+    propensity *= counts[index];
+  }
+  return propensity;
+}
+
+void FastEquilibrium::Update() {
+  auto &tracker = SpeciesTracker::Instance();
+  std::vector<int> counts;
+  for (const auto &name : species_) {
+    counts.push_back(tracker.species(name));
+  }
+  // States reachable from the current one, as a number of forward reactions
+  // (negative for reverse reactions); both sides of the pair are bounded by
+  // the copy numbers of the species they consume
+  int lowest = std::numeric_limits<int>::min();
+  int highest = std::numeric_limits<int>::max();
+  for (int i = 0; i < int(species_.size()); i++) {
+    if (change_[i] > 0) {
+      lowest = std::max(lowest, -(counts[i] / change_[i]));
+    } else {
+      highest = std::min(highest, counts[i] / -change_[i]);
+    }
+  }
+  auto state = [this, &counts](int reactions) {
+    std::vector<int> result(counts);
+    for (int i = 0; i < int(result.size()); i++) {
+      result[i] += reactions * change_[i];
+    }
+    return result;
+  };
+  // Detailed balance of a birth-death process: p(x + 1) / p(x) =
+  // forward(x) / reverse(x + 1). Both propensities are positive inside the
+  // range because the two sides share no species.
+  std::vector<double> log_weights(highest - lowest + 1, 0.0);
+  for (int x = lowest; x < highest; x++) {
+    log_weights[x + 1 - lowest] =
+        log_weights[x - lowest] + std::log(Propensity(*forward_, state(x))) -
+        std::log(Propensity(*reverse_, state(x + 1)));
+  }
+  double max_weight =
+      *std::max_element(log_weights.begin(), log_weights.end());
+  // Drop states that are too unlikely to matter
+  const double kNegligible = std::log(1e-16);
+  int first = 0;
+  while (log_weights[first] - max_weight < kNegligible) {
+    first++;
+  }
+  int last = log_weights.size() - 1;
+  while (log_weights[last] - max_weight < kNegligible) {
+    last--;
+  }
+  probabilities_.clear();
+  for (int i = first; i <= last; i++) {
+    probabilities_.push_back(std::exp(log_weights[i] - max_weight));
+  }
+  double total =
+      std::accumulate(probabilities_.begin(), probabilities_.end(), 0.0);
+  for (auto &probability : probabilities_) {
+    probability /= total;
+  }
+  first_ = state(lowest + first);
+}
+
+void FastEquilibrium::Relax(const std::vector<std::string> &names) {
+  Update();
+  std::vector<double> weights(probabilities_);
+  for (const auto &name : names) {
+    auto it = std::find(species_.begin(), species_.end(), name);
+    if (it == species_.end()) {
+      continue;
+    }
+    int species = it - species_.begin();
+    for (int state = 0; state < int(weights.size()); state++) {
+      weights[state] *= first_[species] + state * change_[species];
+    }
+  }
+  int index = Random::WeightedChoiceIndex(weights, weights);
+  auto &tracker = SpeciesTracker::Instance();
+  for (int i = 0; i < int(species_.size()); i++) {
+    // Incrementing by 0 still updates the propensities of slow reactions
+    tracker.Increment(species_[i], first_[i] + index * change_[i] -
+                                       tracker.species(species_[i]));
+  }
+}
+
+double FastEquilibrium::ExpectedProduct(
+    const std::vector<std::string> &names) const {
+  std::vector<int> indices;
+  for (const auto &name : names) {
+    auto it = std::find(species_.begin(), species_.end(), name);
+    if (it != species_.end()) {
+      indices.push_back(it - species_.begin());
+    }
+  }
+  if (indices.empty()) {
+    return 1.0;
+  }
+  double expected = 0;
+  for (int state = 0; state < int(probabilities_.size()); state++) {
+    double product = probabilities_[state];
+    for (int index : indices) {
+      product *= first_[index] + state * change_[index];
+    }
+    expected += product;
+  }
+  return expected;
+}
+
+double FastEquilibrium::Flux() const {
+  return forward_->rate_constant() * ExpectedProduct(forward_->reactants());
+}
+
+bool FastEquilibrium::Contains(const std::string &name) const {
+  return std::find(species_.begin(), species_.end(), name) != species_.end();
+}
+
+RateLawReaction::RateLawReaction(const RateLaw &rate_law,
+                                 const std::vector<std::string> &reactants,
+                                 const std::vector<std::string> &products)
+    : rate_law_(rate_law),
+      reactants_(reactants),
+      products_(products),
+      counts_(rate_law.species().size(), 0.0) {
+  old_prop_ = 0;
+  if (reactants_.size() == 0 && products_.size() == 0) {
+    throw std::invalid_argument(
+        "You must specify at least one product or reactant.");
+  }
+  for (const auto &reactant : reactants_) {
+    stoichiometry_[reactant]++;
+  }
+}
+
+void RateLawReaction::FindCounts() {
+  auto &tracker = SpeciesTracker::Instance();
+  for (const auto &reactant : stoichiometry_) {
+    reactant_counts_.emplace_back(tracker.FindSpecies(reactant.first),
+                                  reactant.second);
+  }
+  for (const auto &name : rate_law_.species()) {
+    species_counts_.push_back(tracker.FindSpecies(name));
+  }
+}
+
+double RateLawReaction::CalculatePropensity() {
+  if (remove_ == true) {
+    old_prop_ = 0;
+  }
+  if (reactant_counts_.size() != stoichiometry_.size() ||
+      species_counts_.size() != counts_.size()) {
+    FindCounts();
+  }
+  double new_prop = 0.0;
+  bool possible = true;
+  for (const auto &reactant : reactant_counts_) {
+    possible = possible && *reactant.first >= reactant.second;
+  }
+  if (possible) {
+    for (size_t i = 0; i < counts_.size(); i++) {
+      counts_[i] = *species_counts_[i];
+    }
+    new_prop = rate_law_.Evaluate(counts_.data());
+    if (!(new_prop >= 0)) {
+      throw std::runtime_error("Rate law '" + rate_law_.expression() +
+                               "' evaluated to " + std::to_string(new_prop) +
+                               "; propensities must not be negative.");
+    }
+  }
+  double prop_diff = new_prop - old_prop_;
+  old_prop_ = new_prop;
+  return prop_diff;
+}
+
+void RateLawReaction::Execute() {
   for (const auto &reactant : reactants_) {
     SpeciesTracker::Instance().Increment(reactant, -1);
   }
@@ -97,9 +418,13 @@ void BindPolymerase::Execute() {
   auto polymer = ChoosePolymer();
   auto new_pol = std::make_shared<Polymerase>(pol_template_);
   polymer->Bind(new_pol, promoter_name_);
-  SpeciesTracker::Instance().propensity_signal_.Emit(polymer->wrapper());
+  auto &tracker = SpeciesTracker::Instance();
+  tracker.propensity_signal_.Emit(polymer->wrapper());
   // Polymer should handle decrementing promoter
-  SpeciesTracker::Instance().Increment(new_pol->name(), -1);
+  tracker.Increment(new_pol->name(), -1);
+  if (tracker.observers_.active()) {
+    tracker.observers_.Bind(new_pol->name(), promoter_name_, polymer->id());
+  }
 }
 
 BindRnase::BindRnase(double rate_constant, double volume,
@@ -110,7 +435,11 @@ void BindRnase::Execute() {
   auto polymer = ChoosePolymer();
   auto new_pol = std::make_shared<Rnase>(pol_template_);
   polymer->Bind(new_pol, promoter_name_);
-  SpeciesTracker::Instance().propensity_signal_.Emit(polymer->wrapper());
+  auto &tracker = SpeciesTracker::Instance();
+  tracker.propensity_signal_.Emit(polymer->wrapper());
+  if (tracker.observers_.active()) {
+    tracker.observers_.Bind(new_pol->name(), promoter_name_, polymer->id());
+  }
 }
 
 double BindRnase::CalculatePropensity() {
@@ -124,6 +453,115 @@ double BindRnase::CalculatePropensity() {
   return prop_diff;
 }
 
+ReplicateGenome::ReplicateGenome(Genome::Ptr genome, double rate_constant,
+                                 int copies, int max_copies)
+    : genome_(genome),
+      rate_constant_(rate_constant),
+      copies_(copies),
+      max_copies_(max_copies) {
+  if (rate_constant <= 0) {
+    throw std::invalid_argument("Replication rate constant of genome " +
+                                genome->name() + " must be positive.");
+  }
+  if (max_copies < 0) {
+    throw std::invalid_argument("Maximum copy number of genome " +
+                                genome->name() + " cannot be negative.");
+  }
+}
+
+double ReplicateGenome::CalculatePropensity() {
+  double new_prop = 0;
+  if (max_copies_ == 0 || copies_ < max_copies_) {
+    new_prop = rate_constant_ * copies_;
+  }
+  double prop_diff = new_prop - old_prop_;
+  old_prop_ = new_prop;
+  return prop_diff;
+}
+
+void ReplicateGenome::Execute() {
+  copies_++;
+  replication_signal_.Emit(genome_->Replicate());
+}
+
+MeanFieldTasep::MeanFieldTasep(const std::vector<double> &rates,
+                               int footprint, int entry_length)
+    : sites_(rates.size()) {
+  if (footprint < 1 || entry_length < 1) {
+    throw std::invalid_argument(
+        "Footprint and binding site length must be positive.");
+  }
+  std::vector<double> times;
+  for (double rate : rates) {
+    if (rate <= 0) {
+      throw std::invalid_argument(
+          "Mean-field translation requires positive elongation rates "
+          "(check for zero weights).");
+    }
+    times.push_back(1.0 / rate);
+  }
+  traverse_time_ = std::accumulate(times.begin(), times.end(), 0.0);
+  entry_time_ = std::accumulate(
+      times.begin(), times.begin() + std::min(entry_length, sites_), 0.0);
+  // Slowest stretch of `footprint` positions
+  int window = std::min(footprint, sites_);
+  double window_time =
+      std::accumulate(times.begin(), times.begin() + window, 0.0);
+  double slowest = window_time;
+  for (int i = window; i < sites_; i++) {
+    window_time += times[i] - times[i - window];
+    slowest = std::max(slowest, window_time);
+  }
+  double root = std::sqrt(double(footprint));
+  max_current_ = (window > 0)
+                     ? window / slowest / ((1 + root) * (1 + root))
+                     : std::numeric_limits<double>::infinity();
+  max_density_ = 1.0 / (root * (1 + root));
+}
+
+double MeanFieldTasep::Current(double initiation_rate) const {
+  // The binding site stays covered for entry_time_ after each initiation
+  double current = initiation_rate / (1 + initiation_rate * entry_time_);
+  return std::min(current, max_current_);
+}
+
+double MeanFieldTasep::Load(double initiation_rate) const {
+  double current = Current(initiation_rate);
+  if (current >= max_current_) {
+    // Ribosomes queue behind the slowest stretch
+    return max_density_ * sites_;
+  }
+  return current * traverse_time_;
+}
+
+MeanFieldTranslation::MeanFieldTranslation(double rate_constant, double volume,
+                                           const std::string &rbs_name,
+                                           const std::string &gene,
+                                           const MeanFieldTasep &lattice)
+    : rate_constant_(rate_constant / (AVAGADRO * volume)),
+      rbs_name_(rbs_name),
+      gene_(gene),
+      lattice_(lattice) {}
+
+void MeanFieldTranslation::AddRateConstant(double rate_constant,
+                                           double volume) {
+  rate_constant_ += rate_constant / (AVAGADRO * volume);
+}
+
+double MeanFieldTranslation::CalculatePropensity() {
+  auto &tracker = SpeciesTracker::Instance();
+  double initiation_rate = rate_constant_ * tracker.species("__ribosome");
+  double new_prop =
+      lattice_.Current(initiation_rate) * tracker.species(rbs_name_);
+  double prop_diff = new_prop - old_prop_;
+  old_prop_ = new_prop;
+  return prop_diff;
+}
+
+void MeanFieldTranslation::Execute() {
+  SpeciesTracker::Instance().Increment(gene_, 1);
+}
+
 PolymerWrapper::PolymerWrapper(Polymer::Ptr polymer) : polymer_(polymer) {
   old_prop_ = 0;
   polymer_->Initialize();
@@ -143,6 +581,17 @@ void PolymerWrapper::Execute() {
   polymer_->Execute();
   if (polymer_->degrade() == true && polymer_->attached() == false) {
     remove_ = true;
+    auto &tracker = SpeciesTracker::Instance();
+    tracker.journal_.LogTranscriptDestroyed(polymer_->id());
+    if (tracker.observers_.active()) {
+      int id = polymer_->id();
+      auto destroyed = [&tracker, id]() {
+        tracker.observers_.TranscriptDestroyed(id);
+      };
+      if (!Defer(destroyed)) {
+        destroyed();
+      }
+    }
     // std::cout << "Removing polymer wrapper...\n" << std::endl;
   }
 }
\ No newline at end of file
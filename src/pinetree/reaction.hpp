@@ -4,6 +4,7 @@
 #define SRC_REACTION_HPP
 
 #include "polymer.hpp"
+#include "rate_law.hpp"
 /**
  * An abstract reaction class. Propensity refers to the reaction propensity, or
  * the probability that this reaction will occur in the next time step. It is a
@@ -51,6 +52,8 @@ class Reaction : public std::enable_shared_from_this<Reaction> {
   bool remove_ = false;
 };
 
+class FastEquilibrium;
+
 /**
  * A generic class for a species-level reaction. It currently only supports 2 or
  * fewer reactants.
@@ -84,17 +87,66 @@ class SpeciesReaction : public Reaction {
    * Execute the reaction. Decrement reactants and increment products.
    */
   void Execute();
+  /**
+   * Change the macroscopic rate constant. A rate constant of zero switches
+   * the reaction off. The new propensity takes effect at the next propensity
+   * update.
+   */
+  void SetRateConstant(double rate_constant);
+  /**
+   * Use the expected copy numbers of species in a fast equilibrium (see
+   * FastEquilibrium) to calculate the propensity, and let the equilibrium
+   * relax whenever this reaction changes one of its species.
+   */
+  void AddEquilibrium(std::shared_ptr<FastEquilibrium> equilibrium);
+  /**
+   * Compute bounds on the propensity that hold while the count of each
+   * reactant stays within `fluctuation` (a fraction of its count, and at
+   * least one copy) of its current count.
+   */
+  void ComputeBounds(double fluctuation);
+  /**
+   * Do the bounds of the last ComputeBounds() still hold?
+   */
+  bool InBounds() const;
+  /**
+   * Can the propensity be bounded from reactant counts? Not if it uses
+   * expected counts of a fast equilibrium.
+   */
+  bool bounded() const { return equilibria_.empty(); }
+  double lower_bound() const { return lower_bound_; }
+  double upper_bound() const { return upper_bound_; }
   /**
    * Getters and setters.
    */
   const std::vector<std::string> &reactants() const { return reactants_; }
   const std::vector<std::string> &products() const { return products_; }
+  double rate_constant() const { return rate_constant_; }
 
  private:
+  /**
+   * Fast equilibria involving the reactants, and fast equilibria whose
+   * species are changed by this reaction.
+   */
+  std::vector<std::shared_ptr<FastEquilibrium>> equilibria_;
+  std::vector<std::shared_ptr<FastEquilibrium>> relaxed_;
+  /**
+   * Reactant counts and their intervals when the bounds were computed.
+   */
+  std::vector<const int *> counts_;
+  std::vector<int> lower_counts_;
+  std::vector<int> upper_counts_;
+  double lower_bound_ = 0;
+  double upper_bound_ = 0;
+  bool bounds_valid_ = false;
   /**
    * Rate constant of reaction.
    */
   double rate_constant_;
+  /**
+   * Volume in which the reaction occurs.
+   */
+  double volume_;
   /**
    * Vector of reactant names.
    */
@@ -105,6 +157,129 @@ class SpeciesReaction : public Reaction {
   const std::vector<std::string> products_;
 };
 
+/**
+ * A fast reversible pair of species reactions (e.g. repressor binding and
+ * unbinding) treated in quasi-equilibrium by the slow-scale SSA (Cao,
+ * Gillespie and Petzold, 2005). Neither reaction is simulated. Between slow
+ * reactions, the pair moves between states that differ by whole forward or
+ * reverse reactions; its stationary distribution over these states is
+ * computed exactly. Slow reactions use expected copy numbers under this
+ * distribution, and the copy numbers are drawn from it again whenever a slow
+ * reaction changes them.
+ */
+class FastEquilibrium {
+ public:
+  /**
+   * @param forward forward reaction
+   * @param reverse reverse reaction, whose reactants are the products of
+   *  `forward` and vice versa; the two sides must not share species
+   */
+  FastEquilibrium(SpeciesReaction::Ptr forward, SpeciesReaction::Ptr reverse);
+  typedef std::shared_ptr<FastEquilibrium> Ptr;
+  /**
+   * Compute the stationary distribution for the current copy numbers of the
+   * species, without changing them.
+   */
+  void Update();
+  /**
+   * Update(), then draw the copy numbers of the species from the stationary
+   * distribution. If `names` are given, each state is weighted by the
+   * product of their copy numbers, i.e. the state is drawn given that a
+   * reaction with these reactants has fired.
+   */
+  void Relax(const std::vector<std::string> &names = {});
+  /**
+   * Expected product of the copy numbers of those `names` that are species
+   * of this equilibrium (1 if there are none).
+   */
+  double ExpectedProduct(const std::vector<std::string> &names) const;
+  /**
+   * Expected propensity of the forward reaction, which equals that of the
+   * reverse reaction at equilibrium.
+   */
+  double Flux() const;
+  /**
+   * Is `name` one of the species of this equilibrium?
+   */
+  bool Contains(const std::string &name) const;
+  const std::vector<std::string> &species() const { return species_; }
+  SpeciesReaction::Ptr forward() const { return forward_; }
+  SpeciesReaction::Ptr reverse() const { return reverse_; }
+
+ private:
+  SpeciesReaction::Ptr forward_;
+  SpeciesReaction::Ptr reverse_;
+  /**
+   * Species and their net change when the forward reaction fires.
+   */
+  std::vector<std::string> species_;
+  std::vector<int> change_;
+  /**
+   * Copy numbers in the first state with a non-negligible probability, and
+   * the probabilities of it and of each state reached from it by forward
+   * reactions.
+   */
+  std::vector<int> first_;
+  std::vector<double> probabilities_;
+  double Propensity(const SpeciesReaction &reaction,
+                    const std::vector<int> &counts) const;
+};
+
+/**
+ * A species-level reaction whose propensity is given by a RateLaw (e.g. a
+ * Hill function) instead of mass action. The rate law is the stochastic
+ * propensity itself, in reactions per second, computed from copy numbers;
+ * it is not converted from a macroscopic rate. The reaction cannot fire while
+ * any reactant is depleted.
+ */
+class RateLawReaction : public Reaction {
+ public:
+  /**
+   * @param rate_law propensity of the reaction
+   * @param reactants vector of reactant names, consumed when the reaction
+   *  fires
+   * @param products vector of product names
+   */
+  RateLawReaction(const RateLaw &rate_law,
+                  const std::vector<std::string> &reactants,
+                  const std::vector<std::string> &products);
+  typedef std::shared_ptr<RateLawReaction> Ptr;
+  /**
+   * Calculate *change* in propensity of this reaction.
+   */
+  double CalculatePropensity();
+  /**
+   * Execute the reaction. Decrement reactants and increment products.
+   */
+  void Execute();
+  /**
+   * Getters and setters.
+   */
+  const RateLaw &rate_law() const { return rate_law_; }
+  const std::vector<std::string> &reactants() const { return reactants_; }
+  const std::vector<std::string> &products() const { return products_; }
+
+ private:
+  const RateLaw rate_law_;
+  const std::vector<std::string> reactants_;
+  const std::vector<std::string> products_;
+  /**
+   * Copies of each distinct reactant consumed per reaction.
+   */
+  std::map<std::string, int> stoichiometry_;
+  /**
+   * Handles to the tracker counts of each distinct reactant and of each
+   * species in the rate law, looked up on first use.
+   */
+  std::vector<std::pair<const int *, int>> reactant_counts_;
+  std::vector<const int *> species_counts_;
+  /**
+   * Counts of the species in the rate law, refreshed on every evaluation.
+   */
+  std::vector<double> counts_;
+  void FindCounts();
+};
+
 /**
  * Bind a mobile element to a polymer.
  */
@@ -209,6 +384,139 @@ class BindRnase : public Bind {
   const Rnase pol_template_;
 };
 
+/**
+ * Replicate a genome. Each copy of the genome replicates at the same rate, so
+ * the propensity is proportional to the number of copies, until an optional
+ * limit is reached. New copies are made with Genome::Replicate() and emitted
+ * through replication_signal_ to be registered.
+ */
+class ReplicateGenome : public Reaction {
+ public:
+  /**
+   * @param genome genome from which copies are made
+   * @param rate_constant replication rate of each copy (per second)
+   * @param copies number of copies of the genome at the start
+   * @param max_copies largest number of copies, or 0 for no limit
+   */
+  ReplicateGenome(Genome::Ptr genome, double rate_constant, int copies,
+                  int max_copies);
+  /**
+   * Calculate *change* in propensity of this reaction.
+   */
+  double CalculatePropensity();
+  /**
+   * Make a new copy of the genome.
+   */
+  void Execute();
+  /**
+   * Getters and setters.
+   */
+  int copies() const { return copies_; }
+  /**
+   * Signal to fire with each new copy.
+   */
+  Signal<Genome::Ptr> replication_signal_;
+
+ private:
+  Genome::Ptr genome_;
+  double rate_constant_;
+  int copies_;
+  int max_copies_;
+};
+
+/**
+ * Steady state of ribosomes on one gene, treated as a totally asymmetric
+ * exclusion process (TASEP) of particles that cover `footprint` sites, in a
+ * mean-field approximation. When initiation is limiting, a new ribosome can
+ * bind whenever the previous one has cleared the binding site. Otherwise the
+ * current is limited by the slowest stretch of `footprint` positions, which
+ * carries at most rate / (1 + sqrt(footprint))^2 (Shaw, Zia and Lee, 2003).
+ */
+class MeanFieldTasep {
+ public:
+  /**
+   * @param rates rate at which a ribosome moves forward from each position of
+   *  its leading edge, from binding until it reaches the stop codon
+   * @param footprint ribosome footprint
+   * @param entry_length number of moves a ribosome makes before the binding
+   *  site is exposed again
+   */
+  MeanFieldTasep(const std::vector<double> &rates, int footprint,
+                 int entry_length);
+  /**
+   * Proteins completed per unit time, for ribosomes that bind an exposed
+   * site at `initiation_rate`.
+   */
+  double Current(double initiation_rate) const;
+  /**
+   * Mean number of ribosomes on the gene at `initiation_rate`.
+   */
+  double Load(double initiation_rate) const;
+  /**
+   * Number of moves from binding to termination.
+   */
+  int sites() const { return sites_; }
+
+ private:
+  int sites_;
+  /**
+   * Time an unhindered ribosome takes to clear the binding site, and to
+   * translate the whole gene.
+   */
+  double entry_time_;
+  double traverse_time_;
+  /**
+   * Largest current the slowest stretch of the gene can carry, and the
+   * ribosome density on the gene when the current is at this limit.
+   */
+  double max_current_;
+  double max_density_;
+};
+
+/**
+ * Translation of a gene with the mean-field approximation of MeanFieldTasep
+ * instead of explicit ribosomes. Each exposed ribosome binding site produces
+ * protein at the steady-state current for the current number of free
+ * ribosomes. The time a ribosome takes to reach the stop codon, the ribosomes
+ * held on the gene and collisions with ribosomes translating other genes on
+ * the same transcript are ignored.
+ */
+class MeanFieldTranslation : public Reaction {
+ public:
+  /**
+   * @param rate_constant macroscopic rate constant of ribosome binding
+   * @param volume volume in which reaction occurs
+   * @param rbs_name name of ribosome binding site
+   * @param gene name of gene (and of the protein it produces)
+   * @param lattice steady state of ribosomes on this gene
+   */
+  MeanFieldTranslation(double rate_constant, double volume,
+                       const std::string &rbs_name, const std::string &gene,
+                       const MeanFieldTasep &lattice);
+  /**
+   * Add the rate constant of another polymer with the same binding site.
+   * Ribosomes bind any copy of the site, so their initiation rate is the sum.
+   */
+  void AddRateConstant(double rate_constant, double volume);
+  /**
+   * Calculate *change* in propensity of this reaction.
+   */
+  double CalculatePropensity();
+  /**
+   * Produce one protein.
+   */
+  void Execute();
+
+ private:
+  /**
+   * Mesoscopic rate constant of ribosome binding.
+   */
+  double rate_constant_;
+  const std::string rbs_name_;
+  const std::string gene_;
+  const MeanFieldTasep lattice_;
+};
+
 /**
  * A thin wrapper for Polymer so it can participate in species-level reaction
  * processing.
@@ -249,6 +557,7 @@ class PolymerWrapper : public Reaction {
    */
   void index(int index);
   int index() const { return index_; }
+  Polymer::Ptr polymer() const { return polymer_; }
 
  private:
   /**
@@ -0,0 +1,71 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <algorithm>
+#include <thread>
+
+#include "snapshot.hpp"
+
+SnapshotBuffer::Layout::Layout(const std::map<std::string, int> &species)
+    : counts(new std::atomic<int>[species.size()]) {
+  for (const auto &item : species) {
+    names.push_back(item.first);
+  }
+}
+
+void SnapshotBuffer::Publish(double time, long events,
+                             const std::map<std::string, int> &species) {
+  const Layout *layout = layouts_.empty() ? nullptr : layouts_.back().get();
+  if (layout == nullptr || layout->names.size() != species.size() ||
+      !std::equal(species.begin(), species.end(), layout->names.begin(),
+                  [](const std::pair<const std::string, int> &item,
+                     const std::string &name) { return item.first == name; })) {
+    layouts_.emplace_back(new Layout(species));
+    layout = layouts_.back().get();
+  }
+  auto sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  // Readers that see any of the writes below also see the odd sequence
+  std::atomic_thread_fence(std::memory_order_release);
+  layout_.store(layout, std::memory_order_release);
+  time_.store(time, std::memory_order_relaxed);
+  events_.store(events, std::memory_order_relaxed);
+  int i = 0;
+  for (const auto &item : species) {
+    layout->counts[i++].store(item.second, std::memory_order_relaxed);
+  }
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+Snapshot SnapshotBuffer::Read() const {
+  Snapshot snapshot;
+  std::vector<int> counts;
+  while (true) {
+    auto before = sequence_.load(std::memory_order_acquire);
+    if (before % 2 == 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    const Layout *layout = layout_.load(std::memory_order_acquire);
+    if (layout == nullptr) {
+      return snapshot;
+    }
+    double time = time_.load(std::memory_order_relaxed);
+    long events = events_.load(std::memory_order_relaxed);
+    counts.resize(layout->names.size());
+    for (std::size_t i = 0; i < counts.size(); i++) {
+      counts[i] = layout->counts[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) != before) {
+      continue;
+    }
+    snapshot.time = time;
+    snapshot.events = events;
+    snapshot.version = before / 2;
+    for (std::size_t i = 0; i < counts.size(); i++) {
+      snapshot.species.emplace_hint(snapshot.species.end(), layout->names[i],
+                                    counts[i]);
+    }
+    return snapshot;
+  }
+}
@@ -0,0 +1,87 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef SRC_SNAPSHOT_HPP  // header guard
+#define SRC_SNAPSHOT_HPP
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Species counts and progress of a running simulation at one point in time.
+ */
+struct Snapshot {
+  /**
+   * Simulated time at which the snapshot was published.
+   */
+  double time = 0;
+  /**
+   * Number of reactions executed when the snapshot was published.
+   */
+  long events = 0;
+  /**
+   * Number of snapshots published so far, including this one (0 if none has
+   * been published yet).
+   */
+  long version = 0;
+  /**
+   * Copy numbers of all species.
+   */
+  std::map<std::string, int> species;
+};
+
+/**
+ * Single-writer, multi-reader publication of species counts, protected by a
+ * sequence lock. The simulation thread publishes without ever blocking, and
+ * monitoring threads read consistent (never torn) snapshots by retrying
+ * reads that overlap with a publication.
+ *
+ * The set of species is stored separately from their counts, and a new set
+ * is only allocated when species are added. Old sets are kept until the
+ * buffer is destroyed, since a reader may still be looking at one.
+ */
+class SnapshotBuffer {
+ public:
+  SnapshotBuffer() = default;
+  SnapshotBuffer(const SnapshotBuffer &) = delete;
+  SnapshotBuffer &operator=(const SnapshotBuffer &) = delete;
+  /**
+   * Publish new counts. Must only be called from one thread at a time.
+   *
+   * @param time current simulated time
+   * @param events number of reactions executed so far
+   * @param species current copy numbers of all species
+   */
+  void Publish(double time, long events,
+               const std::map<std::string, int> &species);
+  /**
+   * Copy the last published snapshot. Safe to call from any thread, at any
+   * time.
+   */
+  Snapshot Read() const;
+
+ private:
+  /**
+   * Names of the species and slots for their counts, in the same order.
+   */
+  struct Layout {
+    explicit Layout(const std::map<std::string, int> &species);
+    std::vector<std::string> names;
+    std::unique_ptr<std::atomic<int>[]> counts;
+  };
+  /**
+   * Odd while a publication is in progress.
+   */
+  std::atomic<unsigned long> sequence_{0};
+  std::atomic<const Layout *> layout_{nullptr};
+  std::atomic<double> time_{0};
+  std::atomic<long> events_{0};
+  /**
+   * Every layout ever published, owned by the writer.
+   */
+  std::vector<std::unique_ptr<Layout>> layouts_;
+};
+
+#endif  // SRC_SNAPSHOT_HPP
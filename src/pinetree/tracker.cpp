@@ -1,7 +1,11 @@
 #include <algorithm>
+#include <set>
 
+#include "deferred.hpp"
 #include "tracker.hpp"
 
+thread_local DeferredQueue *deferred_updates = nullptr;
+
 SpeciesTracker &SpeciesTracker::Instance() {
   static SpeciesTracker instance;
   return instance;
@@ -9,11 +13,19 @@ SpeciesTracker &SpeciesTracker::Instance() {
 
 void SpeciesTracker::Clear() {
   species_.clear();
+  pinned_.clear();
+  species_version_++;
   promoter_map_.clear();
   species_map_.clear();
   transcripts_.clear();
   ribo_per_transcript_.clear();
   propensity_signal_.DisconnectAll();
+  journal_.Clear();
+  observers_.Clear();
+  next_id_ = 1;
+  averages_.clear();
+  clock_ = nullptr;
+  interval_start_ = 0;
 }
 
 void SpeciesTracker::Register(SpeciesReaction::Ptr reaction) {
@@ -33,11 +45,20 @@ void SpeciesTracker::Register(SpeciesReaction::Ptr reaction) {
 
 void SpeciesTracker::Increment(const std::string &species_name,
                                int copy_number) {
+  if (Defer(&SpeciesTracker::Increment, this, species_name, copy_number)) {
+    return;
+  }
+  auto averages = clock_ ? &Averages(species_name) : nullptr;
   if (species_.count(species_name) == 0) {
     species_[species_name] = copy_number;
+    species_version_++;
   } else {
     species_[species_name] += copy_number;
   }
+  if (averages) {
+    UpdateAverages(species_name, *averages);
+  }
+  journal_.LogSpecies(species_name);
   if (species_map_.count(species_name) > 0) {
     for (const auto &reaction : species_map_[species_name]) {
       propensity_signal_.Emit(reaction);
@@ -50,11 +71,19 @@ void SpeciesTracker::Increment(const std::string &species_name,
 
 void SpeciesTracker::IncrementRibo(const std::string &transcript_name,
                                    int copy_number) {
+  if (Defer(&SpeciesTracker::IncrementRibo, this, transcript_name,
+            copy_number)) {
+    return;
+  }
+  auto averages = clock_ ? &Averages(transcript_name) : nullptr;
   if (ribo_per_transcript_.count(transcript_name) == 0) {
     ribo_per_transcript_[transcript_name] = copy_number;
   } else {
     ribo_per_transcript_[transcript_name] += copy_number;
   }
+  if (averages) {
+    UpdateAverages(transcript_name, *averages);
+  }
   if (ribo_per_transcript_[transcript_name] < 0) {
     throw std::runtime_error("Ribosome count less than 0." + transcript_name);
   }
@@ -62,11 +91,19 @@ void SpeciesTracker::IncrementRibo(const std::string &transcript_name,
 
 void SpeciesTracker::IncrementTranscript(const std::string &transcript_name,
                                          int copy_number) {
+  if (Defer(&SpeciesTracker::IncrementTranscript, this, transcript_name,
+            copy_number)) {
+    return;
+  }
+  auto averages = clock_ ? &Averages(transcript_name) : nullptr;
   if (transcripts_.count(transcript_name) == 0) {
     transcripts_[transcript_name] = copy_number;
   } else {
     transcripts_[transcript_name] += copy_number;
   }
+  if (averages) {
+    UpdateAverages(transcript_name, *averages);
+  }
   if (transcripts_[transcript_name] < 0) {
     throw std::runtime_error("Transcript count less than 0." + transcript_name);
   }
@@ -107,9 +144,41 @@ void SpeciesTracker::Remove(const std::string &promoter_name,
   }
 }
 
+void SpeciesTracker::Remove(const std::string &species_name,
+                            Reaction::Ptr reaction) {
+  if (species_map_.count(species_name) != 0) {
+    auto &reactions = species_map_[species_name];
+    reactions.erase(std::remove(reactions.begin(), reactions.end(), reaction),
+                    reactions.end());
+    if (reactions.empty()) {
+      species_map_.erase(species_name);
+    }
+  }
+}
+
+bool SpeciesTracker::RemoveSpecies(const std::string &species_name) {
+  if (species_map_.count(species_name) != 0 ||
+      pinned_.count(species_name) != 0) {
+    return false;
+  }
+  if (species_.erase(species_name) == 0) {
+    return false;
+  }
+  species_version_++;
+  return true;
+}
+
+void SpeciesTracker::Pin(const std::string &species_name) {
+  pinned_.insert(species_name);
+}
+
 void SpeciesTracker::TerminateTranscription(
     std::shared_ptr<PolymerWrapper> wrapper, const std::string &pol_name,
     const std::string &gene_name) {
+  if (Defer(&SpeciesTracker::TerminateTranscription, this, wrapper, pol_name,
+            gene_name)) {
+    return;
+  }
   Increment(pol_name, 1);
   propensity_signal_.Emit(wrapper);
   // CountTermination("transcript");
@@ -118,6 +187,10 @@ void SpeciesTracker::TerminateTranscription(
 void SpeciesTracker::TerminateTranslation(
     std::shared_ptr<PolymerWrapper> wrapper, const std::string &pol_name,
     const std::string &gene_name) {
+  if (Defer(&SpeciesTracker::TerminateTranslation, this, wrapper, pol_name,
+            gene_name)) {
+    return;
+  }
   Increment(pol_name, 1);
   Increment(gene_name, 1);
   IncrementRibo(gene_name, -1);
@@ -141,6 +214,15 @@ const Polymer::VecPtr &SpeciesTracker::FindPolymers(
   return promoter_map_[promoter_name];
 }
 
+const int *SpeciesTracker::FindSpecies(const std::string &species_name) {
+  auto it = species_.find(species_name);
+  if (it == species_.end()) {
+    it = species_.emplace(species_name, 0).first;
+    species_version_++;
+  }
+  return &it->second;
+}
+
 int SpeciesTracker::species(const std::string &reactant) {
   if (species_.count(reactant) == 0) {
     throw std::runtime_error("Species not found in tracker.");
@@ -186,4 +268,106 @@ const std::string SpeciesTracker::GatherCounts(double time_stamp) {
                                std::to_string(row.second[2]) + "\n");
   }
   return out_string;
-}
\ No newline at end of file
+}
+
+void SpeciesTracker::TrackAverages(const double *clock) {
+  clock_ = clock;
+  interval_start_ = *clock;
+  averages_.clear();
+}
+
+std::array<double, 3> SpeciesTracker::Counts(const std::string &name) {
+  std::array<double, 3> counts = {{0, 0, 0}};
+  auto species = species_.find(name);
+  if (species != species_.end()) {
+    counts[0] = species->second;
+  }
+  auto transcripts = transcripts_.find(name);
+  if (transcripts != transcripts_.end()) {
+    counts[1] = transcripts->second;
+  }
+  // Unlike GatherCounts(), count the density as 0 while there are no
+  // transcripts, so that averages stay finite
+  auto ribosomes = ribo_per_transcript_.find(name);
+  if (ribosomes != ribo_per_transcript_.end() && counts[1] > 0) {
+    counts[2] = ribosomes->second / counts[1];
+  }
+  return counts;
+}
+
+std::array<SpeciesTracker::TimeAverage, 3> &SpeciesTracker::Averages(
+    const std::string &name) {
+  auto it = averages_.find(name);
+  if (it == averages_.end()) {
+    // Unchanged since the interval started
+    auto counts = Counts(name);
+    std::array<TimeAverage, 3> averages;
+    for (int i = 0; i < 3; i++) {
+      averages[i] =
+          TimeAverage{counts[i], interval_start_, 0, counts[i], counts[i]};
+    }
+    it = averages_.emplace(name, averages).first;
+  }
+  double now = *clock_;
+  for (auto &average : it->second) {
+    average.area += average.value * (now - average.since);
+    average.since = now;
+  }
+  return it->second;
+}
+
+void SpeciesTracker::UpdateAverages(const std::string &name,
+                                    std::array<TimeAverage, 3> &averages) {
+  auto counts = Counts(name);
+  for (int i = 0; i < 3; i++) {
+    averages[i].value = counts[i];
+    averages[i].min = std::min(averages[i].min, counts[i]);
+    averages[i].max = std::max(averages[i].max, counts[i]);
+  }
+}
+
+const std::string SpeciesTracker::GatherAverages(double time_stamp,
+                                                 bool extremes) {
+  // Same rows as GatherCounts()
+  std::set<std::string> names;
+  for (const auto &elem : species_) {
+    names.insert(elem.first);
+  }
+  for (const auto &transcript : transcripts_) {
+    names.insert(transcript.first);
+  }
+  double length = time_stamp - interval_start_;
+  std::string out_string;
+  for (const auto &name : names) {
+    std::array<double, 3> means;
+    std::array<double, 3> mins;
+    std::array<double, 3> maxs;
+    auto it = averages_.find(name);
+    if (it == averages_.end()) {
+      means = mins = maxs = Counts(name);
+    } else {
+      for (int i = 0; i < 3; i++) {
+        const auto &average = it->second[i];
+        double area =
+            average.area + average.value * (time_stamp - average.since);
+        means[i] = length > 0 ? area / length : average.value;
+        mins[i] = average.min;
+        maxs[i] = average.max;
+      }
+    }
+    out_string += std::to_string(time_stamp) + "\t" + name;
+    for (int i = 0; i < 3; i++) {
+      out_string += "\t" + std::to_string(means[i]);
+    }
+    if (extremes) {
+      for (int i = 0; i < 3; i++) {
+        out_string +=
+            "\t" + std::to_string(mins[i]) + "\t" + std::to_string(maxs[i]);
+      }
+    }
+    out_string += "\n";
+  }
+  averages_.clear();
+  interval_start_ = time_stamp;
+  return out_string;
+}
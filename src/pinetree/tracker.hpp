@@ -3,9 +3,13 @@
 #ifndef SRC_TRACKER_HPP  // header guard
 #define SRC_TRACKER_HPP
 
+#include <array>
 #include <memory>
+#include <set>
 
+#include "journal.hpp"
 #include "model.hpp"
+#include "observer.hpp"
 
 /**
  * Tracks species' copy numbers and maintains promoter-to-polymer and species-
@@ -79,6 +83,35 @@ class SpeciesTracker {
    * @param polymer polymer object that contains the named promoter (pointer)
    */
   void Remove(const std::string &promoter_name, Polymer::Ptr polymer);
+  /**
+   * Remove a species-reaction pair from species-reaction map.
+   *
+   * @param species_name name of species
+   * @param reaction reaction object (pointer) that involves species
+   */
+  void Remove(const std::string &species_name, Reaction::Ptr reaction);
+  /**
+   * Stop tracking a species if it is not involved in any reaction. Pointers
+   * returned by FindSpecies() for this species become invalid.
+   *
+   * @param species_name name of species
+   *
+   * @return true if the species was removed
+   */
+  bool RemoveSpecies(const std::string &species_name);
+  /**
+   * Keep tracking a species even if it is not involved in any reaction, e.g.
+   * because a pointer to its count was handed out. RemoveSpecies() leaves
+   * pinned species alone.
+   *
+   * @param species_name name of species
+   */
+  void Pin(const std::string &species_name);
+  /**
+   * Changes whenever a species is added or removed, so that callers can
+   * cache lists of species names.
+   */
+  long species_version() const { return species_version_; }
   /**
    * Update propensities and species counts after transcription has
    * terminated.
@@ -117,7 +150,40 @@ class SpeciesTracker {
    * @return vector of pointers to Reaction objects that involve species_name
    */
   const Reaction::VecPtr &FindReactions(const std::string &species_name);
+  /**
+   * Get a pointer to the copy number of a species, adding the species with a
+   * count of 0 if it is not yet tracked (e.g. a protein that has not been
+   * synthesized). The pointer remains valid until the tracker is cleared, so
+   * it can be read repeatedly without a name lookup.
+   *
+   * @param species_name name of species
+   *
+   * @return pointer to the copy number of species_name
+   */
+  const int *FindSpecies(const std::string &species_name);
   const std::string GatherCounts(double time_stamp);
+  /**
+   * Accumulate the time-weighted average, minimum and maximum of every count
+   * from now on, updated whenever a count changes (see
+   * Model::EnableTimeAverages()).
+   *
+   * @param clock current simulated time
+   */
+  void TrackAverages(const double *clock);
+  /**
+   * Like GatherCounts(), but with the time-weighted average of each count
+   * over the interval since the previous call (or since TrackAverages()).
+   * Starts the next interval.
+   *
+   * @param time_stamp current simulated time
+   * @param extremes add the minimum and maximum of each count
+   */
+  const std::string GatherAverages(double time_stamp, bool extremes);
+  /**
+   * Get a new id for a polymer or mobile element. Ids are unique until the
+   * tracker is cleared.
+   */
+  int NextId() { return next_id_++; }
   /**
    * Getters and setters
    */
@@ -133,6 +199,14 @@ class SpeciesTracker {
    * Signal to fire when propensity needs to be updated.
    */
   Signal<std::shared_ptr<Reaction>> propensity_signal_;
+  /**
+   * Record of changes for incremental stepping.
+   */
+  ChangeJournal journal_;
+  /**
+   * Observers registered with Model::AddObserver().
+   */
+  ObserverList observers_;
 
  private:
   /**
@@ -159,6 +233,47 @@ class SpeciesTracker {
    * Species-to-reaction map.
    */
   std::map<std::string, Reaction::VecPtr> species_map_;
+  /**
+   * Species that RemoveSpecies() must not remove, and the version of the
+   * set of species names.
+   */
+  std::set<std::string> pinned_;
+  long species_version_ = 1;
+  /**
+   * Next id returned by NextId().
+   */
+  int next_id_ = 1;
+  /**
+   * Integral of a count over the current sampling interval up to `since`,
+   * with its value since then and its extremes in the interval.
+   */
+  struct TimeAverage {
+    double value;
+    double since;
+    double area;
+    double min;
+    double max;
+  };
+  /**
+   * Species count, transcript count and ribosome density of a name, as
+   * written by GatherCounts().
+   */
+  std::array<double, 3> Counts(const std::string &name);
+  /**
+   * Averages of each name whose counts changed in the current interval,
+   * integrated up to the current time. Call before changing a count, and
+   * UpdateAverages() after.
+   */
+  std::array<TimeAverage, 3> &Averages(const std::string &name);
+  void UpdateAverages(const std::string &name,
+                      std::array<TimeAverage, 3> &averages);
+  std::map<std::string, std::array<TimeAverage, 3>> averages_;
+  /**
+   * Simulated time, if averages are tracked, and start of the current
+   * interval.
+   */
+  const double *clock_ = nullptr;
+  double interval_start_ = 0;
 };
 
 #endif  // header guard
\ No newline at end of file
@@ -0,0 +1,187 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+
+#include "equivalence.hpp"
+#include "model_file.hpp"
+#include "tracker.hpp"
+
+double KolmogorovSmirnov(std::vector<double> a, std::vector<double> b) {
+  if (a.empty() || b.empty()) {
+    return 0.0;
+  }
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  double distance = 0.0;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    // Step past every copy of the smallest remaining value in both samples
+    double value = std::min(a[i], b[j]);
+    while (i < a.size() && a[i] == value) i++;
+    while (j < b.size() && b[j] == value) j++;
+    distance = std::max(distance, std::abs(double(i) / a.size() -
+                                           double(j) / b.size()));
+  }
+  return distance;
+}
+
+double KolmogorovSmirnovPValue(double statistic, int n, int m) {
+  if (statistic <= 0.0) {
+    return 1.0;
+  }
+  double en = std::sqrt(double(n) * m / (n + m));
+  double lambda = (en + 0.12 + 0.11 / en) * statistic;
+  // Kolmogorov distribution: Q(lambda) = 2 sum (-1)^(k-1) exp(-2 k^2 lambda^2)
+  double sum = 0.0;
+  double sign = 1.0;
+  for (int k = 1; k <= 100; k++) {
+    double term = sign * std::exp(-2.0 * k * k * lambda * lambda);
+    sum += term;
+    if (std::abs(term) < 1e-10 * std::abs(sum)) {
+      return std::min(1.0, std::max(0.0, 2.0 * sum));
+    }
+    sign = -sign;
+  }
+  // Series has not converged; lambda is very small
+  return 1.0;
+}
+
+std::vector<bool> HolmReject(const std::vector<double> &p_values,
+                             double alpha) {
+  std::vector<size_t> order(p_values.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&p_values](size_t a, size_t b) {
+    return p_values[a] < p_values[b];
+  });
+  std::vector<bool> rejected(p_values.size(), false);
+  for (size_t k = 0; k < order.size(); k++) {
+    if (p_values[order[k]] > alpha / (order.size() - k)) {
+      break;
+    }
+    rejected[order[k]] = true;
+  }
+  return rejected;
+}
+
+bool EquivalenceReport::Equivalent() const {
+  for (const auto &test : tests) {
+    if (test.rejected) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string EquivalenceReport::Summary(int max_lines) const {
+  std::vector<const EquivalenceTest *> sorted;
+  for (const auto &test : tests) {
+    sorted.push_back(&test);
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [](const EquivalenceTest *a, const EquivalenceTest *b) {
+                     return a->p_value < b->p_value;
+                   });
+  std::ostringstream out;
+  out << tests.size() << " comparisons, "
+      << (Equivalent() ? "none" : "some") << " significant\n";
+  for (int i = 0; i < max_lines && i < int(sorted.size()); i++) {
+    const auto &test = *sorted[i];
+    if (!Equivalent() && !test.rejected) {
+      break;
+    }
+    out << (test.rejected ? "  DIVERGENT " : "  ") << test.model
+        << " t=" << test.time << " " << test.observable
+        << ": mean " << test.reference_mean << " vs " << test.candidate_mean
+        << ", D=" << test.statistic << ", p=" << test.p_value << "\n";
+  }
+  return out.str();
+}
+
+void EquivalenceHarness::AddModel(const std::string &name,
+                                  const Builder &builder,
+                                  const std::vector<double> &times) {
+  cases_.push_back(Case{name, builder, times});
+}
+
+void EquivalenceHarness::AddModelFile(const std::string &path,
+                                      const std::vector<double> &times) {
+  auto model_file = std::make_shared<ModelFile>(ModelFile::FromFile(path));
+  auto name = path.substr(path.find_last_of("/\\") + 1);
+  AddModel(name, [model_file]() { return model_file->Build(); }, times);
+}
+
+EquivalenceHarness::Samples EquivalenceHarness::Observe(
+    const Case &model, const Configuration &config, int first_seed) const {
+  Samples samples(model.times.size());
+  for (int replicate = 0; replicate < replicates_; replicate++) {
+    auto sim = model.builder();
+    sim->seed(first_seed + replicate);
+    config(*sim);
+    auto &tracker = SpeciesTracker::Instance();
+    for (size_t t = 0; t < model.times.size(); t++) {
+      sim->StepUntil(model.times[t]);
+      auto &sample = samples[t];
+      for (const auto &species : tracker.species()) {
+        sample[species.first].resize(replicates_, 0.0);
+        sample[species.first][replicate] = species.second;
+      }
+      for (const auto &transcript : tracker.transcripts()) {
+        auto name = "transcript " + transcript.first;
+        sample[name].resize(replicates_, 0.0);
+        sample[name][replicate] = transcript.second;
+      }
+    }
+  }
+  return samples;
+}
+
+EquivalenceReport EquivalenceHarness::Compare(
+    const Configuration &reference, const Configuration &candidate) const {
+  EquivalenceReport report;
+  for (const auto &model : cases_) {
+    // Independent seeds for the two samples
+    auto ref_samples = Observe(model, reference, 1);
+    auto cand_samples = Observe(model, candidate, 1 + replicates_);
+    for (size_t t = 0; t < model.times.size(); t++) {
+      // Observables missing from one configuration are zero in all replicates
+      auto &ref = ref_samples[t];
+      auto &cand = cand_samples[t];
+      for (const auto &elem : ref) {
+        cand[elem.first].resize(replicates_, 0.0);
+      }
+      for (const auto &elem : cand) {
+        ref[elem.first].resize(replicates_, 0.0);
+      }
+      for (const auto &elem : ref) {
+        const auto &a = elem.second;
+        const auto &b = cand[elem.first];
+        EquivalenceTest test;
+        test.model = model.name;
+        test.time = model.times[t];
+        test.observable = elem.first;
+        test.reference_mean =
+            std::accumulate(a.begin(), a.end(), 0.0) / a.size();
+        test.candidate_mean =
+            std::accumulate(b.begin(), b.end(), 0.0) / b.size();
+        test.statistic = KolmogorovSmirnov(a, b);
+        test.p_value =
+            KolmogorovSmirnovPValue(test.statistic, a.size(), b.size());
+        test.rejected = false;
+        report.tests.push_back(test);
+      }
+    }
+  }
+  std::vector<double> p_values;
+  for (const auto &test : report.tests) {
+    p_values.push_back(test.p_value);
+  }
+  auto rejected = HolmReject(p_values, alpha_);
+  for (size_t i = 0; i < rejected.size(); i++) {
+    report.tests[i].rejected = rejected[i];
+  }
+  return report;
+}
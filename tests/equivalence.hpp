@@ -0,0 +1,136 @@
+/* Copyright (c) 2017 Benjamin Jack All Rights Reserved. */
+
+#ifndef TESTS_EQUIVALENCE_HPP  // header guard
+#define TESTS_EQUIVALENCE_HPP
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.hpp"
+
+/**
+ * Two-sample Kolmogorov-Smirnov statistic: the largest distance between the
+ * empirical distribution functions of two samples. Ties are handled exactly,
+ * so the statistic is valid for discrete data such as copy numbers.
+ */
+double KolmogorovSmirnov(std::vector<double> a, std::vector<double> b);
+
+/**
+ * Asymptotic p-value of a two-sample Kolmogorov-Smirnov statistic, with the
+ * small-sample correction of Stephens (1970). The test is conservative for
+ * discrete data.
+ *
+ * @param statistic value returned by KolmogorovSmirnov()
+ * @param n size of first sample
+ * @param m size of second sample
+ */
+double KolmogorovSmirnovPValue(double statistic, int n, int m);
+
+/**
+ * Holm-Bonferroni step-down procedure. Controls the family-wise error rate
+ * at `alpha` for any dependence between the tests.
+ *
+ * @return true for each hypothesis that is rejected
+ */
+std::vector<bool> HolmReject(const std::vector<double> &p_values,
+                             double alpha);
+
+/**
+ * Result of comparing one observable at one time point.
+ */
+struct EquivalenceTest {
+  std::string model;
+  double time;
+  std::string observable;
+  double reference_mean;
+  double candidate_mean;
+  double statistic;
+  double p_value;
+  bool rejected;
+};
+
+/**
+ * Results of all comparisons made by EquivalenceHarness::Compare().
+ */
+struct EquivalenceReport {
+  std::vector<EquivalenceTest> tests;
+  /**
+   * True if no comparison was significant after correction.
+   */
+  bool Equivalent() const;
+  /**
+   * Human-readable list of the rejected comparisons (or, if there are none,
+   * of the smallest p-values).
+   */
+  std::string Summary(int max_lines = 10) const;
+};
+
+/**
+ * Checks that a candidate configuration of the simulator (an alternative
+ * engine, an optimization switched on, ...) produces the same distribution
+ * of copy numbers as a reference configuration.
+ *
+ * Every model is simulated `replicates` times with each configuration, with
+ * different seeds, and the copy numbers of every species and transcript are
+ * recorded at fixed times. Each observable at each time is compared with a
+ * two-sample Kolmogorov-Smirnov test, and the p-values of all comparisons
+ * are corrected together with the Holm-Bonferroni procedure.
+ */
+class EquivalenceHarness {
+ public:
+  /**
+   * Builds an unconfigured model for one replicate.
+   */
+  typedef std::function<std::shared_ptr<Model>()> Builder;
+  /**
+   * Applies a configuration to a freshly built model before it is simulated.
+   */
+  typedef std::function<void(Model &)> Configuration;
+
+  /**
+   * @param replicates number of simulations per model and configuration
+   * @param alpha family-wise error rate
+   */
+  EquivalenceHarness(int replicates, double alpha = 0.01)
+      : replicates_(replicates), alpha_(alpha) {}
+  /**
+   * Add a model to the comparison.
+   *
+   * @param name name of model, used in reports
+   * @param builder function that builds the model
+   * @param times simulated times at which copy numbers are compared
+   */
+  void AddModel(const std::string &name, const Builder &builder,
+                const std::vector<double> &times);
+  /**
+   * Add a model file to the comparison.
+   */
+  void AddModelFile(const std::string &path, const std::vector<double> &times);
+  /**
+   * Simulate every model with both configurations and compare the results.
+   */
+  EquivalenceReport Compare(const Configuration &reference,
+                            const Configuration &candidate) const;
+
+ private:
+  /**
+   * Copy numbers at each time: samples[time index][observable] has one value
+   * per replicate.
+   */
+  typedef std::vector<std::map<std::string, std::vector<double>>> Samples;
+  struct Case {
+    std::string name;
+    Builder builder;
+    std::vector<double> times;
+  };
+  int replicates_;
+  double alpha_;
+  std::vector<Case> cases_;
+  Samples Observe(const Case &model, const Configuration &config,
+                  int first_seed) const;
+};
+
+#endif  // header guard
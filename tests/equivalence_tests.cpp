@@ -0,0 +1,183 @@
+#include <string>
+
+#include "./lib/catch.hpp"
+#include "equivalence.hpp"
+#include "generator.hpp"
+
+namespace {
+
+// Replicates per configuration; enough to detect large changes in the mean or
+// spread of a count while keeping the test target fast in debug builds
+const int kReplicates = 30;
+
+GeneratorConfig SmallConfig() {
+  GeneratorConfig config;
+  config.genome_length = 1000;
+  config.num_genes = 5;
+  config.num_transcripts = 2;
+  config.transcript_length = 300;
+  config.ribosome_copies = 50;
+  return config;
+}
+
+/**
+ * Bundled models, with sample times chosen so that each replicate executes
+ * at most a few thousand reactions. Alternative engines and optimizations
+ * are checked by comparing their configuration against Unchanged() on these
+ * models.
+ */
+EquivalenceHarness BundledModels() {
+  EquivalenceHarness harness(kReplicates);
+  const std::string dir = PINETREE_MODEL_DIR "/";
+  for (const auto &name :
+       {"consecutive_promoters", "dual_promoter", "genome_entry",
+        "overlapping_genes", "readthrough", "three_genes",
+        "three_genes_recoded", "three_genes_runoff"}) {
+    harness.AddModelFile(dir + name + ".yml", {2, 4});
+  }
+  harness.AddModelFile(dir + "dual_polymerases.yml", {8, 10});
+  harness.AddModelFile(dir + "promoter_gene_overlap.yml", {8, 10});
+  harness.AddModelFile(dir + "single_gene.yml", {20, 40});
+  harness.AddModelFile(dir + "lotka_voltera.yml", {0.01, 0.02});
+  auto config = SmallConfig();
+  config.num_rnase_sites = 2;
+  harness.AddModel("synthetic", [config]() { return GenerateModel(config); },
+                   {4, 8});
+  return harness;
+}
+
+void Unchanged(Model &) {}
+
+}  // namespace
+
+TEST_CASE("Two-sample Kolmogorov-Smirnov test")
+{
+    REQUIRE(KolmogorovSmirnov({1, 2, 3}, {3, 2, 1}) == 0.0);
+    REQUIRE(KolmogorovSmirnovPValue(0.0, 3, 3) == 1.0);
+    // Ties within and between samples
+    REQUIRE(KolmogorovSmirnov({1, 1, 2, 2}, {2, 2, 2, 2}) == Approx(0.5));
+    REQUIRE(KolmogorovSmirnov({0, 0, 0}, {5, 6, 7}) == 1.0);
+
+    // Kolmogorov distribution at lambda = (sqrt(15) + 0.12 + 0.11 / sqrt(15)) D
+    REQUIRE(KolmogorovSmirnovPValue(0.5, 30, 30) ==
+            Approx(0.000616).epsilon(0.01));
+    REQUIRE(KolmogorovSmirnovPValue(0.2, 30, 30) ==
+            Approx(0.5372).epsilon(0.01));
+
+    auto rejected = HolmReject({0.001, 0.04, 0.012, 0.5}, 0.05);
+    REQUIRE(rejected == std::vector<bool>({true, false, true, false}));
+    REQUIRE(HolmReject({0.03, 0.04}, 0.05) ==
+            std::vector<bool>({false, false}));
+}
+
+TEST_CASE("Bundled models give equivalent dynamics across seeds")
+{
+    // The reference engine compared against itself with different seeds is
+    // the null case that candidate configurations must also pass.
+    auto report = BundledModels().Compare(Unchanged, Unchanged);
+    INFO(report.Summary());
+    REQUIRE(report.tests.size() > 100);
+    REQUIRE(report.Equivalent());
+}
+
+TEST_CASE("Equivalence harness detects divergent dynamics")
+{
+    auto config = SmallConfig();
+    EquivalenceHarness harness(kReplicates);
+    harness.AddModel("synthetic", [config]() { return GenerateModel(config); },
+                     {4, 8});
+    // A candidate that degrades one protein
+    auto report = harness.Compare(Unchanged, [](Model &model) {
+        model.AddReaction(0.5, {"tx_gene1"}, {});
+    });
+    INFO(report.Summary());
+    REQUIRE_FALSE(report.Equivalent());
+}
+
+TEST_CASE("Pruning does not change dynamics")
+{
+    auto report = BundledModels().Compare(
+        Unchanged, [](Model &model) { model.EnablePruning(); });
+    INFO(report.Summary());
+    REQUIRE(report.Equivalent());
+}
+
+TEST_CASE("Rejection-based SSA matches exact dynamics")
+{
+    auto report = BundledModels().Compare(
+        Unchanged, [](Model &model) { model.EnableRejectionSampling(0.1); });
+    INFO(report.Summary());
+    REQUIRE(report.Equivalent());
+}
+
+TEST_CASE("Parallel mode matches exact dynamics")
+{
+    // Windows are short compared with the time a polymerase takes to
+    // transcribe a gene
+    auto report = BundledModels().Compare(
+        Unchanged, [](Model &model) { model.EnableParallel(4, 0.05); });
+    INFO(report.Summary());
+    REQUIRE(report.Equivalent());
+}
+
+TEST_CASE("Translation engine matches exact dynamics")
+{
+    // The fixed transcript example, and several transcripts with codon
+    // weights that share ribosomes
+    EquivalenceHarness harness(kReplicates);
+    harness.AddModel("fixed_transcript", []() {
+        auto model = std::make_shared<Model>(8e-16);
+        model->AddRibosome(10, 30, 100);
+        auto transcript = std::make_shared<Transcript>("transcript", 605);
+        transcript->AddGene("rnapol", 26, 225, 11, 26, 1e7);
+        transcript->AddGene("proteinX", 241, 280, 226, 241, 1e7);
+        transcript->AddGene("proteinY", 296, 595, 281, 296, 1e7);
+        model->RegisterTranscript(transcript);
+        return model;
+    }, {5, 10});
+    harness.AddModel("weighted_transcripts", []() {
+        auto model = std::make_shared<Model>(8e-16);
+        model->AddRibosome(10, 30, 20);
+        std::vector<double> weights(300, 1.0);
+        for (int i = 100; i < 150; i++) {
+            weights[i] = 0.1;
+        }
+        for (int i = 0; i < 3; i++) {
+            auto transcript = std::make_shared<Transcript>("transcript", 300);
+            transcript->AddGene("geneA", 31, 150, 16, 31, 1e7);
+            transcript->AddGene("geneB", 161, 290, 146, 161, 5e6);
+            transcript->AddWeights(weights);
+            model->RegisterTranscript(transcript);
+        }
+        model->AddReaction(0.1, {"geneA"}, {});
+        return model;
+    }, {10, 20});
+    auto report = harness.Compare(
+        Unchanged, [](Model &model) { model.EnableTranslationEngine(); });
+    INFO(report.Summary());
+    REQUIRE(report.Equivalent());
+}
+
+TEST_CASE("Slow-scale SSA matches exact dynamics")
+{
+    // Repressor binding is about 40 times faster than anything else that
+    // involves the repressor or its operators
+    EquivalenceHarness harness(kReplicates);
+    harness.AddModel("repressor", []() {
+        auto model = std::make_shared<Model>(8e-16);
+        model->AddSpecies("R", 20);
+        model->AddSpecies("O", 5);
+        model->AddReaction(8e9, {"R", "O"}, {"RO"});
+        model->AddReaction(100.0, {"RO"}, {"R", "O"});
+        model->AddReaction(1.0, {"O"}, {"O", "P"});
+        model->AddReaction(0.05, {"P"}, {});
+        model->AddReaction(0.2, {"R"}, {});
+        model->AddReaction(4.0, {}, {"R"});
+        return model;
+    }, {5, 10});
+    auto report = harness.Compare(
+        Unchanged, [](Model &model) { model.EnableSlowScale(20); });
+    INFO(report.Summary());
+    REQUIRE(report.tests.size() == 8);
+    REQUIRE(report.Equivalent());
+}
@@ -4,6 +4,8 @@ import subprocess
 import tempfile
 import importlib
 
+import pinetree as pt
+
 
 class MainTest(unittest.TestCase):
 
@@ -26,6 +28,51 @@ class MainTest(unittest.TestCase):
     def test_single_gene(self):
         self.run_test('single_gene')
 
+    def build_single_gene(self):
+        sim = pt.Model(cell_volume=8e-16)
+        sim.seed(34)
+        sim.add_polymerase(name="rnapol", copy_number=1, speed=40,
+                           footprint=10)
+        sim.add_ribosome(copy_number=1, speed=30, footprint=10)
+        plasmid = pt.Genome(name="T7", length=605)
+        plasmid.add_promoter(name="phi1", start=1, stop=10,
+                             interactions={"rnapol": 2e8})
+        plasmid.add_terminator(name="t1", start=604, stop=605,
+                               efficiency={"rnapol": 1.0})
+        plasmid.add_gene(name="proteinX", start=241, stop=280,
+                         rbs_start=(241 - 15), rbs_stop=241, rbs_strength=1e7)
+        sim.register_genome(plasmid)
+        return sim
+
+    def test_step_deltas(self):
+        # Applying deltas one second at a time reproduces a single long step
+        full = self.build_single_gene().step_until(30)
+        sim = self.build_single_gene()
+        species = {}
+        polymerases = {}
+        transcripts = set()
+        for t in range(1, 31):
+            delta = sim.step_until(t)
+            self.assertGreaterEqual(delta.time, t)
+            species.update(delta.species)
+            for pol in delta.polymerases:
+                if pol.released:
+                    polymerases.pop(pol.id, None)
+                else:
+                    polymerases[pol.id] = pol
+            for transcript in delta.transcripts_created:
+                self.assertNotIn(transcript.id, transcripts)
+                transcripts.add(transcript.id)
+        self.assertEqual(sim.time, full.time)
+        self.assertEqual(species, full.species)
+        self.assertGreater(species["proteinX"], 0)
+        self.assertGreater(len(transcripts), 0)
+        # Bound ribosomes and polymerases match the free counts
+        ribosomes = [p for p in polymerases.values() if p.name == "__ribosome"]
+        self.assertEqual(len(ribosomes) + species["__ribosome"], 1)
+        for pol in polymerases.values():
+            self.assertLessEqual(pol.start, pol.stop)
+
     # def test_three_genes(self):
     #     self.run_test('three_genes')
 
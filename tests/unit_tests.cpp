@@ -1,8 +1,26 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
 #include "./lib/catch.hpp"
 #include "choices.hpp"
 #include "feature.hpp"
+#include "genbank.hpp"
+#include "generator.hpp"
 #include "model.hpp"
+#include "model_file.hpp"
+#include "observer.hpp"
+#include "pinetree.h"
 #include "polymer.hpp"
+#include "rate_law.hpp"
 #include "reaction.hpp"
 #include "tracker.hpp"
 
@@ -131,3 +149,1442 @@ TEST_CASE("Attach a polymerase to a registered genome")
     CHECK(plasmid->num_attached() == 1);
     REQUIRE(plasmid->attached_pol_start(0) == promoter_start);
 }
+
+TEST_CASE("Load a model file")
+{
+    std::stringstream text(
+        "simulation:\n"
+        "    seed: 34\n"
+        "    runtime: 60.0  # seconds\n"
+        "    time_step: 1\n"
+        "    cell_volume: 8e-16\n"
+        "genome:\n"
+        "    name: T7\n"
+        "    copy_number: 2\n"
+        "    translation_weights: [1.0, 1.0,\n"
+        "        1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0]\n"
+        "polymerases:\n"
+        "- name: rnapol\n"
+        "  copy_number: 10\n"
+        "  speed: 40\n"
+        "  footprint: 2\n"
+        "ribosomes:\n"
+        "- name: ribosome\n"
+        "  copy_number: 100\n"
+        "  speed: 30\n"
+        "  footprint: 2\n"
+        "  binding_constant: 1e7\n"
+        "elements:\n"
+        "- type: promoter\n"
+        "  name: phi1\n"
+        "  start: 1\n"
+        "  stop: 2\n"
+        "  interactions:\n"
+        "      rnapol:\n"
+        "          binding_constant: 2e8\n"
+        "- type: transcript\n"
+        "  name: proteinX\n"
+        "  start: 5\n"
+        "  stop: 8\n"
+        "  rbs: -2\n"
+        "- type: terminator\n"
+        "  name: t1\n"
+        "  start: 9\n"
+        "  stop: 10\n"
+        "  interactions:\n"
+        "    rnapol:\n"
+        "        efficiency: 1.0\n");
+    ModelFile model_file(text);
+
+    // Simulation parameters
+    REQUIRE(model_file.simulation().seed == 34);
+    REQUIRE(model_file.simulation().runtime == 60);
+    REQUIRE(model_file.simulation().cell_volume == 8e-16);
+
+    // Sections are parsed in file order
+    const auto &root = model_file.root();
+    REQUIRE(root.Find("genome")->Find("translation_weights")->items.size() ==
+            10);
+    const auto &elements = root.Require("elements", "model");
+    REQUIRE(elements.items.size() == 3);
+    CHECK(elements.items[0].Require("interactions", "phi1")
+              .Require("rnapol", "phi1")
+              .Require("binding_constant", "phi1")
+              .AsDouble() == 2e8);
+    CHECK(elements.items[1].Require("rbs", "proteinX").AsInt() == -2);
+
+    // Two copies of the genome are constructed
+    auto model = model_file.Build();
+    REQUIRE(model->genome_copies("T7") == 2);
+    auto &tracker = SpeciesTracker::Instance();
+    REQUIRE(tracker.species("rnapol") == 10);
+    REQUIRE(tracker.species("__ribosome") == 100);
+    REQUIRE(tracker.species("phi1") == 2);
+
+    // The RBS of proteinX starts `rbs` positions upstream of the gene and
+    // ends at its start
+    model->StepUntil(60);
+    auto state = model->ExportState();
+    int rbs_sites = 0;
+    int misplaced = 0;
+    for (const auto &site : state.sites) {
+        if (state.names[site.name] == "__proteinX_rbs") {
+            rbs_sites++;
+            misplaced += site.start != 3 || site.stop != 5;
+        }
+    }
+    REQUIRE(rbs_sites > 0);
+    REQUIRE(misplaced == 0);
+
+    // Missing required fields are reported
+    std::stringstream bad("simulation:\n    seed: 1\n");
+    REQUIRE_THROWS_AS(ModelFile(bad), std::invalid_argument);
+}
+
+TEST_CASE("Build a genome from a GenBank record")
+{
+    std::stringstream text(
+        "LOCUS       TEST                      60 bp    DNA     linear\n"
+        "FEATURES             Location/Qualifiers\n"
+        "     regulatory      12\n"
+        "                     /regulatory_class=\"promoter\"\n"
+        "                     /note=\"strong\n"
+        "                     promoter\"\n"
+        "     gene            16..27\n"
+        "                     /note=\"gene A\"\n"
+        "     CDS             16..27\n"
+        "                     /note=\"gene A\"\n"
+        "                     /translation=\"MKA\"\n"
+        "     gene            complement(30..40)\n"
+        "                     /note=\"gene B\"\n"
+        "     regulatory      45..50\n"
+        "                     /regulatory_class=\"terminator\"\n"
+        "                     /note=\"term\"\n"
+        "ORIGIN      \n"
+        "        1 aaaaaaaaaa aaaaaatgaa agcctaaaaa aaaaaaaaaa aaaaaaaaaa\n"
+        "       51 aaaaaaaaaa\n"
+        "//\n");
+    auto record = GenbankRecord::Read(text);
+    REQUIRE(record.name == "TEST");
+    REQUIRE(record.length() == 60);
+    REQUIRE(record.features.size() == 5);
+    CHECK(*record.features[0].Qualifier("note") == "strong promoter");
+    CHECK(record.features[1].start == 16);
+    CHECK(record.features[1].stop == 27);
+    CHECK(record.features[3].complement);
+
+    GenbankRules rules;
+    rules.rename = {{"gene A", "proteinA"}};
+    rules.classes = {{"strong promoter", "strong"}};
+    rules.promoter_interactions = {{"strong", {{"rnapol", 2e8}}}};
+    rules.rbs_length = 10;
+    rules.optimal_codons = {{'K', {"AAA"}}};
+    rules.optimal_codon_weight = 2.0;
+
+    // Unassigned terminators are an error unless a default is given
+    REQUIRE_THROWS_AS(BuildGenome(record, rules), std::invalid_argument);
+    rules.default_terminator_interactions = {{"rnapol", 1.0}};
+    auto genome = BuildGenome(record, rules, "test");
+
+    // Promoter and RBS of forward-strand gene, but not the reverse-strand gene
+    REQUIRE(genome->bindings().size() == 2);
+    REQUIRE(genome->bindings().count("strong promoter") == 1);
+    REQUIRE(genome->bindings().count("__proteinA_rbs") == 1);
+    REQUIRE(genome->GetBindingIntervals()[0].start == 1);
+    REQUIRE(genome->GetReleaseIntervals().size() == 1);
+
+    // Codon AAA for K is optimal; weights are normalized over the CDS
+    auto weights = CodonWeights(record, rules);
+    REQUIRE(weights.size() == 60);
+    CHECK(weights[0] == 1.0);
+    CHECK(weights[15] == Approx(0.75));
+    CHECK(weights[18] == Approx(1.5));
+    CHECK(weights[26] == 1.0);
+
+    // Short promoters start min_promoter_length positions further upstream,
+    // whatever their length
+    std::stringstream wide(
+        "LOCUS       WIDE                      60 bp    DNA     linear\n"
+        "FEATURES             Location/Qualifiers\n"
+        "     regulatory      30..35\n"
+        "                     /regulatory_class=\"promoter\"\n"
+        "                     /note=\"strong promoter\"\n"
+        "ORIGIN      \n"
+        "        1 aaaaaaaaaa aaaaaaaaaa aaaaaaaaaa aaaaaaaaaa aaaaaaaaaa\n"
+        "       51 aaaaaaaaaa\n"
+        "//\n");
+    rules.min_promoter_length = 10;
+    genome = BuildGenome(GenbankRecord::Read(wide), rules);
+    REQUIRE(genome->GetBindingIntervals().size() == 1);
+    REQUIRE(genome->GetBindingIntervals()[0].start == 20);
+    REQUIRE(genome->GetBindingIntervals()[0].stop == 35);
+}
+
+TEST_CASE("Step a model through the C interface")
+{
+    const char *rnapol[] = {"rnapol"};
+    const double strength[] = {2e8};
+    const double efficiency[] = {1.0};
+    pt_model *model = pt_model_new(8e-16);
+    pt_genome *plasmid = pt_genome_new("plasmid", 300);
+    REQUIRE(model != nullptr);
+    REQUIRE(plasmid != nullptr);
+    REQUIRE(pt_model_seed(model, 34) == 0);
+    REQUIRE(pt_model_add_polymerase(model, "rnapol", 10, 40, 10) == 0);
+    REQUIRE(pt_model_add_ribosome(model, 10, 30, 100) == 0);
+    REQUIRE(pt_genome_add_promoter(plasmid, "p1", 1, 10, rnapol, strength,
+                                   1) == 0);
+    REQUIRE(pt_genome_add_terminator(plasmid, "t1", 299, 300, rnapol,
+                                     efficiency, 1) == 0);
+    REQUIRE(pt_genome_add_gene(plasmid, "proteinX", 26, 225, 11, 26, 1e7) ==
+            0);
+    REQUIRE(pt_model_register_genome(model, plasmid) == 0);
+    pt_genome_free(plasmid);
+
+    // Errors are reported through return codes
+    REQUIRE(pt_model_add_species(model, "__reserved", 1) == -1);
+    REQUIRE(std::string(pt_last_error()).find("reserved") != std::string::npos);
+
+    int terminations = 0;
+    int id = pt_model_on_termination(
+        model,
+        [](void *data, const char *, const char *) { (*(int *)data)++; },
+        &terminations);
+    REQUIRE(id >= 0);
+    REQUIRE(pt_model_on_termination(model, nullptr, nullptr) == -1);
+    REQUIRE(std::string(pt_last_error()).find("NULL callback") !=
+            std::string::npos);
+
+    const int *protein = pt_model_species_handle(model, "proteinX");
+    REQUIRE(protein != nullptr);
+    REQUIRE(*protein == 0);
+    REQUIRE(pt_model_step(model, 10) == 0);
+    REQUIRE(pt_model_step_until(model, 30) == 0);
+    REQUIRE(pt_model_time(model) >= 30);
+    REQUIRE(*protein > 0);
+    REQUIRE(*protein == pt_model_species_count(model, "proteinX"));
+    REQUIRE(terminations > *protein);
+
+    int num_species = pt_model_num_species(model);
+    std::vector<int> counts(num_species);
+    REQUIRE(pt_model_counts(model, counts.data(), num_species) == num_species);
+    for (int i = 0; i < num_species; i++) {
+        REQUIRE(counts[i] ==
+                pt_model_species_count(model, pt_model_species_name(model, i)));
+    }
+    REQUIRE(pt_model_species_name(model, num_species) == nullptr);
+    pt_model_free(model);
+}
+
+TEST_CASE("Autocatalytic reactions")
+{
+    // A product that is also a reactant must not zero the reaction's
+    // propensity while the reaction is being added
+    auto sim = std::make_shared<Model>(1.6605390285703877e-24);
+    sim->seed(34);
+    sim->AddSpecies("X", 1000);
+    sim->AddSpecies("Y", 10);
+    sim->AddReaction(0.01, {"X", "Y"}, {"Y", "Y"});
+    sim->RegisterGenome(std::make_shared<Genome>("empty", 10));
+    REQUIRE_NOTHROW(sim->Step(500));
+    auto &tracker = SpeciesTracker::Instance();
+    REQUIRE(tracker.species("Y") == 510);
+    REQUIRE(tracker.species("X") + tracker.species("Y") == 1010);
+    REQUIRE(sim->stats().events == 500);
+}
+
+TEST_CASE("Generate a synthetic model")
+{
+    GeneratorConfig config;
+    config.seed = 7;
+    config.num_genomes = 2;
+    config.genome_length = 3000;
+    config.num_genes = 20;
+    config.num_promoters = 4;
+    config.promoter_strength_sigma = 1.0;
+    config.num_rnase_sites = 3;
+    config.num_transcripts = 2;
+    config.transcript_length = 300;
+
+    auto run = [&config]() {
+        auto sim = GenerateModel(config);
+        sim->StepUntil(20);
+        return SpeciesTracker::Instance().species();
+    };
+    auto species = run();
+    REQUIRE(species["gene1"] > 0);
+    REQUIRE(species["tx_gene3"] > 0);
+    REQUIRE(species["g2_p1"] + species["rnapol"] > 0);
+    // The layout and the simulation are reproducible for a given seed
+    REQUIRE(run() == species);
+
+    // Every gene is laid out, whether or not it has been translated yet
+    std::mt19937 rng(config.seed);
+    auto genome = GenerateGenome(config, 0, rng);
+    // (RNase sites on transcripts have no gene)
+    std::set<std::string> genes;
+    for (const auto &site : genome->GetTranscriptRbsIntervals()) {
+        if (!site.value->gene().empty()) {
+            genes.insert(site.value->gene());
+        }
+    }
+    REQUIRE(genes.size() == 20);
+    REQUIRE(genes.count("gene20") == 1);
+
+    config.genome_length = 1000;
+    REQUIRE_THROWS_AS(GenerateModel(config), std::invalid_argument);
+    config.genome_length = 3000;
+    config.num_promoters = 21;
+    REQUIRE_THROWS_AS(GenerateModel(config), std::invalid_argument);
+}
+
+TEST_CASE("Prune dead reactions and species")
+{
+    auto build = [](bool prune) {
+        auto sim = std::make_shared<Model>(8e-16);
+        sim->seed(34);
+        sim->AddPolymerase("rnapol", 10, 40, 10);
+        // Produced by translation of gene t7pol
+        sim->AddPolymerase("t7pol", 10, 40, 0);
+        // Absent and never produced
+        sim->AddPolymerase("sigma", 10, 40, 0);
+        sim->AddRibosome(10, 30, 100);
+        sim->AddSpecies("X", 5);
+        sim->AddReaction(1.0, {"X", "Y"}, {"Z"});
+        sim->AddReaction(1.0, {"orphan"}, {"W"});
+        sim->AddReaction(0.1, {"t7pol"}, {"t7pol", "A"});
+        auto genome = std::make_shared<Genome>("phage", 500);
+        genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+        genome->AddGene("t7pol", 26, 148, 11, 26, 1e7);
+        genome->AddPromoter("p2", 151, 160, {{"t7pol", 2e8}});
+        genome->AddGene("late", 176, 248, 161, 176, 1e7);
+        genome->AddTerminator("t1", 249, 250, {{"rnapol", 1.0},
+                                               {"t7pol", 1.0}});
+        genome->AddPromoter("p3", 251, 260, {{"sigma", 2e8}});
+        genome->AddGene("orphan", 276, 448, 261, 276, 1e7);
+        genome->AddTerminator("t2", 449, 450, {{"sigma", 1.0}});
+        sim->RegisterGenome(genome);
+        if (prune) {
+            sim->EnablePruning();
+        }
+        sim->StepUntil(30);
+        return sim;
+    };
+
+    auto full = build(false);
+    auto counts = SpeciesTracker::Instance().species();
+    auto pruned = build(true);
+    const auto &report = pruned->pruned();
+    REQUIRE(report.reactions == std::vector<std::string>(
+                                    {"X + Y -> Z", "orphan -> W",
+                                     "bind __ribosome to __orphan_rbs on phage",
+                                     "bind sigma to p3 on phage"}));
+    REQUIRE(report.species ==
+            std::vector<std::string>({"W", "Y", "Z", "orphan", "sigma"}));
+    REQUIRE_THROWS_AS(pruned->EnablePruning(), std::runtime_error);
+
+    // Species that are still tracked follow the same trajectory
+    const auto &pruned_counts = SpeciesTracker::Instance().species();
+    REQUIRE(pruned_counts.at("late") > 0);
+    REQUIRE(pruned_counts.at("A") > 0);
+    for (const auto &species : pruned_counts) {
+        REQUIRE(species.second == counts.at(species.first));
+    }
+    for (const auto &name : report.species) {
+        REQUIRE(counts.at(name) == 0);
+    }
+
+    // Species with a handle survive pruning
+    auto &tracker = SpeciesTracker::Instance();
+    const int *handle = tracker.FindSpecies("unused");
+    tracker.Pin("unused");
+    REQUIRE_FALSE(tracker.RemoveSpecies("unused"));
+    REQUIRE(tracker.FindSpecies("unused") == handle);
+}
+
+TEST_CASE("Mean-field translation")
+{
+    // Uniform rates: initiation-limited current and the ceiling of the
+    // elongation-limited phase
+    MeanFieldTasep uniform(std::vector<double>(100, 30.0), 10, 16);
+    REQUIRE(uniform.sites() == 100);
+    REQUIRE(uniform.Current(0.0) == 0.0);
+    REQUIRE(uniform.Current(2.0) == Approx(2.0 / (1 + 2.0 * 16 / 30.0)));
+    REQUIRE(uniform.Load(2.0) == Approx(uniform.Current(2.0) * 100 / 30.0));
+    double ceiling = 30.0 / std::pow(1 + std::sqrt(10.0), 2);
+    REQUIRE(uniform.Current(1e6) == Approx(ceiling));
+    REQUIRE(uniform.Load(1e6) == Approx(100 / (std::sqrt(10.0) *
+                                               (1 + std::sqrt(10.0)))));
+    // A slow stretch lowers the ceiling
+    std::vector<double> rates(100, 30.0);
+    std::fill(rates.begin() + 40, rates.begin() + 60, 6.0);
+    REQUIRE(MeanFieldTasep(rates, 10, 16).Current(1e6) ==
+            Approx(ceiling / 5));
+    rates[50] = 0.0;
+    REQUIRE_THROWS_AS(MeanFieldTasep(rates, 10, 16), std::invalid_argument);
+
+    // Protein production from free transcripts, against explicit ribosomes
+    auto produced = [](bool mean_field, int seed) {
+        Model sim(8e-16);
+        sim.seed(seed);
+        sim.AddRibosome(10, 30, 1000);
+        for (const std::string gene : {"geneA", "geneB"}) {
+            auto transcript = std::make_shared<Transcript>(gene + "_tx", 250);
+            transcript->AddGene(gene, 26, 225, 11, 26, 1e6);
+            sim.RegisterTranscript(transcript);
+            if (mean_field) {
+                sim.EnableMeanFieldTranslation(gene);
+            }
+        }
+        sim.StepUntil(200);
+        auto &tracker = SpeciesTracker::Instance();
+        if (mean_field) {
+            // No ribosomes are held on the transcripts
+            REQUIRE(tracker.species("__ribosome") == 1000);
+        }
+        return tracker.species("geneA") + tracker.species("geneB");
+    };
+    double exact = 0;
+    double approximate = 0;
+    for (int seed = 1; seed <= 4; seed++) {
+        exact += produced(false, seed);
+        approximate += produced(true, seed);
+    }
+    REQUIRE(approximate == Approx(exact).epsilon(0.08));
+
+    // Transcripts made from a genome
+    Model sim(8e-16);
+    sim.seed(7);
+    sim.AddPolymerase("rnapol", 10, 40, 10);
+    sim.AddRibosome(10, 30, 100);
+    auto genome = std::make_shared<Genome>("phage", 300);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+    genome->AddGene("geneC", 26, 225, 11, 26, 1e7);
+    genome->AddTerminator("t1", 299, 300, {{"rnapol", 1.0}});
+    sim.RegisterGenome(genome);
+    sim.EnableMeanFieldTranslation("geneC");
+    sim.StepUntil(20);
+    REQUIRE(SpeciesTracker::Instance().species("geneC") > 0);
+    REQUIRE_THROWS_AS(sim.EnableMeanFieldTranslation("geneC"),
+                      std::runtime_error);
+
+    Model missing(8e-16);
+    missing.AddRibosome(10, 30, 100);
+    auto transcript = std::make_shared<Transcript>("tx", 250);
+    transcript->AddGene("geneA", 26, 225, 11, 26, 1e6);
+    missing.RegisterTranscript(transcript);
+    missing.EnableMeanFieldTranslation("geneZ");
+    REQUIRE_THROWS_AS(missing.Initialize(), std::invalid_argument);
+}
+
+TEST_CASE("Rate law expressions")
+{
+    RateLaw hill("vmax * A^n / (K^n + A^n)",
+                 {{"vmax", 10.0}, {"K", 50.0}, {"n", 2.0}});
+    REQUIRE(hill.species() == std::vector<std::string>({"A"}));
+    double counts[] = {50.0};
+    REQUIRE(hill.Evaluate(counts) == Approx(5.0));
+    counts[0] = 0.0;
+    REQUIRE(hill.Evaluate(counts) == 0.0);
+
+    // Precedence, associativity, unary minus and functions
+    RateLaw law("2^3^2 - -x * 3 + max(y, 1) / min(4, sqrt(16)) + exp(0)");
+    REQUIRE(law.species() == std::vector<std::string>({"x", "y"}));
+    double xy[] = {2.0, 8.0};
+    REQUIRE(law.Evaluate(xy) == Approx(512 + 6 + 2 + 1));
+    REQUIRE(RateLaw("pow(2, 10) * __ribosome").species() ==
+            std::vector<std::string>({"__ribosome"}));
+
+    REQUIRE_THROWS_AS(RateLaw("k * (A + 1"), std::invalid_argument);
+    REQUIRE_THROWS_AS(RateLaw("k * A)"), std::invalid_argument);
+    REQUIRE_THROWS_AS(RateLaw("hill(A)"), std::invalid_argument);
+    REQUIRE_THROWS_AS(RateLaw(""), std::invalid_argument);
+    REQUIRE_THROWS_AS(RateLaw("A $ B"), std::invalid_argument);
+
+    // A mass-action rate law follows the same trajectory as the equivalent
+    // species reaction
+    auto run = [](bool rate_law) {
+        Model sim(8e-16);
+        sim.seed(34);
+        sim.AddSpecies("A", 500);
+        if (rate_law) {
+            sim.AddRateLawReaction("k * A", {{"k", 0.5}}, {"A"}, {"B"});
+        } else {
+            sim.AddReaction(0.5, {"A"}, {"B"});
+        }
+        sim.RegisterGenome(std::make_shared<Genome>("empty", 10));
+        sim.StepUntil(2);
+        return SpeciesTracker::Instance().species("B");
+    };
+    int b = run(false);
+    REQUIRE(b > 0);
+    REQUIRE(run(true) == b);
+
+    // Repression by a species that another reaction produces: the rate law
+    // is re-evaluated as the repressor accumulates
+    Model sim(8e-16);
+    sim.seed(34);
+    sim.AddSpecies("source", 1);
+    sim.AddReaction(100.0, {"source"}, {"source", "R"});
+    sim.AddRateLawReaction("100 / (1 + (R / K)^4)", {{"K", 50.0}}, {}, {"P"});
+    sim.RegisterGenome(std::make_shared<Genome>("empty", 10));
+    sim.StepUntil(5);
+    auto &tracker = SpeciesTracker::Instance();
+    // Without repression P would reach about 500
+    REQUIRE(tracker.species("R") > 300);
+    REQUIRE(tracker.species("P") > 30);
+    REQUIRE(tracker.species("P") < 150);
+
+    // Reactants are never driven negative
+    Model depleted(8e-16);
+    depleted.AddSpecies("A", 3);
+    depleted.AddRateLawReaction("5", {}, {"A"}, {});
+    depleted.RegisterGenome(std::make_shared<Genome>("empty", 10));
+    depleted.Step(3);
+    REQUIRE(SpeciesTracker::Instance().species("A") == 0);
+    REQUIRE_THROWS_AS(depleted.Step(1), std::runtime_error);
+
+    Model negative(8e-16);
+    negative.AddSpecies("A", 3);
+    REQUIRE_THROWS_AS(negative.AddRateLawReaction("1 - A", {}, {}, {"B"}),
+                      std::runtime_error);
+
+    std::stringstream text(
+        "simulation:\n"
+        "    seed: 34\n"
+        "    runtime: 10\n"
+        "species:\n"
+        "- name: A\n"
+        "  copy_number: 100\n"
+        "reactions:\n"
+        "- name: hill\n"
+        "  rate_law: vmax * A^2 / (K^2 + A^2)\n"
+        "  parameters:\n"
+        "      vmax: 10\n"
+        "      K: 50\n"
+        "  reactants: [A]\n"
+        "  products: [B]\n");
+    auto model = ModelFile(text).Build();
+    model->RegisterGenome(std::make_shared<Genome>("empty", 10));
+    model->Step(10);
+    REQUIRE(SpeciesTracker::Instance().species("B") == 10);
+}
+
+namespace {
+
+struct Counter {
+  int total = 0;
+  void Add(int value) { total += value; }
+};
+
+}  // namespace
+
+TEST_CASE("Signal dispatch")
+{
+    Signal<int> signal;
+    Counter counter;
+    std::vector<int> order;
+    signal.ConnectMember<Counter, &Counter::Add>(&counter);
+    int second = signal.Connect([&order](int value) { order.push_back(1); });
+    signal.ConnectMember(&counter, &Counter::Add);
+    signal.Connect([&order](int value) { order.push_back(2); });
+    signal.Emit(5);
+    REQUIRE(counter.total == 10);
+    REQUIRE(order == std::vector<int>({1, 2}));
+
+    signal.Disconnect(second);
+    signal.Emit(1);
+    REQUIRE(counter.total == 12);
+    REQUIRE(order == std::vector<int>({1, 2, 2}));
+
+    // A copy starts without slots
+    Signal<int> copy(signal);
+    copy.Emit(100);
+    REQUIRE(counter.total == 12);
+
+    // Slots may disconnect themselves, and connect new slots, while the
+    // signal is emitting
+    Signal<int> nested;
+    int self = 0;
+    int calls = 0;
+    self = nested.Connect([&](int value) {
+        calls++;
+        nested.Disconnect(self);
+        nested.ConnectMember<Counter, &Counter::Add>(&counter);
+    });
+    nested.Emit(1);
+    REQUIRE(calls == 1);
+    REQUIRE(counter.total == 12);
+    nested.Emit(3);
+    REQUIRE(calls == 1);
+    REQUIRE(counter.total == 15);
+
+    signal.DisconnectAll();
+    signal.Emit(1);
+    REQUIRE(counter.total == 15);
+}
+
+namespace {
+
+struct RecordingObserver : public Observer {
+  long reactions = 0;
+  long binds = 0;
+  long samples = 0;
+  std::map<std::string, long> terminations;
+  std::map<int, double> created;
+  std::map<int, double> destroyed;
+  double last_time = 0;
+  bool monotonic = true;
+
+  void OnReaction(double time, const Reaction &reaction) override {
+    reactions++;
+    monotonic = monotonic && time >= last_time;
+    last_time = time;
+  }
+  void OnBind(double time, const std::string &pol_name,
+              const std::string &site, int polymer_id) override {
+    binds++;
+  }
+  void OnTerminate(double time, const std::string &pol_name,
+                   const std::string &gene) override {
+    terminations[pol_name + ":" + gene]++;
+  }
+  void OnTranscriptCreated(double time, int id, const std::string &name,
+                           int start, int stop) override {
+    created[id] = time;
+  }
+  void OnTranscriptDestroyed(double time, int id) override {
+    destroyed[id] = time;
+  }
+  void OnSample(double time) override { samples++; }
+};
+
+}  // namespace
+
+TEST_CASE("Observers")
+{
+    auto observer = std::make_shared<RecordingObserver>();
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(11);
+    sim->AddObserver(observer);
+    sim->AddPolymerase("rnapol", 10, 30, 10);
+    sim->AddRibosome(10, 20, 100);
+    auto genome = std::make_shared<Genome>("phage", 305, 1e-2, 20, 9, 1e-2);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+    genome->AddGene("geneA", 30, 99, 20, 30, 1e7);
+    genome->AddTerminator("t1", 304, 305, {{"rnapol", 1.0}});
+    sim->RegisterGenome(genome);
+    sim->StepUntil(100);
+
+    REQUIRE(observer->reactions == sim->stats().events);
+    REQUIRE(observer->monotonic);
+    REQUIRE(observer->binds > 0);
+    auto &tracker = SpeciesTracker::Instance();
+    REQUIRE(observer->terminations["__ribosome:geneA"] ==
+            tracker.species("geneA"));
+    // Every transcript is created when a polymerase binds; some are still
+    // being transcribed
+    long transcribed = 0;
+    for (const auto &termination : observer->terminations) {
+        if (termination.first.compare(0, 7, "rnapol:") == 0) {
+            transcribed += termination.second;
+        }
+    }
+    REQUIRE(transcribed > 0);
+    REQUIRE(transcribed <= long(observer->created.size()));
+    REQUIRE(!observer->destroyed.empty());
+    for (const auto &transcript : observer->destroyed) {
+        REQUIRE(observer->created.count(transcript.first) == 1);
+        REQUIRE(transcript.second >= observer->created[transcript.first]);
+    }
+
+    // A new model starts without observers
+    Model other(8e-16);
+    REQUIRE(!tracker.observers_.active());
+    REQUIRE_THROWS_AS(other.AddObserver(nullptr), std::invalid_argument);
+    REQUIRE_THROWS_AS(other.LoadObserver("/nonexistent/observer.so"),
+                      std::runtime_error);
+}
+
+TEST_CASE("Observer plugin")
+{
+    std::string output = "observer_example_test.tsv";
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(3);
+    sim->LoadObserver(PINETREE_OBSERVER_EXAMPLE, output);
+    sim->AddPolymerase("rnapol", 10, 30, 10);
+    sim->AddRibosome(10, 20, 100);
+    auto genome = std::make_shared<Genome>("phage", 305, 1e-2, 20, 9, 1e-2);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+    genome->AddGene("geneA", 30, 99, 20, 30, 1e7);
+    genome->AddTerminator("t1", 304, 305, {{"rnapol", 1.0}});
+    sim->RegisterGenome(genome);
+    sim->Simulate(50, 10, "observer_example_counts.tsv");
+    long proteins = SpeciesTracker::Instance().species("geneA");
+    // Unloads the plugin and closes its output file
+    Model other(8e-16);
+
+    std::ifstream in(output);
+    REQUIRE(in.good());
+    std::string line;
+    std::getline(in, line);
+    REQUIRE(line == "time\tgene\tproteins\tmean_transcript_lifetime");
+    std::string last;
+    while (std::getline(in, line)) {
+        last = line;
+    }
+    std::istringstream row(last);
+    double time;
+    std::string gene;
+    long count;
+    row >> time >> gene >> count;
+    REQUIRE(gene == "geneA");
+    REQUIRE(count <= proteins);
+    REQUIRE(count > 0);
+    std::remove(output.c_str());
+    std::remove("observer_example_counts.tsv");
+}
+
+TEST_CASE("Genome replication")
+{
+    auto genome = std::make_shared<Genome>("phage", 305, 1e-2, 20, 9, 1e-2);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+    genome->AddGene("geneA", 30, 99, 20, 30, 1e7);
+    genome->AddTerminator("t1", 304, 305, {{"rnapol", 1.0}});
+    genome->AddWeights(std::vector<double>(305, 0.5));
+
+    // Copies share structure but not state
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(5);
+    sim->AddPolymerase("rnapol", 10, 30, 10);
+    sim->AddRibosome(10, 20, 100);
+    sim->RegisterGenome(genome);
+    auto replica = genome->Replicate();
+    REQUIRE(replica->name() == "phage");
+    REQUIRE(&replica->transcript_weights() == &genome->transcript_weights());
+    REQUIRE(&replica->GetTranscriptRbsIntervals() ==
+            &genome->GetTranscriptRbsIntervals());
+    REQUIRE(&replica->bindings() == &genome->bindings());
+    REQUIRE(replica->GetBindingIntervals().size() == 1);
+    REQUIRE(replica->GetBindingIntervals()[0].value !=
+            genome->GetBindingIntervals()[0].value);
+
+    // Replication during a simulation, up to a limit
+    sim->AddGenomeReplication("phage", 0.5, 40);
+    REQUIRE_THROWS_AS(sim->AddGenomeReplication("phage", 0.0),
+                      std::invalid_argument);
+    REQUIRE(sim->genome_copies("phage") == 1);
+    sim->StepUntil(30);
+    REQUIRE(sim->genome_copies("phage") == 40);
+    REQUIRE_THROWS_AS(sim->AddGenomeReplication("phage", 1.0),
+                      std::runtime_error);
+    auto &tracker = SpeciesTracker::Instance();
+    long produced = tracker.species("geneA");
+    sim->StepUntil(60);
+    // Many more copies are transcribed than the original genome could be
+    REQUIRE(tracker.species("geneA") > produced);
+    REQUIRE(sim->genome_copies("phage") == 40);
+    REQUIRE(tracker.species("p1") <= 40);
+
+    // The replication rate grows with the number of copies
+    // (a Yule process, with a mean of e^3 copies at time 3)
+    double mean = 0;
+    for (int seed = 1; seed <= 20; seed++) {
+        Model model(8e-16);
+        model.seed(seed);
+        model.RegisterGenome(std::make_shared<Genome>("plasmid", 100));
+        model.AddGenomeReplication("plasmid", 1.0);
+        model.StepUntil(3.0);
+        mean += model.genome_copies("plasmid") / 20.0;
+    }
+    REQUIRE(mean > std::exp(3.0) / 2);
+    REQUIRE(mean < std::exp(3.0) * 1.5);
+
+    Model missing(8e-16);
+    missing.RegisterGenome(std::make_shared<Genome>("phage", 100));
+    missing.AddGenomeReplication("plasmid", 1.0);
+    REQUIRE_THROWS_AS(missing.Initialize(), std::invalid_argument);
+
+    std::istringstream text(
+        "simulation:\n"
+        "  seed: 1\n"
+        "  runtime: 10\n"
+        "  time_step: 1\n"
+        "  cell_volume: 8e-16\n"
+        "genome:\n"
+        "  name: plasmid\n"
+        "  length: 100\n"
+        "  replication_rate: 1.0\n"
+        "  max_copies: 5\n");
+    auto model = ModelFile(text).Build();
+    model->Step(4);
+    REQUIRE(model->genome_copies("plasmid") == 5);
+    // Nothing is left to happen
+    REQUIRE_THROWS(model->Step(1));
+}
+
+namespace {
+
+std::shared_ptr<Model> CacheTestModel(int seed, double promoter_rate) {
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(seed);
+    sim->AddPolymerase("rnapol", 10, 30, 10);
+    sim->AddRibosome(10, 20, 100);
+    sim->AddReaction(1e6, {"rnapol", "geneA"}, {"complex"});
+    auto genome = std::make_shared<Genome>("phage", 305, 1e-2, 20, 9, 1e-2);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", promoter_rate}});
+    genome->AddGene("geneA", 30, 99, 20, 30, 1e7);
+    genome->AddTerminator("t1", 304, 305, {{"rnapol", 1.0}});
+    sim->RegisterGenome(genome);
+    return sim;
+}
+
+std::string ReadFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+}  // namespace
+
+TEST_CASE("Result cache")
+{
+    // Only the most recently created model is usable, because models share
+    // the species tracker
+    std::string other_seed = CacheTestModel(6, 2e8)->Hash(20, 5);
+    std::string other_rate = CacheTestModel(5, 3e8)->Hash(20, 5);
+    auto sim = CacheTestModel(5, 2e8);
+    std::string hash = sim->Hash(20, 5);
+    REQUIRE(hash.size() == 16);
+    REQUIRE(hash != other_seed);
+    REQUIRE(hash != other_rate);
+    REQUIRE(sim->Hash(30, 5) != hash);
+    REQUIRE(sim->Hash(20, 1) != hash);
+
+    sim->EnableCache(".");
+    std::string cached = "./" + hash + ".tsv";
+    std::remove(cached.c_str());
+    sim->Simulate(20, 5, "cache_test_first.tsv");
+    REQUIRE(!sim->stats().cached);
+    REQUIRE(sim->stats().events > 0);
+    // The definition is hashed as it was at initialization
+    REQUIRE(sim->Hash(20, 5) == hash);
+    REQUIRE(ReadFile(cached) == ReadFile("cache_test_first.tsv"));
+
+    auto again = CacheTestModel(5, 2e8);
+    REQUIRE(again->Hash(20, 5) == hash);
+    again->EnableCache(".");
+    again->Simulate(20, 5, "cache_test_second.tsv");
+    REQUIRE(again->stats().cached);
+    REQUIRE(again->stats().events == 0);
+    REQUIRE(ReadFile("cache_test_second.tsv") ==
+            ReadFile("cache_test_first.tsv"));
+
+    // Models without a seed are never cached
+    auto unseeded = std::make_shared<Model>(8e-16);
+    unseeded->AddSpecies("X", 10);
+    unseeded->AddReaction(1.0, {"X"}, {"Y"});
+    unseeded->AddReaction(1.0, {"Y"}, {"X"});
+    unseeded->EnableCache(".");
+    std::string unseeded_cached = "./" + unseeded->Hash(20, 5) + ".tsv";
+    unseeded->Simulate(20, 5, "cache_test_unseeded.tsv");
+    REQUIRE(!unseeded->stats().cached);
+    REQUIRE(!std::ifstream(unseeded_cached).good());
+
+    REQUIRE_THROWS_AS(Model(8e-16).EnableCache("/nonexistent/cache"),
+                      std::invalid_argument);
+
+    std::remove(cached.c_str());
+    std::remove("cache_test_first.tsv");
+    std::remove("cache_test_second.tsv");
+    std::remove("cache_test_unseeded.tsv");
+}
+
+TEST_CASE("Scheduled events")
+{
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(13);
+    // A fast reaction that never changes any count keeps the clock running
+    sim->AddSpecies("clock", 100);
+    sim->AddReaction(10.0, {"clock"}, {"clock"});
+    sim->AddSpecies("X", 0);
+    sim->AddReaction(1.0, {"X"}, {"Y"});
+    sim->ScheduleSpeciesChange(2.0, "X", 50);
+    sim->ScheduleRateChange(3.0, {"X"}, {"Y"}, 0.0);
+    sim->AddPolymerase("rnapol", 10, 30, 10);
+    sim->AddRibosome(10, 20, 100);
+    auto genome = std::make_shared<Genome>("phage", 305);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+    genome->AddGene("geneA", 30, 99, 20, 30, 1e7);
+    genome->AddTerminator("t1", 304, 305, {{"rnapol", 1.0}});
+    sim->ScheduleGenome(4.0, genome);
+    auto &tracker = SpeciesTracker::Instance();
+
+    sim->StepUntil(1.99);
+    REQUIRE(tracker.species("X") == 0);
+    REQUIRE(tracker.species("Y") == 0);
+    sim->StepUntil(2.5);
+    REQUIRE(tracker.species("X") + tracker.species("Y") == 50);
+    sim->StepUntil(3.0);
+    // Switched off
+    int converted = tracker.species("Y");
+    REQUIRE(converted > 0);
+    REQUIRE(sim->genome_copies("phage") == 0);
+    sim->StepUntil(60.0);
+    REQUIRE(tracker.species("Y") == converted);
+    REQUIRE(sim->genome_copies("phage") == 1);
+    REQUIRE(tracker.species("geneA") > 0);
+
+    // Events must be in the future
+    REQUIRE_THROWS_AS(sim->ScheduleSpeciesChange(10.0, "X", 1),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(sim->ScheduleRateChange(100.0, {"Y"}, {"X"}, 1.0),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(sim->ScheduleGenome(100.0, genome), std::runtime_error);
+
+    // Events are applied even when no reaction can happen
+    auto idle = std::make_shared<Model>(8e-16);
+    idle->AddSpecies("X", 0);
+    idle->AddReaction(1.0, {"X"}, {"Y"});
+    idle->ScheduleSpeciesChange(7.5, "X", 1);
+    idle->Step(1);
+    REQUIRE(idle->time() > 7.5);
+    REQUIRE(tracker.species("Y") == 1);
+    REQUIRE_THROWS(idle->Step(1));
+
+    // Rate changes must match a reaction
+    auto unknown = std::make_shared<Model>(8e-16);
+    unknown->AddSpecies("X", 10);
+    unknown->AddReaction(1.0, {"X"}, {"Y"});
+    unknown->ScheduleRateChange(1.0, {"X"}, {"Z"}, 2.0);
+    REQUIRE_THROWS_AS(unknown->Step(1), std::invalid_argument);
+
+    // Events in a model file
+    std::stringstream text(
+        "simulation:\n"
+        "    seed: 2\n"
+        "    runtime: 10\n"
+        "species:\n"
+        "- name: X\n"
+        "  copy_number: 0\n"
+        "reactions:\n"
+        "- propensity: 1.0\n"
+        "  reactants: [X]\n"
+        "  products: [Y]\n"
+        "events:\n"
+        "- time: 1.5\n"
+        "  species: X\n"
+        "  change: 3\n");
+    auto from_file = ModelFile(text).Build();
+    from_file->StepUntil(1.0);
+    REQUIRE(from_file->time() > 1.5);
+    REQUIRE(tracker.species("X") + tracker.species("Y") == 3);
+}
+
+TEST_CASE("Slow-scale SSA")
+{
+    // Isomerization A <-> B is binomial at equilibrium
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->AddSpecies("A", 10);
+    sim->AddReaction(1.0, {"A"}, {"B"});
+    sim->AddReaction(3.0, {"B"}, {"A"});
+    auto forward = std::make_shared<SpeciesReaction>(
+        1.0, 8e-16, std::vector<std::string>{"A"},
+        std::vector<std::string>{"B"});
+    auto reverse = std::make_shared<SpeciesReaction>(
+        3.0, 8e-16, std::vector<std::string>{"B"},
+        std::vector<std::string>{"A"});
+    FastEquilibrium equilibrium(forward, reverse);
+    equilibrium.Update();
+    REQUIRE(equilibrium.ExpectedProduct({"B"}) == Approx(2.5));
+    REQUIRE(equilibrium.ExpectedProduct({"B", "B"}) ==
+            Approx(10 * 0.25 * 0.75 + 2.5 * 2.5));
+    REQUIRE(equilibrium.ExpectedProduct({"C"}) == 1.0);
+    REQUIRE(equilibrium.Flux() == Approx(7.5));
+    auto catalyzed = std::make_shared<SpeciesReaction>(
+        1.0, 8e-16, std::vector<std::string>{"A", "C"},
+        std::vector<std::string>{"A", "B"});
+    REQUIRE_THROWS_AS(FastEquilibrium(forward, forward),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(FastEquilibrium(catalyzed, reverse),
+                      std::invalid_argument);
+
+    // Fast repressor binding under slow expression
+    auto build = [](double ratio) {
+        auto model = std::make_shared<Model>(8e-16);
+        model->seed(4);
+        model->AddSpecies("R", 20);
+        model->AddSpecies("O", 5);
+        model->AddReaction(4e10, {"R", "O"}, {"RO"});
+        model->AddReaction(500.0, {"RO"}, {"R", "O"});
+        model->AddReaction(1.0, {"O"}, {"O", "P"});
+        model->AddReaction(0.05, {"P"}, {});
+        model->AddReaction(0.2, {"R"}, {});
+        model->AddReaction(4.0, {}, {"R"});
+        model->EnableSlowScale(ratio);
+        return model;
+    };
+    auto &tracker = SpeciesTracker::Instance();
+    auto fast = build(100);
+    fast->StepUntil(10);
+    REQUIRE(fast->fast_equilibria() ==
+            std::vector<std::string>{"R + O <-> RO"});
+    // Operators are conserved and no binding events are simulated
+    REQUIRE(tracker.species("O") + tracker.species("RO") == 5);
+    REQUIRE(fast->stats().events < 1000);
+    REQUIRE(tracker.species("P") > 0);
+
+    auto exact = build(1e6);
+    exact->StepUntil(1);
+    REQUIRE(exact->fast_equilibria().empty());
+    REQUIRE(exact->stats().events > 1000);
+
+    REQUIRE_THROWS_AS(Model(8e-16).EnableSlowScale(0), std::invalid_argument);
+}
+
+TEST_CASE("Rejection-based SSA")
+{
+    // Dimerization with large counts barely moves the propensities
+    auto build = [](bool rssa) {
+        auto model = std::make_shared<Model>(8e-16);
+        model->seed(7);
+        model->AddSpecies("A", 5000);
+        model->AddSpecies("B", 5000);
+        model->AddReaction(1e6, {"A", "B"}, {"AB"});
+        model->AddReaction(1.0, {"AB"}, {"A", "B"});
+        model->AddReaction(1.0, {"A"}, {"C"});
+        model->AddReaction(1.0, {"C"}, {"A"});
+        if (rssa) {
+            model->EnableRejectionSampling(0.1);
+        }
+        return model;
+    };
+    auto &tracker = SpeciesTracker::Instance();
+    auto exact = build(false);
+    exact->StepUntil(0.5);
+    auto exact_events = exact->stats().events;
+    auto exact_evaluations = exact->stats().propensity_evaluations;
+    REQUIRE(exact_evaluations > exact_events);
+
+    auto bounded = build(true);
+    bounded->StepUntil(0.5);
+    REQUIRE(bounded->stats().events > exact_events / 2);
+    REQUIRE(bounded->stats().propensity_evaluations <
+            bounded->stats().events);
+    REQUIRE(tracker.species("A") + tracker.species("AB") +
+                tracker.species("C") ==
+            5000);
+    REQUIRE(tracker.species("B") + tracker.species("AB") == 5000);
+
+    REQUIRE_THROWS_AS(Model(8e-16).EnableRejectionSampling(0),
+                      std::invalid_argument);
+    auto started = build(false);
+    started->StepUntil(0.01);
+    REQUIRE_THROWS_AS(started->EnableRejectionSampling(0.1),
+                      std::runtime_error);
+}
+
+TEST_CASE("Compact element layout")
+{
+    auto first = Polymerase("rnapol", 10, 40);
+    auto second = Polymerase("rnapol", 10, 40);
+    // Names are interned, so copies share one string
+    REQUIRE(&first.name() == &second.name());
+    first.gene_bound("gene1");
+    second.gene_bound("gene1");
+    REQUIRE(&first.gene_bound() == &second.gene_bound());
+    REQUIRE(first.speed() == 40);
+    first.reading_frame(2);
+    REQUIRE(first.reading_frame() == 2);
+    // Two names and four positions fit in 64 bytes with the vtable and
+    // shared_from_this pointers on 64-bit platforms
+    REQUIRE(sizeof(Polymerase) <= 64);
+
+    // Copies of a site share its interactions
+    auto site = std::make_shared<ReleaseSite>(
+        "stop", 1, 3, std::map<std::string, double>{{"ribosome", 0.5}});
+    auto clone = site->Clone();
+    REQUIRE(&clone->interactions() == &site->interactions());
+    REQUIRE(clone->efficiency("ribosome") == 0.5);
+    REQUIRE(clone->efficiency("rnapol") == 0);
+    REQUIRE(clone->interactions().size() == 1);
+    REQUIRE(clone->reading_frame() == -1);
+}
+
+TEST_CASE("Snapshots")
+{
+    auto model = std::make_shared<Model>(8e-16);
+    model->seed(3);
+    model->AddSpecies("A", 1000);
+    model->AddReaction(1.0, {"A"}, {"B"});
+    model->AddReaction(1.0, {"B"}, {"A"});
+    REQUIRE_THROWS_AS(model->snapshot(), std::runtime_error);
+    REQUIRE_THROWS_AS(model->EnableSnapshots(-1), std::invalid_argument);
+    model->EnableSnapshots(0);
+    REQUIRE(model->snapshot().version == 0);
+
+    // A monitoring thread never sees a half-published snapshot, in which
+    // A + B would not add up
+    std::atomic<bool> done(false);
+    bool consistent = true;
+    bool ordered = true;
+    long reads = 0;
+    std::thread monitor([&]() {
+        Snapshot last;
+        while (!done) {
+            auto snapshot = model->snapshot();
+            if (snapshot.version > 0) {
+                consistent &= snapshot.species["A"] + snapshot.species["B"] ==
+                              1000;
+            }
+            ordered &= snapshot.version >= last.version &&
+                       snapshot.events >= last.events &&
+                       snapshot.time >= last.time;
+            last = snapshot;
+            reads++;
+        }
+    });
+    model->Step(200000);
+    done = true;
+    monitor.join();
+    REQUIRE(consistent);
+    REQUIRE(ordered);
+    REQUIRE(reads > 0);
+    auto &tracker = SpeciesTracker::Instance();
+    auto last = model->snapshot();
+    REQUIRE(last.events == 200000);
+    REQUIRE(last.time == model->time());
+    REQUIRE(last.species["A"] == tracker.species("A"));
+
+    // Snapshots follow the interval in simulated time
+    model->EnableSnapshots(1.0);
+    auto version = last.version;
+    model->StepUntil(model->time() + 10);
+    REQUIRE(model->snapshot().version - version >= 10);
+    REQUIRE(model->snapshot().version - version <= 12);
+}
+
+TEST_CASE("Export polymer state")
+{
+    auto genome = std::make_shared<Genome>("phage", 305, 1e-2, 20, 9, 1e-2);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+    genome->AddGene("geneA", 30, 99, 20, 30, 1e7);
+    genome->AddTerminator("t1", 304, 305, {{"rnapol", 1.0}});
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(5);
+    sim->AddPolymerase("rnapol", 10, 30, 10);
+    sim->AddRibosome(10, 20, 100);
+    sim->RegisterGenome(genome);
+    sim->StepUntil(20);
+
+    auto state = sim->ExportState();
+    REQUIRE(state.time == sim->time());
+    REQUIRE(state.polymers.size() > 1);
+    const auto &first = state.polymers[0];
+    REQUIRE(state.names[first.name] == "phage");
+    REQUIRE(first.kind == PolymerRecord::kGenome);
+    REQUIRE(first.id == genome->id());
+    REQUIRE(first.mask_start == genome->GetMask().start());
+    std::map<int, int> kinds;
+    for (const auto &polymer : state.polymers) {
+        kinds[polymer.id] = polymer.kind;
+    }
+    REQUIRE(kinds.size() == state.polymers.size());
+
+    // Polymerases are only on genomes, ribosomes only on transcripts
+    int ribosomes = 0;
+    for (const auto &element : state.mobile_elements) {
+        REQUIRE(kinds.count(element.polymer_id) == 1);
+        if (element.kind == MobileElementRecord::kRibosome) {
+            REQUIRE(kinds[element.polymer_id] == PolymerRecord::kTranscript);
+            REQUIRE(state.names[element.name] == "__ribosome");
+            ribosomes++;
+        } else if (element.kind == MobileElementRecord::kPolymerase) {
+            REQUIRE(kinds[element.polymer_id] == PolymerRecord::kGenome);
+            REQUIRE(state.names[element.name] == "rnapol");
+        }
+        REQUIRE(element.stop >= element.start);
+    }
+    REQUIRE(ribosomes > 0);
+    REQUIRE(std::count_if(state.mobile_elements.begin(),
+                          state.mobile_elements.end(),
+                          [&genome](const MobileElementRecord &element) {
+                              return element.polymer_id == genome->id();
+                          }) == genome->num_attached());
+
+    // Each transcript has a ribosome binding site and a stop codon for
+    // geneA
+    int covered = 0;
+    std::map<int, int> gene_sites;
+    for (const auto &site : state.sites) {
+        REQUIRE(kinds.count(site.polymer_id) == 1);
+        if (state.names[site.gene] == "geneA") {
+            REQUIRE(kinds[site.polymer_id] == PolymerRecord::kTranscript);
+            gene_sites[site.polymer_id]++;
+        }
+        covered += site.covered > 0;
+    }
+    REQUIRE(gene_sites.size() == state.polymers.size() - 1);
+    for (const auto &item : gene_sites) {
+        REQUIRE(item.second == 2);
+    }
+    REQUIRE(covered > 0);
+}
+
+TEST_CASE("Parallel mode")
+{
+    auto build = [](int threads) {
+        auto sim = std::make_shared<Model>(8e-16);
+        sim->seed(11);
+        sim->AddPolymerase("rnapol", 10, 30, 40);
+        sim->AddRibosome(10, 20, 100);
+        for (int i = 0; i < 4; i++) {
+            auto genome = std::make_shared<Genome>(
+                "phage" + std::to_string(i), 305, 1e-2, 20, 9, 1e-2);
+            genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+            genome->AddGene("geneA", 30, 99, 20, 30, 1e7);
+            genome->AddTerminator("t1", 304, 305, {{"rnapol", 1.0}});
+            sim->RegisterGenome(genome);
+        }
+        sim->EnableParallel(threads, 0.05);
+        return sim;
+    };
+    auto &tracker = SpeciesTracker::Instance();
+    auto first = build(3);
+    first->StepUntil(30);
+    REQUIRE(first->time() == 30);
+    auto events = first->stats().events;
+    auto proteins = tracker.species("geneA");
+    REQUIRE(proteins > 0);
+    REQUIRE(first->stats().peak_transcripts > first->stats().transcripts);
+
+    // Polymerases and ribosomes are either free or bound
+    auto state = first->ExportState();
+    int rnapol = 0;
+    int ribosomes = 0;
+    for (const auto &element : state.mobile_elements) {
+        rnapol += element.kind == MobileElementRecord::kPolymerase;
+        ribosomes += element.kind == MobileElementRecord::kRibosome;
+    }
+    REQUIRE(tracker.species("rnapol") + rnapol == 40);
+    REQUIRE(tracker.species("__ribosome") + ribosomes == 100);
+
+    // Reproducible for a given seed and number of threads
+    auto second = build(3);
+    second->StepUntil(30);
+    REQUIRE(second->stats().events == events);
+    REQUIRE(tracker.species("geneA") == proteins);
+
+    auto stepped = build(2);
+    stepped->Step(500);
+    REQUIRE(stepped->stats().events >= 500);
+
+    REQUIRE_THROWS_AS(Model(8e-16).EnableParallel(0, 0.05),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(Model(8e-16).EnableParallel(2, 0), std::invalid_argument);
+    REQUIRE_THROWS_AS(stepped->EnableParallel(2, 0.05), std::runtime_error);
+}
+
+TEST_CASE("Translation engine")
+{
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(21);
+    sim->AddRibosome(10, 30, 100);
+    auto transcript = std::make_shared<Transcript>("transcript", 605);
+    transcript->AddGene("rnapol", 26, 225, 11, 26, 1e7);
+    transcript->AddGene("proteinX", 241, 280, 226, 241, 1e7);
+    transcript->AddGene("proteinY", 296, 595, 281, 296, 1e7);
+    sim->RegisterTranscript(transcript);
+    auto &tracker = SpeciesTracker::Instance();
+    REQUIRE(tracker.species("__rnapol_rbs") == 1);
+    sim->EnableTranslationEngine();
+    sim->StepUntil(30);
+    REQUIRE_THROWS_AS(sim->EnableTranslationEngine(), std::runtime_error);
+    REQUIRE(tracker.species("rnapol") > 0);
+    REQUIRE(tracker.species("proteinX") > 0);
+    REQUIRE(tracker.species("proteinY") > 0);
+
+    // Ribosomes are either free or on the transcript, in order, and cover
+    // the binding sites under them
+    auto state = sim->ExportState();
+    REQUIRE(state.polymers.size() == 1);
+    REQUIRE(state.polymers[0].id == transcript->id());
+    int bound = 0;
+    int last_stop = 0;
+    for (const auto &element : state.mobile_elements) {
+        REQUIRE(element.kind == MobileElementRecord::kRibosome);
+        REQUIRE(element.start > last_stop);
+        last_stop = element.stop;
+        bound++;
+    }
+    REQUIRE(bound > 0);
+    REQUIRE(tracker.species("__ribosome") + bound == 100);
+    for (const auto &site : state.sites) {
+        if (state.names[site.name] == "__rnapol_rbs") {
+            REQUIRE(tracker.species("__rnapol_rbs") == (site.covered ? 0 : 1));
+        }
+    }
+    // The registered Transcript object was replaced
+    REQUIRE(transcript->num_attached() == 0);
+
+    auto with_genome = std::make_shared<Model>(8e-16);
+    auto genome = std::make_shared<Genome>("phage", 100);
+    genome->AddPromoter("p1", 1, 10, {{"rnapol", 2e8}});
+    with_genome->AddPolymerase("rnapol", 10, 30, 10);
+    with_genome->RegisterGenome(genome);
+    with_genome->EnableTranslationEngine();
+    REQUIRE_THROWS_AS(with_genome->Initialize(), std::invalid_argument);
+}
+
+namespace {
+
+// Kills the first worker process that reaches time 10 in any replicate
+struct CrashingObserver : public Observer {
+    explicit CrashingObserver(const std::string &marker) : marker(marker) {}
+    void OnSample(double time) override {
+        if (time >= 10 &&
+            open(marker.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644) >= 0) {
+            std::raise(SIGKILL);
+        }
+    }
+    std::string marker;
+};
+
+}  // namespace
+
+TEST_CASE("Simulate ensemble")
+{
+    // Each replicate matches a single run of a fresh model with its seed
+    std::vector<int> seeds = {3, 4, 5};
+    std::map<int, std::string> expected;
+    for (int seed : seeds) {
+        CacheTestModel(seed, 2e8)->Simulate(20, 5, "ensemble_test_single.tsv");
+        expected[seed] = ReadFile("ensemble_test_single.tsv");
+    }
+    auto sim = CacheTestModel(3, 2e8);
+    auto report = sim->SimulateEnsemble(seeds, 20, 5, "ensemble_test.tsv", 2);
+    REQUIRE(report.failed.empty());
+    std::sort(report.completed.begin(), report.completed.end());
+    REQUIRE(report.completed == seeds);
+    // The model itself has not advanced
+    REQUIRE(sim->time() == 0);
+
+    std::ifstream ensemble("ensemble_test.tsv");
+    std::string line;
+    std::getline(ensemble, line);
+    REQUIRE(line == "seed\ttime\tspecies\tprotein\ttranscript\tribo_density");
+    std::map<int, std::string> rows;
+    for (int seed : seeds) {
+        rows[seed] = "time\tspecies\tprotein\ttranscript\tribo_density\n";
+    }
+    while (std::getline(ensemble, line)) {
+        auto tab = line.find('\t');
+        rows[std::stoi(line.substr(0, tab))] += line.substr(tab + 1) + "\n";
+    }
+    REQUIRE(rows == expected);
+
+    // A crashed worker does not stop the other replicates
+    std::string marker = "ensemble_test_crashed";
+    std::remove(marker.c_str());
+    auto crashing = CacheTestModel(3, 2e8);
+    crashing->AddObserver(std::make_shared<CrashingObserver>(marker));
+    report = crashing->SimulateEnsemble({1, 2, 3, 4}, 20, 5,
+                                        "ensemble_test.tsv", 2);
+    REQUIRE(report.completed.size() == 3);
+    REQUIRE(report.failed.size() == 1);
+    REQUIRE(report.errors[0] == "Worker killed by signal 9.");
+
+    // Errors in a replicate are reported with their message
+    auto stalled = std::make_shared<Model>(8e-16);
+    stalled->AddSpecies("X", 1);
+    stalled->AddReaction(1.0, {"X"}, {"Y"});
+    report = stalled->SimulateEnsemble({1, 2}, 20, 5, "ensemble_test.tsv", 4);
+    REQUIRE(report.completed.empty());
+    REQUIRE(report.failed.size() == 2);
+    REQUIRE(report.errors[1].find("Propensity of system is 0") !=
+            std::string::npos);
+
+    REQUIRE_THROWS_AS(stalled->SimulateEnsemble({1}, 20, 5,
+                                                "ensemble_test.tsv", 0),
+                      std::invalid_argument);
+    std::remove(marker.c_str());
+    std::remove("ensemble_test.tsv");
+    std::remove("ensemble_test_single.tsv");
+}
+
+namespace {
+
+// Records the count of a species after each reaction
+struct CountRecorder : public Observer {
+    explicit CountRecorder(const std::string &name) : name(name) {}
+    void OnReaction(double time, const Reaction &reaction) override {
+        changes.emplace_back(time, SpeciesTracker::Instance().species(name));
+    }
+    std::string name;
+    std::vector<std::pair<double, int>> changes;
+};
+
+}  // namespace
+
+TEST_CASE("Time averages")
+{
+    auto sim = std::make_shared<Model>(8e-16);
+    sim->seed(8);
+    sim->AddSpecies("X", 100);
+    sim->AddReaction(1.0, {"X"}, {"Y"});
+    sim->AddReaction(1.0, {"Y"}, {"X"});
+    auto recorder = std::make_shared<CountRecorder>("X");
+    sim->AddObserver(recorder);
+    sim->EnableTimeAverages(true);
+    sim->Simulate(20, 5, "averages_test.tsv");
+
+    std::ifstream counts("averages_test.tsv");
+    std::string line;
+    std::getline(counts, line);
+    REQUIRE(line ==
+            "time\tspecies\tprotein\ttranscript\tribo_density\tprotein_min\t"
+            "protein_max\ttranscript_min\ttranscript_max\tribo_density_min\t"
+            "ribo_density_max");
+    // Integrate the recorded counts of X over each output interval
+    double last_time = 0;
+    int count = 100;
+    std::size_t next = 0;
+    int rows = 0;
+    while (std::getline(counts, line)) {
+        std::istringstream row(line);
+        double time, mean, transcript, density, min, max;
+        std::string name;
+        row >> time >> name >> mean >> transcript >> density >> min >> max;
+        if (name != "X") {
+            continue;
+        }
+        double area = 0;
+        double since = last_time;
+        int lowest = count;
+        int highest = count;
+        while (next < recorder->changes.size() &&
+               recorder->changes[next].first <= time) {
+            area += count * (recorder->changes[next].first - since);
+            since = recorder->changes[next].first;
+            count = recorder->changes[next].second;
+            lowest = std::min(lowest, count);
+            highest = std::max(highest, count);
+            next++;
+        }
+        area += count * (time - since);
+        double expected = time > last_time ? area / (time - last_time) : count;
+        REQUIRE(mean == Approx(expected).epsilon(1e-4));
+        REQUIRE(min == lowest);
+        REQUIRE(max == highest);
+        REQUIRE(min <= mean);
+        REQUIRE(mean <= max);
+        last_time = time;
+        rows++;
+    }
+    REQUIRE(rows == 4);
+    REQUIRE(next > 100);
+
+    REQUIRE_THROWS_AS(sim->EnableTimeAverages(), std::runtime_error);
+    std::remove("averages_test.tsv");
+}